@@ -0,0 +1,382 @@
+#include "include/alloccounter.h"
+#include <new>
+#include <stdlib.h>
+#include <stdio.h>
+#include <atomic>
+
+#ifdef PMC_ALLOC_TRACKING
+#ifdef _MSC_VER
+#include <intrin.h>
+#define PMC_RETURN_ADDRESS() _ReturnAddress()
+#else
+#define PMC_RETURN_ADDRESS() __builtin_return_address(0)
+#endif
+// glibc lets the executable replace malloc, the real one is still there under these names
+#ifdef __GLIBC__
+#define PMC_ALLOC_TRACK_MALLOC
+#include <dlfcn.h>
+#include <cxxabi.h>
+extern "C" void* __libc_malloc(size_t cb);
+extern "C" void* __libc_calloc(size_t cElements, size_t cbElement);
+extern "C" void* __libc_realloc(void *p, size_t cb);
+extern "C" void __libc_free(void *p);
+#endif
+#endif
+
+using namespace XplatGameTutorial::PacManClone;
+
+static thread_local Uint64 s_cThreadAllocations = 0;
+static std::atomic<Uint64> s_cProcessAllocations(0);     // Constant initialized, new runs before any constructor
+
+Uint64 AllocationCounter::ThreadCount()
+{
+    return s_cThreadAllocations;
+}
+
+Uint64 AllocationCounter::ProcessCount()
+{
+    return s_cProcessAllocations.load(std::memory_order_relaxed);
+}
+
+// With malloc itself replaced, operator new has to go straight to the real one or everything counts twice
+static void* RawAllocate(size_t cb)
+{
+#ifdef PMC_ALLOC_TRACK_MALLOC
+    return __libc_malloc(cb);
+#else
+    return malloc(cb);
+#endif
+}
+
+static void RawFree(void *p)
+{
+#ifdef PMC_ALLOC_TRACK_MALLOC
+    __libc_free(p);
+#else
+    free(p);
+#endif
+}
+
+#ifdef PMC_ALLOC_TRACKING
+namespace
+{
+    struct PhaseTotals
+    {
+        const char *szName;
+        bool fNoAlloc;
+        Uint64 cAllocations;
+        Uint64 cBytes;
+    };
+
+    struct CallSite
+    {
+        const void *pAddress;                   // nullptr - free slot
+        Uint32 phaseIndex;
+        Uint64 cAllocations;
+        Uint64 cBytes;
+    };
+
+    const Uint32 c_maxProbes = 16;
+    const Uint32 c_reportSites = 25;
+
+    // Static storage only - these are live before any constructor runs, the loader allocates too
+    PhaseTotals s_phases[AllocationTracker::c_maxPhases] = { { "(no phase)", false, 0, 0 } };
+    Uint32 s_cPhases = 1;
+    CallSite s_callSites[AllocationTracker::c_callSiteSlots];
+    Uint64 s_cUntrackedSites;                   // Allocations whose site didn't fit in the table
+    std::atomic_flag s_lock = ATOMIC_FLAG_INIT;
+    thread_local Uint32 t_phaseIndex = 0;
+    thread_local bool t_fAsserting = false;     // The assert handler may allocate too
+
+    class TrackerLock
+    {
+    public:
+        TrackerLock()
+        {
+            while (s_lock.test_and_set(std::memory_order_acquire))
+            {
+            }
+        }
+
+        ~TrackerLock()
+        {
+            s_lock.clear(std::memory_order_release);
+        }
+    };
+
+    void Track(size_t cb, const void *pCaller)
+    {
+        Uint32 phaseIndex = t_phaseIndex;
+        bool fNoAlloc = false;
+        {
+            TrackerLock lock;
+            PhaseTotals &phase = s_phases[phaseIndex];
+            phase.cAllocations++;
+            phase.cBytes += cb;
+            fNoAlloc = phase.fNoAlloc;
+
+            // Open addressing on the address and phase together, a site shows up once per phase it allocates in
+            size_t hash = ((reinterpret_cast<size_t>(pCaller) >> 2) ^ (phaseIndex * 0x9E3779B9u)) * 0x85EBCA6Bu;
+            Uint32 probe = 0;
+            for (; probe < c_maxProbes; probe++)
+            {
+                CallSite &site = s_callSites[(hash + probe) & (AllocationTracker::c_callSiteSlots - 1)];
+                if (site.pAddress == nullptr)
+                {
+                    site.pAddress = pCaller;
+                    site.phaseIndex = phaseIndex;
+                }
+                if ((site.pAddress == pCaller) && (site.phaseIndex == phaseIndex))
+                {
+                    site.cAllocations++;
+                    site.cBytes += cb;
+                    break;
+                }
+            }
+            if (probe == c_maxProbes)
+            {
+                s_cUntrackedSites++;
+            }
+        }
+
+        // Outside the lock, reporting allocates
+        if (fNoAlloc && !t_fAsserting)
+        {
+            t_fAsserting = true;
+            printf("Allocated %llu bytes from %p in phase %s, which must not allocate\n", static_cast<unsigned long long>(cb),
+                pCaller, s_phases[phaseIndex].szName);
+            SDL_assert(!"Allocation in a no allocation phase");
+            t_fAsserting = false;
+        }
+    }
+
+    void PrintSymbol(const void *pAddress)
+    {
+#ifdef PMC_ALLOC_TRACK_MALLOC
+        Dl_info info;
+        if ((dladdr(pAddress, &info) != 0) && (info.dli_fname != nullptr))
+        {
+            if (info.dli_sname != nullptr)
+            {
+                int status = 0;
+                char *szDemangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+                printf("%s+0x%llx", (szDemangled != nullptr) ? szDemangled : info.dli_sname,
+                    static_cast<unsigned long long>(static_cast<const char*>(pAddress) - static_cast<const char*>(info.dli_saddr)));
+                free(szDemangled);
+            }
+            else
+            {
+                // Module relative, for addr2line -fCe <module> <offset>
+                printf("%s+0x%llx", info.dli_fname,
+                    static_cast<unsigned long long>(static_cast<const char*>(pAddress) - static_cast<const char*>(info.dli_fbase)));
+            }
+            return;
+        }
+#endif
+        printf("%p", pAddress);
+    }
+}
+
+bool AllocationTracker::IsCompiledIn()
+{
+    return true;
+}
+
+Uint32 AllocationTracker::RegisterPhase(const char *szName, bool fNoAlloc)
+{
+    TrackerLock lock;
+    for (Uint32 index = 1; index < s_cPhases; index++)
+    {
+        if ((s_phases[index].szName == szName) || (SDL_strcmp(s_phases[index].szName, szName) == 0))
+        {
+            s_phases[index].fNoAlloc |= fNoAlloc;
+            return index;
+        }
+    }
+
+    if (s_cPhases == c_maxPhases)
+    {
+        return 0;
+    }
+    s_phases[s_cPhases].szName = szName;
+    s_phases[s_cPhases].fNoAlloc = fNoAlloc;
+    return s_cPhases++;
+}
+
+Uint32 AllocationTracker::CurrentPhase()
+{
+    return t_phaseIndex;
+}
+
+void AllocationTracker::SetCurrentPhase(Uint32 phaseIndex)
+{
+    t_phaseIndex = phaseIndex;
+}
+
+void AllocationTracker::PrintReport()
+{
+    // Copied out first, printing allocates and would wait on the lock forever
+    static PhaseTotals s_reportPhases[c_maxPhases];
+    static CallSite s_reportCallSites[c_callSiteSlots];
+    Uint32 cPhases = 0;
+    Uint64 cUntrackedSites = 0;
+    {
+        TrackerLock lock;
+        SDL_memcpy(s_reportPhases, s_phases, sizeof(s_phases));
+        SDL_memcpy(s_reportCallSites, s_callSites, sizeof(s_callSites));
+        cPhases = s_cPhases;
+        cUntrackedSites = s_cUntrackedSites;
+    }
+
+    printf("Allocations by phase:\n");
+    for (Uint32 index = 0; index < cPhases; index++)
+    {
+        const PhaseTotals &phase = s_reportPhases[index];
+        printf("  %-24s %12llu allocations %14llu bytes%s\n", phase.szName, static_cast<unsigned long long>(phase.cAllocations),
+            static_cast<unsigned long long>(phase.cBytes), phase.fNoAlloc ? "  (must not allocate)" : "");
+    }
+
+    // Busiest first, each one taken is zeroed so the next pass finds the one after
+    printf("Top allocation call sites:\n");
+    for (Uint32 rank = 0; rank < c_reportSites; rank++)
+    {
+        CallSite *pBusiest = nullptr;
+        for (Uint32 slot = 0; slot < c_callSiteSlots; slot++)
+        {
+            CallSite &site = s_reportCallSites[slot];
+            if ((site.cAllocations > 0) && ((pBusiest == nullptr) || (site.cAllocations > pBusiest->cAllocations)))
+            {
+                pBusiest = &site;
+            }
+        }
+        if (pBusiest == nullptr)
+        {
+            break;
+        }
+
+        printf("  %10llu allocations %12llu bytes  %-16s ", static_cast<unsigned long long>(pBusiest->cAllocations),
+            static_cast<unsigned long long>(pBusiest->cBytes), s_reportPhases[pBusiest->phaseIndex].szName);
+        PrintSymbol(pBusiest->pAddress);
+        printf("\n");
+        pBusiest->cAllocations = 0;
+    }
+    if (cUntrackedSites > 0)
+    {
+        printf("  %llu allocations from sites that didn't fit the table\n", static_cast<unsigned long long>(cUntrackedSites));
+    }
+}
+
+#ifdef PMC_ALLOC_TRACK_MALLOC
+// Everything else in the process that allocates from the C heap.  free() is left alone, it is the same heap
+extern "C" void* malloc(size_t cb) noexcept
+{
+    Track(cb, PMC_RETURN_ADDRESS());
+    return __libc_malloc(cb);
+}
+
+extern "C" void* calloc(size_t cElements, size_t cbElement) noexcept
+{
+    Track(cElements * cbElement, PMC_RETURN_ADDRESS());
+    return __libc_calloc(cElements, cbElement);
+}
+
+extern "C" void* realloc(void *p, size_t cb) noexcept
+{
+    if (cb != 0)
+    {
+        Track(cb, PMC_RETURN_ADDRESS());
+    }
+    return __libc_realloc(p, cb);
+}
+#endif
+
+#define PMC_TRACK_ALLOCATION(cb) Track(cb, PMC_RETURN_ADDRESS())
+#else
+bool AllocationTracker::IsCompiledIn()
+{
+    return false;
+}
+
+Uint32 AllocationTracker::RegisterPhase(const char *, bool)
+{
+    return 0;
+}
+
+Uint32 AllocationTracker::CurrentPhase()
+{
+    return 0;
+}
+
+void AllocationTracker::SetCurrentPhase(Uint32)
+{
+}
+
+void AllocationTracker::PrintReport()
+{
+}
+
+#define PMC_TRACK_ALLOCATION(cb)
+#endif
+
+// Every flavor of new counts itself, so in the tracking build each one sees its own caller
+static void* CountedAllocate(size_t cb)
+{
+    s_cThreadAllocations++;
+    s_cProcessAllocations.fetch_add(1, std::memory_order_relaxed);
+    // malloc(0) may return nullptr, new never does
+    return RawAllocate((cb != 0) ? cb : 1);
+}
+
+void* operator new(size_t cb)
+{
+    PMC_TRACK_ALLOCATION(cb);
+    void *p = CountedAllocate(cb);
+    if (p == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new[](size_t cb)
+{
+    PMC_TRACK_ALLOCATION(cb);
+    void *p = CountedAllocate(cb);
+    if (p == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new(size_t cb, const std::nothrow_t&) noexcept
+{
+    PMC_TRACK_ALLOCATION(cb);
+    return CountedAllocate(cb);
+}
+
+void* operator new[](size_t cb, const std::nothrow_t&) noexcept
+{
+    PMC_TRACK_ALLOCATION(cb);
+    return CountedAllocate(cb);
+}
+
+void operator delete(void *p) noexcept
+{
+    RawFree(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    RawFree(p);
+}
+
+void operator delete(void *p, const std::nothrow_t&) noexcept
+{
+    RawFree(p);
+}
+
+void operator delete[](void *p, const std::nothrow_t&) noexcept
+{
+    RawFree(p);
+}
@@ -0,0 +1,78 @@
+#include "include/animationlibrary.h"
+#include "include/constants.h"
+#include "include/log.h"
+
+using namespace XplatGameTutorial::PacManClone;
+
+bool AnimationSet::FitsTexture(TextureWrapper *pTextureWrapper) const
+{
+    SDL_assert((pTextureWrapper != nullptr) && (!pTextureWrapper->IsNull()));
+    for (Uint16 index = 0; index < cFrames; index++)
+    {
+        const SDL_Rect &frame = frames[index];
+        if ((frame.x + frame.w > pTextureWrapper->Width()) || (frame.y + frame.h > pTextureWrapper->Height()))
+        {
+            PMC_LOG_ERROR(LogCategory::Assets, "AnimationSet : frame bounds out of range {x:%d y:%d w:%d h:%d} for a %dx%d texture",
+                frame.x, frame.y, frame.w, frame.h, pTextureWrapper->Width(), pTextureWrapper->Height());
+            return false;
+        }
+    }
+    return true;
+}
+
+// Function local so it is built exactly once, on first use, even with sessions on several threads
+const AnimationLibrary& AnimationLibrary::Get()
+{
+    static const AnimationLibrary s_library;
+    return s_library;
+}
+
+// Load a series of frames assumed to be in horizontal order starting at the given index/coord
+// This takes advantage of how I know the sprite textures are laid out (which is not uncommon)
+void AnimationLibrary::LoadFrames(AnimationSet &set, Uint16 indexStart, Uint16 xTextureStart, Uint16 yTextureStart, Uint16 cFramesToLoad)
+{
+    SDL_assert(indexStart + cFramesToLoad <= AnimationSet::c_maxFrames);
+    Uint16 x = xTextureStart;
+    for (Uint16 index = indexStart; index < (indexStart + cFramesToLoad); index++)
+    {
+        set.frames[index] = { x, yTextureStart, set.cxFrame, set.cyFrame };
+        x += set.cxFrame;
+    }
+    set.cFrames = SDL_max(set.cFrames, static_cast<Uint16>(indexStart + cFramesToLoad));
+}
+
+void AnimationLibrary::LoadSequence(AnimationSet &set, Uint16 index, AnimationType animationType, const int *pSequence, Uint16 cFrames, Uint16 speed)
+{
+    SDL_assert(index < AnimationSet::c_maxSequences);
+    SDL_assert((cFrames > 0) && (speed > 0));
+    set.sequences[index] = { pSequence, cFrames, speed, animationType };
+    set.cSequences = SDL_max(set.cSequences, static_cast<Uint16>(index + 1));
+}
+
+AnimationLibrary::AnimationLibrary()
+{
+    SDL_memset(&_player, 0, sizeof(_player));
+    _player.cxFrame = Constants::PlayerSpriteWidth;
+    _player.cyFrame = Constants::PlayerSpriteHeight;
+    _player.xFrameOffset = 1 - (Constants::PlayerSpriteWidth / 2);
+    _player.yFrameOffset = 1 - (Constants::PlayerSpriteHeight / 2);
+    LoadFrames(_player, 0, 0, 0, 10);
+    LoadFrames(_player, 10, 0, Constants::PlayerSpriteHeight, 10);
+    LoadSequence(_player, Constants::AnimationIndexLeft, AnimationType::Loop, Constants::PlayerAnimation_LEFT, Constants::PlayerAnimationFrameCount, Constants::PlayerAnimationSpeed);
+    LoadSequence(_player, Constants::AnimationIndexRight, AnimationType::Loop, Constants::PlayerAnimation_RIGHT, Constants::PlayerAnimationFrameCount, Constants::PlayerAnimationSpeed);
+    LoadSequence(_player, Constants::AnimationIndexUp, AnimationType::Loop, Constants::PlayerAnimation_UP, Constants::PlayerAnimationFrameCount, Constants::PlayerAnimationSpeed);
+    LoadSequence(_player, Constants::AnimationIndexDown, AnimationType::Loop, Constants::PlayerAnimation_DOWN, Constants::PlayerAnimationFrameCount, Constants::PlayerAnimationSpeed);
+    LoadSequence(_player, Constants::AnimationIndexDeath, AnimationType::Once, Constants::PlayerAnimation_DEATH, Constants::PlayerAnimationDeathFrameCount, Constants::PlayerAnimationSpeed);
+
+    // Each ghost has its own row of frames on the texture
+    SDL_memset(&_blinky, 0, sizeof(_blinky));
+    _blinky.cxFrame = Constants::GhostSpriteWidth;
+    _blinky.cyFrame = Constants::GhostSpriteHeight;
+    _blinky.xFrameOffset = 1 - (Constants::GhostSpriteWidth / 2);
+    _blinky.yFrameOffset = 1 - (Constants::GhostSpriteHeight / 2);
+    LoadFrames(_blinky, 0, 0, 64, Constants::GhostTotalFrameCount);
+    LoadSequence(_blinky, Constants::AnimationIndexLeft, AnimationType::Loop, Constants::GhostAnimation_LEFT, Constants::GhostMovingAnimationFrameCount, Constants::GhostAnimationSpeed);
+    LoadSequence(_blinky, Constants::AnimationIndexRight, AnimationType::Loop, Constants::GhostAnimation_RIGHT, Constants::GhostMovingAnimationFrameCount, Constants::GhostAnimationSpeed);
+    LoadSequence(_blinky, Constants::AnimationIndexUp, AnimationType::Loop, Constants::GhostAnimation_UP, Constants::GhostMovingAnimationFrameCount, Constants::GhostAnimationSpeed);
+    LoadSequence(_blinky, Constants::AnimationIndexDown, AnimationType::Loop, Constants::GhostAnimation_DOWN, Constants::GhostMovingAnimationFrameCount, Constants::GhostAnimationSpeed);
+}
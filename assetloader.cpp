@@ -0,0 +1,171 @@
+#include "include/assetloader.h"
+#include "include/log.h"
+
+using namespace XplatGameTutorial::PacManClone;
+
+static double CounterToMs(Uint64 counterDelta)
+{
+    return (counterDelta * 1000.0) / SDL_GetPerformanceFrequency();
+}
+
+AssetLoader::AssetLoader() :
+    _cAssets(0),
+    _nextAsset(0),
+    _cFinished(0),
+    _cWorkers(0),
+    _startCounter(0),
+    _endCounter(0),
+    _msDecodeWall(0.0)
+{
+    SDL_memset(_assets, 0, sizeof(_assets));
+}
+
+AssetLoader::~AssetLoader()
+{
+    WaitForDecode();
+    for (int i = 0; i < _cAssets; i++)
+    {
+        if (_assets[i].pSurface != nullptr)
+        {
+            SDL_FreeSurface(_assets[i].pSurface);
+            _assets[i].pSurface = nullptr;
+        }
+    }
+}
+
+int AssetLoader::Add(const char *szFileName, const SDL_Color *pColorKey)
+{
+    SDL_assert(_cWorkers == 0);
+    if (_cAssets == c_maxAssets)
+    {
+        PMC_LOG_ERROR(LogCategory::Assets, "AssetLoader: too many assets, %s not added", szFileName);
+        return -1;
+    }
+
+    Asset &asset = _assets[_cAssets];
+    asset.pszFileName = szFileName;
+    asset.fColorKey = (pColorKey != nullptr);
+    if (asset.fColorKey)
+    {
+        asset.colorKey = *pColorKey;
+    }
+    return _cAssets++;
+}
+
+// IMG_Init isn't thread safe, so the codecs needed by the asset list are started here on the calling
+// thread before any worker runs.  Formats nobody asked for are never loaded
+bool AssetLoader::InitializeCodecs()
+{
+    int flagsNeeded = 0;
+    for (int i = 0; i < _cAssets; i++)
+    {
+        const char *pszExtension = SDL_strrchr(_assets[i].pszFileName, '.');
+        if (pszExtension == nullptr)
+        {
+            continue;
+        }
+        if (SDL_strcasecmp(pszExtension, ".png") == 0)
+        {
+            flagsNeeded |= IMG_INIT_PNG;
+        }
+        else if ((SDL_strcasecmp(pszExtension, ".jpg") == 0) || (SDL_strcasecmp(pszExtension, ".jpeg") == 0))
+        {
+            flagsNeeded |= IMG_INIT_JPG;
+        }
+    }
+
+    bool fResult = true;
+    if ((flagsNeeded != 0) && ((IMG_Init(flagsNeeded) & flagsNeeded) != flagsNeeded))
+    {
+        PMC_LOG_ERROR(LogCategory::Assets, "IMG_Init() failed, error = %s", IMG_GetError());
+        fResult = false;
+    }
+    return fResult;
+}
+
+bool AssetLoader::StartDecode()
+{
+    SDL_assert(_cWorkers == 0);
+    _startCounter = SDL_GetPerformanceCounter();
+    if (!InitializeCodecs())
+    {
+        return false;
+    }
+
+    // One worker per core is plenty, decode is CPU bound
+    int cWorkers = SDL_min(_cAssets, SDL_max(SDL_GetCPUCount(), 1));
+    _nextAsset = 0;
+    _cFinished = 0;
+    for (_cWorkers = 0; _cWorkers < cWorkers; _cWorkers++)
+    {
+        _workers[_cWorkers] = std::thread(&AssetLoader::WorkerThread, this);
+    }
+    return true;
+}
+
+void AssetLoader::WaitForDecode()
+{
+    if (_cWorkers == 0)
+    {
+        return;
+    }
+    for (int i = 0; i < _cWorkers; i++)
+    {
+        _workers[i].join();
+    }
+    _cWorkers = 0;
+    _msDecodeWall = CounterToMs(_endCounter - _startCounter);
+}
+
+void AssetLoader::WorkerThread()
+{
+    for (int index = _nextAsset++; index < _cAssets; index = _nextAsset++)
+    {
+        Decode(&_assets[index]);
+        // The wall time ends with the last decode, not whenever the main thread gets round to joining
+        if (++_cFinished == _cAssets)
+        {
+            _endCounter = SDL_GetPerformanceCounter();
+        }
+    }
+}
+
+void AssetLoader::Decode(Asset *pAsset)
+{
+    Uint64 startCounter = SDL_GetPerformanceCounter();
+    pAsset->pSurface = IMG_Load(pAsset->pszFileName);
+    if (pAsset->pSurface == nullptr)
+    {
+        PMC_LOG_ERROR(LogCategory::Assets, "IMG_Load(%s) failed, error = %s", pAsset->pszFileName, IMG_GetError());
+    }
+    else if (pAsset->fColorKey)
+    {
+        SDL_SetColorKey(pAsset->pSurface, SDL_TRUE, SDL_MapRGB(pAsset->pSurface->format,
+            pAsset->colorKey.r, pAsset->colorKey.g, pAsset->colorKey.b));
+    }
+    pAsset->msDecode = CounterToMs(SDL_GetPerformanceCounter() - startCounter);
+}
+
+TextureWrapper* AssetLoader::CreateTexture(int index, SDL_Renderer *pSDLRenderer)
+{
+    SDL_assert(_cWorkers == 0);
+    if ((index < 0) || (index >= _cAssets) || (_assets[index].pSurface == nullptr))
+    {
+        return nullptr;
+    }
+
+    Asset &asset = _assets[index];
+    TextureWrapper *pTexture = new TextureWrapper(asset.pszFileName, SDL_strlen(asset.pszFileName), pSDLRenderer, asset.pSurface);
+    SDL_FreeSurface(asset.pSurface);
+    asset.pSurface = nullptr;
+    return pTexture;
+}
+
+void AssetLoader::PrintDecodeTimes()
+{
+    printf("  decode: %.2fms wall on %d assets\n", _msDecodeWall, _cAssets);
+    for (int i = 0; i < _cAssets; i++)
+    {
+        printf("    %-32s %.2fms\n", _assets[i].pszFileName, _assets[i].msDecode);
+    }
+}
@@ -0,0 +1,401 @@
+#include "include/assetpack.h"
+#include "include/log.h"
+#include "SDL_image.h"
+#include "include/constants.h"
+#include "include/statehash.h"
+#include <string.h>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace XplatGameTutorial::PacManClone;
+
+AssetPack::AssetPack() :
+    _pData(nullptr),
+    _cbData(0),
+    _pEntries(nullptr),
+    _cEntries(0)
+{
+}
+
+AssetPack::~AssetPack()
+{
+    Close();
+}
+
+// Decode one image into the pack's pixel format.  Pixels matching the color key become fully transparent,
+// which is what SDL_SetColorKey would otherwise do at load time.  pfAlpha says whether the image ends up with
+// any transparency, the same test SDL_CreateTextureFromSurface uses to turn on blending
+static SDL_Surface* BakeImage(const char *szFileName, const SDL_Color *pColorKey, bool *pfAlpha)
+{
+    SDL_Surface *pLoaded = IMG_Load(szFileName);
+    if (pLoaded == nullptr)
+    {
+        PMC_LOG_ERROR(LogCategory::Assets, "IMG_Load(%s) failed, error = %s", szFileName, IMG_GetError());
+        return nullptr;
+    }
+
+    *pfAlpha = (pColorKey != nullptr) || (pLoaded->format->Amask != 0);
+    SDL_Surface *pBaked = SDL_ConvertSurfaceFormat(pLoaded, AssetPack::c_pixelFormat, 0);
+    SDL_FreeSurface(pLoaded);
+    if (pBaked == nullptr)
+    {
+        PMC_LOG_ERROR(LogCategory::Assets, "SDL_ConvertSurfaceFormat(%s) failed, error = %s", szFileName, SDL_GetError());
+        return nullptr;
+    }
+
+    if (pColorKey != nullptr)
+    {
+        Uint32 key = SDL_MapRGB(pBaked->format, pColorKey->r, pColorKey->g, pColorKey->b) & ~pBaked->format->Amask;
+        for (int y = 0; y < pBaked->h; y++)
+        {
+            Uint32 *pRow = reinterpret_cast<Uint32*>(static_cast<Uint8*>(pBaked->pixels) + y * pBaked->pitch);
+            for (int x = 0; x < pBaked->w; x++)
+            {
+                if ((pRow[x] & ~pBaked->format->Amask) == key)
+                {
+                    pRow[x] = 0;
+                }
+            }
+        }
+    }
+    return pBaked;
+}
+
+// Everything Build() bakes from: the image files as they are on disk, their color keys, the level and the
+// atlas layout.  Reading the compressed images is a small part of what decoding them costs.  False if an
+// image can't be read
+bool AssetPack::HashSources(Uint64 *pHash)
+{
+    StateHasher hasher;
+    for (Uint16 index = 0; index < Constants::TextureAssetCount; index++)
+    {
+        const Constants::TextureAsset &asset = Constants::TextureAssets[index];
+        FILE *pFile = fopen(asset.pszFileName, "rb");
+        if (pFile == nullptr)
+        {
+            return false;
+        }
+
+        Uint8 buffer[4096];
+        Uint64 cbTotal = 0;
+        size_t cbRead = 0;
+        while ((cbRead = fread(buffer, 1, sizeof(buffer), pFile)) > 0)
+        {
+            for (size_t offset = 0; offset < cbRead; offset += sizeof(Uint64))
+            {
+                Uint64 word = 0;
+                SDL_memcpy(&word, buffer + offset, SDL_min(sizeof(Uint64), cbRead - offset));
+                hasher.Add(word);
+            }
+            cbTotal += cbRead;
+        }
+        fclose(pFile);
+        hasher.Add(cbTotal);
+
+        const SDL_Color *pColorKey = asset.pColorKey;
+        hasher.Add((pColorKey != nullptr) ? ((1ull << 32) | (pColorKey->r << 16) | (pColorKey->g << 8) | pColorKey->b) : 0);
+    }
+
+    for (size_t index = 0; index < SDL_arraysize(Constants::MapIndicies); index++)
+    {
+        hasher.Add(Constants::MapIndicies[index]);
+    }
+    hasher.Add((static_cast<Uint64>(Constants::MapRows) << 32) | Constants::MapCols);
+    hasher.Add((static_cast<Uint64>(Constants::TileTextureWidth) << 48) | (static_cast<Uint64>(Constants::TileTextureHeight) << 32) |
+        (static_cast<Uint64>(Constants::TileWidth) << 16) | Constants::TileHeight);
+    *pHash = hasher.Value();
+    return true;
+}
+
+bool AssetPack::Build(const char *szFileName)
+{
+    struct Source
+    {
+        Entry entry;
+        const void *pData;
+    };
+    std::vector<Source> sources;
+    std::vector<SDL_Surface*> surfaces;
+    bool fResult = true;
+
+    // Same flags the loader would have asked for, the pack replaces the decode not the images
+    if ((IMG_Init(IMG_INIT_PNG) & IMG_INIT_PNG) != IMG_INIT_PNG)
+    {
+        PMC_LOG_ERROR(LogCategory::Assets, "IMG_Init() failed, error = %s", IMG_GetError());
+        return false;
+    }
+
+    auto AddEntry = [&sources](const char *szName, EntryType type, const void *pData, Uint32 cbData, Uint32 width, Uint32 height)
+    {
+        Source source;
+        SDL_memset(&source, 0, sizeof(source));
+        SDL_strlcpy(source.entry.szName, szName, SDL_arraysize(source.entry.szName));
+        source.entry.type = static_cast<Uint32>(type);
+        source.entry.cbData = cbData;
+        source.entry.width = width;
+        source.entry.height = height;
+        source.pData = pData;
+        sources.push_back(source);
+        return &sources.back().entry;
+    };
+
+    for (Uint16 index = 0; fResult && (index < Constants::TextureAssetCount); index++)
+    {
+        const Constants::TextureAsset &asset = Constants::TextureAssets[index];
+        bool fAlpha = false;
+        SDL_Surface *pSurface = BakeImage(asset.pszFileName, asset.pColorKey, &fAlpha);
+        if (pSurface == nullptr)
+        {
+            fResult = false;
+            break;
+        }
+        surfaces.push_back(pSurface);
+        Entry *pEntry = AddEntry(asset.pszId, EntryType::Texture, pSurface->pixels,
+            pSurface->pitch * pSurface->h, pSurface->w, pSurface->h);
+        pEntry->pitch = pSurface->pitch;
+        pEntry->format = c_pixelFormat;
+        pEntry->flags = fAlpha ? c_flagAlpha : 0;
+    }
+
+    TileAtlasInfo tileAtlas = { Constants::TileTextureWidth, Constants::TileTextureHeight, Constants::TileWidth, Constants::TileHeight };
+    AddEntry("tiles.atlas", EntryType::TileAtlas, &tileAtlas, sizeof(tileAtlas), 0, 0);
+    AddEntry("level1", EntryType::LevelTiles, Constants::MapIndicies, sizeof(Constants::MapIndicies), Constants::MapCols, Constants::MapRows);
+
+    Uint64 sourceHash = 0;
+    if (fResult && !HashSources(&sourceHash))
+    {
+        PMC_LOG_ERROR(LogCategory::Assets, "AssetPack::Build() : unable to read the images back to hash them");
+        fResult = false;
+    }
+
+    if (fResult)
+    {
+        // Lay the payloads out after the table of contents
+        Uint32 offset = static_cast<Uint32>(sizeof(Header) + sources.size() * sizeof(Entry));
+        for (Source &source : sources)
+        {
+            offset = (offset + c_alignment - 1) & ~(c_alignment - 1);
+            source.entry.offset = offset;
+            offset += source.entry.cbData;
+        }
+
+        FILE *pFile = fopen(szFileName, "wb");
+        if (pFile == nullptr)
+        {
+            PMC_LOG_ERROR(LogCategory::Assets, "AssetPack::Build() : unable to open %s", szFileName);
+            fResult = false;
+        }
+        else
+        {
+            Header header = { c_magic, c_version, static_cast<Uint32>(sources.size()), 0, sourceHash };
+            fResult = (fwrite(&header, sizeof(header), 1, pFile) == 1);
+            for (size_t index = 0; fResult && (index < sources.size()); index++)
+            {
+                fResult = (fwrite(&sources[index].entry, sizeof(Entry), 1, pFile) == 1);
+            }
+
+            const Uint8 padding[c_alignment] = { 0 };
+            for (size_t index = 0; fResult && (index < sources.size()); index++)
+            {
+                const Entry &entry = sources[index].entry;
+                long cbPadding = static_cast<long>(entry.offset) - ftell(pFile);
+                fResult = (fwrite(padding, 1, cbPadding, pFile) == static_cast<size_t>(cbPadding)) &&
+                    (fwrite(sources[index].pData, 1, entry.cbData, pFile) == entry.cbData);
+                printf("  %-16s %8u bytes @ %u\n", entry.szName, entry.cbData, entry.offset);
+            }
+            fclose(pFile);
+
+            if (fResult)
+            {
+                printf("Wrote asset pack %s (%u entries, %u bytes)\n", szFileName, header.cEntries, offset);
+            }
+            else
+            {
+                PMC_LOG_ERROR(LogCategory::Assets, "AssetPack::Build() : failed writing %s", szFileName);
+            }
+        }
+    }
+
+    for (SDL_Surface *pSurface : surfaces)
+    {
+        SDL_FreeSurface(pSurface);
+    }
+    IMG_Quit();
+    return fResult;
+}
+
+bool AssetPack::Open(const char *szFileName)
+{
+    SDL_assert(_pData == nullptr);
+    void *pMapping = nullptr;
+    size_t cbFile = 0;
+
+#ifdef _WIN32
+    HANDLE hFile = CreateFileA(szFileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (hFile != INVALID_HANDLE_VALUE)
+    {
+        LARGE_INTEGER size;
+        if (GetFileSizeEx(hFile, &size) && (size.QuadPart > 0))
+        {
+            HANDLE hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (hMapping != nullptr)
+            {
+                // The view keeps the mapping alive, the handles aren't needed after this
+                pMapping = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+                cbFile = static_cast<size_t>(size.QuadPart);
+                CloseHandle(hMapping);
+            }
+        }
+        CloseHandle(hFile);
+    }
+#else
+    int fd = open(szFileName, O_RDONLY);
+    if (fd >= 0)
+    {
+        struct stat fileStat;
+        if ((fstat(fd, &fileStat) == 0) && (fileStat.st_size > 0))
+        {
+            cbFile = static_cast<size_t>(fileStat.st_size);
+            pMapping = mmap(nullptr, cbFile, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (pMapping == MAP_FAILED)
+            {
+                pMapping = nullptr;
+            }
+        }
+        close(fd);
+    }
+#endif
+
+    if (pMapping == nullptr)
+    {
+        PMC_LOG_WARNING(LogCategory::Assets, "AssetPack::Open() : unable to map %s", szFileName);
+        return false;
+    }
+
+    _pData = static_cast<const Uint8*>(pMapping);
+    _cbData = cbFile;
+
+    // Check the whole table of contents up front so nothing after this has to worry about bad offsets
+    const Header *pHeader = reinterpret_cast<const Header*>(_pData);
+    bool fValid = (_cbData >= sizeof(Header)) && (pHeader->magic == c_magic) && (pHeader->version == c_version) &&
+        ((_cbData - sizeof(Header)) / sizeof(Entry) >= pHeader->cEntries);
+    if (fValid)
+    {
+        _pEntries = reinterpret_cast<const Entry*>(_pData + sizeof(Header));
+        _cEntries = pHeader->cEntries;
+        for (Uint32 index = 0; fValid && (index < _cEntries); index++)
+        {
+            const Entry &entry = _pEntries[index];
+            fValid = (entry.offset <= _cbData) && (entry.cbData <= _cbData - entry.offset) &&
+                (memchr(entry.szName, '\0', sizeof(entry.szName)) != nullptr);
+        }
+    }
+
+    if (!fValid)
+    {
+        PMC_LOG_ERROR(LogCategory::Assets, "AssetPack::Open() : %s is not a valid asset pack", szFileName);
+        Close();
+        return false;
+    }
+
+    // Images that can't be read can't be newer than the pack either, so only a hash that was worked out and
+    // differs turns it down
+    Uint64 sourceHash = 0;
+    if (HashSources(&sourceHash) && (sourceHash != pHeader->sourceHash))
+    {
+        PMC_LOG_WARNING(LogCategory::Assets, "AssetPack::Open() : %s is out of date with the images or level, "
+            "ignoring it (rebuild it with make pack)", szFileName);
+        Close();
+        return false;
+    }
+
+    PMC_LOG_INFO(LogCategory::Assets, "Mapped asset pack %s (%u entries)", szFileName, _cEntries);
+    return true;
+}
+
+void AssetPack::Close()
+{
+    if (_pData != nullptr)
+    {
+#ifdef _WIN32
+        UnmapViewOfFile(_pData);
+#else
+        munmap(const_cast<Uint8*>(_pData), _cbData);
+#endif
+        _pData = nullptr;
+        _cbData = 0;
+        _pEntries = nullptr;
+        _cEntries = 0;
+    }
+}
+
+const AssetPack::Entry* AssetPack::FindEntry(const char *szName, EntryType type)
+{
+    for (Uint32 index = 0; index < _cEntries; index++)
+    {
+        if ((_pEntries[index].type == static_cast<Uint32>(type)) && (SDL_strcmp(_pEntries[index].szName, szName) == 0))
+        {
+            return &_pEntries[index];
+        }
+    }
+    return nullptr;
+}
+
+const void* AssetPack::Find(const char *szName, EntryType type, Uint32 *pcbData, Uint32 *pWidth, Uint32 *pHeight)
+{
+    const Entry *pEntry = FindEntry(szName, type);
+    if (pEntry == nullptr)
+    {
+        return nullptr;
+    }
+
+    if (pcbData != nullptr)
+    {
+        *pcbData = pEntry->cbData;
+    }
+    if (pWidth != nullptr)
+    {
+        *pWidth = pEntry->width;
+    }
+    if (pHeight != nullptr)
+    {
+        *pHeight = pEntry->height;
+    }
+    return _pData + pEntry->offset;
+}
+
+// The pixels go from the mapping straight into the texture, the only copy is the one the driver makes
+TextureWrapper* AssetPack::CreateTexture(const char *szName, SDL_Renderer *pSDLRenderer)
+{
+    const Entry *pEntry = FindEntry(szName, EntryType::Texture);
+    if ((pEntry == nullptr) || (pEntry->cbData < pEntry->pitch * pEntry->height))
+    {
+        PMC_LOG_ERROR(LogCategory::Assets, "AssetPack::CreateTexture() : no texture %s in the pack", szName);
+        return nullptr;
+    }
+
+    SDL_Texture *pTexture = SDL_CreateTexture(pSDLRenderer, pEntry->format, SDL_TEXTUREACCESS_STATIC, pEntry->width, pEntry->height);
+    if (pTexture == nullptr)
+    {
+        PMC_LOG_ERROR(LogCategory::Assets, "SDL_CreateTexture() failed for %s, error = %s", szName, SDL_GetError());
+    }
+    else if (SDL_UpdateTexture(pTexture, nullptr, _pData + pEntry->offset, pEntry->pitch) != 0)
+    {
+        PMC_LOG_ERROR(LogCategory::Assets, "SDL_UpdateTexture() failed for %s, error = %s", szName, SDL_GetError());
+        SDL_DestroyTexture(pTexture);
+        pTexture = nullptr;
+    }
+    else if ((pEntry->flags & c_flagAlpha) != 0)
+    {
+        SDL_SetTextureBlendMode(pTexture, SDL_BLENDMODE_BLEND);
+    }
+    return new TextureWrapper(szName, SDL_strlen(szName), pTexture);
+}
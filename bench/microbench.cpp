@@ -0,0 +1,421 @@
+// Microbenchmarks for the hot calls in the maze, sprite and ghost code.  Built and run by "make bench",
+// see the makefile.  Each case is a function that does cOps operations and returns something derived
+// from the results, which goes into a volatile so the work can't be optimized away.  The harness sizes
+// the operation count so one repetition takes about c_msTargetRep, runs warmup repetitions, then times
+// the measured ones and reports ns per operation.
+#include "../include/gamesession.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace XplatGameTutorial::PacManClone;
+
+namespace
+{
+    const double c_msTargetRep = 10.0;      // Calibrated length of one repetition
+    const Uint32 c_warmupReps = 3;
+    const Uint32 c_defaultReps = 15;
+    const Uint32 c_maxOpsPerRep = 1u << 30;
+
+    volatile Uint64 s_sink;
+
+    struct BenchResult
+    {
+        const char *szName;
+        Uint32 cOpsPerRep;
+        Uint32 cReps;
+        double nsMin;
+        double nsMedian;
+        double nsMean;
+        double nsStddev;
+        std::vector<double> nsSamples;      // Every timed rep, sorted, for the regression comparator
+    };
+
+    typedef Uint64(*BenchFunction)(Uint32 cOps);
+
+    class MicroBench
+    {
+    public:
+        MicroBench(Uint32 cReps, const char *szFilter) :
+            _cReps(cReps),
+            _szFilter(szFilter),
+            _msPerCount(1000.0 / SDL_GetPerformanceFrequency())
+        {
+        }
+
+        void Run(const char *szName, BenchFunction pfnBench)
+        {
+            if (_szFilter != nullptr && SDL_strstr(szName, _szFilter) == nullptr)
+            {
+                return;
+            }
+
+            // Double the count until a repetition is long enough to time, this also warms the caches
+            Uint32 cOps = 1;
+            while (TimeRep(pfnBench, cOps) < c_msTargetRep / 2 && cOps < c_maxOpsPerRep)
+            {
+                cOps *= 2;
+            }
+            for (Uint32 rep = 0; rep < c_warmupReps; rep++)
+            {
+                TimeRep(pfnBench, cOps);
+            }
+
+            std::vector<double> nsPerOp(_cReps);
+            for (Uint32 rep = 0; rep < _cReps; rep++)
+            {
+                nsPerOp[rep] = TimeRep(pfnBench, cOps) * 1000000.0 / cOps;
+            }
+            std::sort(nsPerOp.begin(), nsPerOp.end());
+
+            BenchResult result = { szName, cOps, _cReps, nsPerOp.front(), 0.0, 0.0, 0.0, nsPerOp };
+            result.nsMedian = (_cReps % 2 == 1) ? nsPerOp[_cReps / 2] : (nsPerOp[_cReps / 2 - 1] + nsPerOp[_cReps / 2]) / 2;
+            for (double ns : nsPerOp)
+            {
+                result.nsMean += ns;
+            }
+            result.nsMean /= _cReps;
+            for (double ns : nsPerOp)
+            {
+                result.nsStddev += (ns - result.nsMean) * (ns - result.nsMean);
+            }
+            result.nsStddev = (_cReps > 1) ? std::sqrt(result.nsStddev / (_cReps - 1)) : 0.0;
+
+            printf("%-40s %12.2f %12.2f %12.2f %10.2f %12u\n", szName, result.nsMin, result.nsMedian, result.nsMean,
+                result.nsStddev, cOps);
+            _results.push_back(result);
+        }
+
+        bool WriteJson(const char *szFileName)
+        {
+            FILE *pFile = fopen(szFileName, "w");
+            if (pFile == nullptr)
+            {
+                printf("Failed to open %s for the results\n", szFileName);
+                return false;
+            }
+
+            fprintf(pFile, "{\"benchmarks\":[\n");
+            for (size_t index = 0; index < _results.size(); index++)
+            {
+                const BenchResult &result = _results[index];
+                fprintf(pFile, "%s{\"name\":\"%s\",\"unit\":\"ns/op\",\"ops_per_rep\":%u,\"reps\":%u,"
+                    "\"min\":%.3f,\"median\":%.3f,\"mean\":%.3f,\"stddev\":%.3f,\"samples\":[",
+                    (index == 0) ? "" : ",\n", result.szName, result.cOpsPerRep, result.cReps, result.nsMin,
+                    result.nsMedian, result.nsMean, result.nsStddev);
+                for (size_t sample = 0; sample < result.nsSamples.size(); sample++)
+                {
+                    fprintf(pFile, "%s%.3f", (sample == 0) ? "" : ",", result.nsSamples[sample]);
+                }
+                fprintf(pFile, "]}");
+            }
+            fprintf(pFile, "\n]}\n");
+
+            bool fResult = (fclose(pFile) == 0);
+            printf("Wrote %u results to %s\n", static_cast<Uint32>(_results.size()), szFileName);
+            return fResult;
+        }
+
+    private:
+        double TimeRep(BenchFunction pfnBench, Uint32 cOps)
+        {
+            Uint64 startCounter = SDL_GetPerformanceCounter();
+            s_sink += pfnBench(cOps);
+            return (SDL_GetPerformanceCounter() - startCounter) * _msPerCount;
+        }
+
+        Uint32 _cReps;
+        const char *_szFilter;
+        double _msPerCount;
+        std::vector<BenchResult> _results;
+    };
+
+    // Opens up the ghost's decision helpers, they are protected in Ghost
+    class BenchBlinky : public Blinky
+    {
+    public:
+        BenchBlinky(TextureWrapper *pTextureWrapper) : Blinky(pTextureWrapper)
+        {
+        }
+
+        Direction BranchDecision(Uint16 row, Uint16 col, Direction arrivingDirection, double xTarget, double yTarget, Maze *pMaze)
+        {
+            return ClosestExit(row, col, arrivingDirection, xTarget, yTarget, pMaze);
+        }
+
+        Direction NextDirection(Uint16 row, Uint16 col, Direction arrivingDirection, Maze *pMaze)
+        {
+            return GetNextDirection(row, col, arrivingDirection, pMaze);
+        }
+    };
+
+    struct Cell
+    {
+        Uint16 row;
+        Uint16 col;
+    };
+
+    // Everything the cases run against, set up once
+    struct BenchWorld
+    {
+        SDL_Renderer *pSDLRenderer;
+        Maze *pMaze;
+        Player *pPlayer;
+        BenchBlinky *pBlinky;
+        std::vector<SDL_Point> points;          // Spread over the whole map
+        std::vector<Cell> openCells;            // Interior, not solid
+        std::vector<Cell> intersections;
+        std::vector<Cell> corridors;            // Not intersections, entered heading left from an open tile
+        std::vector<Sprite*> sprites;
+        Uint32 tickCount;
+    };
+
+    BenchWorld s_world;
+
+    Uint64 BenchGetTileRowCol(Uint32 cOps)
+    {
+        Uint64 sum = 0;
+        size_t cPoints = s_world.points.size();
+        for (Uint32 op = 0; op < cOps; op++)
+        {
+            Uint16 row = 0;
+            Uint16 col = 0;
+            s_world.pMaze->GetTileRowCol(s_world.points[op % cPoints], row, col);
+            sum += row + col;
+        }
+        return sum;
+    }
+
+    Uint64 BenchIsTileIntersection(Uint32 cOps)
+    {
+        Uint64 sum = 0;
+        size_t cCells = s_world.openCells.size();
+        for (Uint32 op = 0; op < cOps; op++)
+        {
+            const Cell &cell = s_world.openCells[op % cCells];
+            sum += s_world.pMaze->IsTileIntersection(cell.row, cell.col);
+        }
+        return sum;
+    }
+
+    Uint64 BenchIsSpritePastCenter(Uint32 cOps)
+    {
+        Uint64 sum = 0;
+        size_t cCells = s_world.openCells.size();
+        for (Uint32 op = 0; op < cOps; op++)
+        {
+            const Cell &cell = s_world.openCells[op % cCells];
+            sum += s_world.pMaze->IsSpritePastCenter(cell.row, cell.col, s_world.pPlayer);
+        }
+        return sum;
+    }
+
+    Uint64 BenchBranchDecision(Uint32 cOps)
+    {
+        Uint64 sum = 0;
+        size_t cCells = s_world.intersections.size();
+        double xTarget = s_world.pPlayer->X();
+        double yTarget = s_world.pPlayer->Y();
+        for (Uint32 op = 0; op < cOps; op++)
+        {
+            const Cell &cell = s_world.intersections[op % cCells];
+            sum += static_cast<Uint64>(s_world.pBlinky->BranchDecision(cell.row, cell.col, Direction::Left, xTarget, yTarget, s_world.pMaze));
+        }
+        return sum;
+    }
+
+    Uint64 BenchNextDirection(Uint32 cOps)
+    {
+        Uint64 sum = 0;
+        size_t cCells = s_world.corridors.size();
+        for (Uint32 op = 0; op < cOps; op++)
+        {
+            const Cell &cell = s_world.corridors[op % cCells];
+            sum += static_cast<Uint64>(s_world.pBlinky->NextDirection(cell.row, cell.col, Direction::Left, s_world.pMaze));
+        }
+        return sum;
+    }
+
+    // A full ghost tick, the clock moves on a fixed step each time like the session's loop
+    Uint64 BenchGhostUpdate(Uint32 cOps)
+    {
+        for (Uint32 op = 0; op < cOps; op++)
+        {
+            s_world.tickCount++;
+            GameClock::Set(s_world.tickCount * Constants::TicksPerFrame, s_world.tickCount);
+            s_world.pBlinky->Update(s_world.pPlayer, s_world.pMaze);
+        }
+        return static_cast<Uint64>(s_world.pBlinky->X() + s_world.pBlinky->Y());
+    }
+
+    Uint64 BenchSpriteUpdate(Uint32 cOps)
+    {
+        size_t cSprites = s_world.sprites.size();
+        for (Uint32 op = 0; op < cOps; op++)
+        {
+            s_world.sprites[op % cSprites]->Update();
+        }
+        return static_cast<Uint64>(s_world.sprites[0]->X());
+    }
+
+    Uint64 BenchMazeRender(Uint32 cOps)
+    {
+        for (Uint32 op = 0; op < cOps; op++)
+        {
+            s_world.pMaze->Render(s_world.pSDLRenderer);
+        }
+        return cOps;
+    }
+
+    void BuildWorld(TextureWrapper *pTilesTexture, TextureWrapper *pSpriteTexture, SDL_Renderer *pSDLRenderer)
+    {
+        s_world.pSDLRenderer = pSDLRenderer;
+        s_world.tickCount = 0;
+        GameClock::Set(0, 0);
+
+        SDL_Rect textureRect = { 0, 0, Constants::TileTextureWidth, Constants::TileTextureHeight };
+        SDL_Rect tileRect = { 0, 0, Constants::TileWidth, Constants::TileHeight };
+        s_world.pMaze = new Maze(Constants::MapRows, Constants::MapCols, Constants::ScreenWidth, Constants::ScreenHeight);
+        s_world.pMaze->Initialize(textureRect, tileRect, pTilesTexture->Ptr(), Constants::MapIndicies,
+            Constants::MapRows * Constants::MapCols);
+        s_world.pMaze->BuildNavigation();
+
+        s_world.pPlayer = new Player(pSpriteTexture);
+        s_world.pPlayer->Initialize();
+        s_world.pPlayer->Reset(s_world.pMaze);
+
+        s_world.pBlinky = new BenchBlinky(pSpriteTexture);
+        s_world.pBlinky->Initialize();
+        s_world.pBlinky->Reset(s_world.pMaze);
+
+        // Points on a prime stride so consecutive lookups land on scattered tiles
+        int cxMap = Constants::MapCols * Constants::TileWidth;
+        int cyMap = Constants::MapRows * Constants::TileHeight;
+        SDL_Point origin = s_world.pMaze->GetTileCoordinates(0, 0);
+        for (int index = 0; index < 1021; index++)
+        {
+            SDL_Point point = { origin.x + (index * 97) % cxMap, origin.y + (index * 89) % cyMap };
+            s_world.points.push_back(point);
+        }
+
+        for (Uint16 row = 1; row < Constants::MapRows - 1; row++)
+        {
+            for (Uint16 col = 1; col < Constants::MapCols - 1; col++)
+            {
+                if (s_world.pMaze->IsTileSolid(row, col))
+                {
+                    continue;
+                }
+
+                Cell cell = { row, col };
+                s_world.openCells.push_back(cell);
+                if (s_world.pMaze->IsTileIntersection(row, col))
+                {
+                    s_world.intersections.push_back(cell);
+                }
+                else if (!s_world.pMaze->IsTileSolid(row, col + 1))
+                {
+                    s_world.corridors.push_back(cell);
+                }
+            }
+        }
+
+        // Spread out with different speeds, the ghost set has every animation they could be on
+        const AnimationSet &set = AnimationLibrary::Get().Blinky();
+        for (int index = 0; index < 64; index++)
+        {
+            Sprite *pSprite = new Sprite(pSpriteTexture, &set);
+            pSprite->SetAnimation(static_cast<Uint16>(index % 4));
+            pSprite->ResetPosition(origin.x + (index * 37) % cxMap, origin.y + (index * 53) % cyMap);
+            pSprite->SetVelocity((index % 3) - 1.0, ((index / 3) % 3) - 1.0);
+            s_world.sprites.push_back(pSprite);
+        }
+    }
+
+    void DestroyWorld()
+    {
+        for (Sprite *pSprite : s_world.sprites)
+        {
+            delete pSprite;
+        }
+        s_world.sprites.clear();
+        SafeDelete<BenchBlinky>(s_world.pBlinky);
+        SafeDelete<Player>(s_world.pPlayer);
+        SafeDelete<Maze>(s_world.pMaze);
+    }
+
+    void PrintUsage()
+    {
+        printf("usage: microbench [--json file] [--reps n] [--filter text]\n");
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const char *szJsonFile = nullptr;
+    const char *szFilter = nullptr;
+    Uint32 cReps = c_defaultReps;
+    for (int index = 1; index < argc; index++)
+    {
+        bool fHasValue = (index + 1 < argc);
+        if (fHasValue && SDL_strcmp(argv[index], "--json") == 0)
+        {
+            szJsonFile = argv[++index];
+        }
+        else if (fHasValue && SDL_strcmp(argv[index], "--reps") == 0)
+        {
+            cReps = static_cast<Uint32>(SDL_atoi(argv[++index]));
+        }
+        else if (fHasValue && SDL_strcmp(argv[index], "--filter") == 0)
+        {
+            szFilter = argv[++index];
+        }
+        else
+        {
+            PrintUsage();
+            return 1;
+        }
+    }
+    if (cReps == 0)
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    SDL_Surface *pSDLSurface = nullptr;
+    SDL_Renderer *pSDLRenderer = nullptr;
+    if (!InitializeOffscreenSDL(&pSDLSurface, &pSDLRenderer))
+    {
+        return 1;
+    }
+
+    int result = 1;
+    {
+        SDL_Color colorKey = Constants::SDLColorMagenta;
+        TextureWrapper tilesTexture(Constants::TilesImage, SDL_strlen(Constants::TilesImage), pSDLRenderer, static_cast<SDL_Color*>(nullptr));
+        TextureWrapper spriteTexture(Constants::SpritesImage, SDL_strlen(Constants::SpritesImage), pSDLRenderer, &colorKey);
+        if (!tilesTexture.IsNull() && !spriteTexture.IsNull())
+        {
+            BuildWorld(&tilesTexture, &spriteTexture, pSDLRenderer);
+
+            MicroBench bench(cReps, szFilter);
+            printf("%-40s %12s %12s %12s %10s %12s\n", "ns/op", "min", "median", "mean", "stddev", "ops/rep");
+            bench.Run("TiledMap::GetTileRowCol", BenchGetTileRowCol);
+            bench.Run("Maze::IsTileIntersection", BenchIsTileIntersection);
+            bench.Run("Maze::IsSpritePastCenter", BenchIsSpritePastCenter);
+            bench.Run("Ghost::ClosestExit", BenchBranchDecision);
+            bench.Run("Ghost::GetNextDirection", BenchNextDirection);
+            bench.Run("Blinky::Update", BenchGhostUpdate);
+            bench.Run("Sprite::Update", BenchSpriteUpdate);
+            bench.Run("TiledMap::Render (software)", BenchMazeRender);
+
+            result = (szJsonFile == nullptr || bench.WriteJson(szJsonFile)) ? 0 : 1;
+            DestroyWorld();
+        }
+    }
+
+    SDL_DestroyRenderer(pSDLRenderer);
+    SDL_FreeSurface(pSDLSurface);
+    SDL_Quit();
+    return result;
+}
@@ -0,0 +1,557 @@
+// Regression check for the benchmark results.  Takes pairs of result files - a baseline and a new run of the
+// same suite, the JSON written by microbench and scenarios - and compares every metric they share:
+//   ns/op (microbench samples, lower is better)
+//   ticks/sec (scenario samples, higher is better)
+//   allocations/tick and peak RSS (scenarios, one value per scenario and for the whole suite, lower is better)
+// Metrics with repeated samples on both sides are tested with a two sided Mann-Whitney U test, so a change
+// only counts when the medians move by more than the metric's threshold and the samples really are from
+// different distributions (p below --alpha).  Single values can only be checked against the threshold.
+// Prints a table and exits non zero if anything regressed.  Run by "make perf-compare", see the makefile.
+#include "SDL.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+namespace
+{
+    const double c_defaultAlpha = 0.05;
+    // Below this many samples a side the normal approximation can't reach p < 0.05 at all (with 3 a side the
+    // smallest p is about 0.08), so smaller sets are only checked against the threshold
+    const Uint32 c_minSamplesForTest = 5;
+
+    // Just enough JSON for the result files: objects, arrays, strings without escapes beyond \" and \\,
+    // numbers and literals
+    struct JsonValue
+    {
+        enum class Type
+        {
+            Null,
+            Bool,
+            Number,
+            String,
+            Array,
+            Object,
+        };
+
+        JsonValue() : type(Type::Null), number(0.0)
+        {
+        }
+
+        const JsonValue* Find(const char *szKey) const
+        {
+            for (const auto &member : members)
+            {
+                if (member.first == szKey)
+                {
+                    return &member.second;
+                }
+            }
+            return nullptr;
+        }
+
+        Type type;
+        double number;                  // Number, or 1/0 for Bool
+        std::string text;
+        std::vector<JsonValue> items;
+        std::vector<std::pair<std::string, JsonValue>> members;
+    };
+
+    class JsonParser
+    {
+    public:
+        JsonParser(const char *szText) : _pch(szText)
+        {
+        }
+
+        bool Parse(JsonValue *pValue)
+        {
+            return ParseValue(pValue) && (SkipSpace(), *_pch == '\0');
+        }
+
+    private:
+        void SkipSpace()
+        {
+            while ((*_pch == ' ') || (*_pch == '\t') || (*_pch == '\r') || (*_pch == '\n'))
+            {
+                _pch++;
+            }
+        }
+
+        bool ParseString(std::string *pText)
+        {
+            if (*_pch != '"')
+            {
+                return false;
+            }
+            _pch++;
+            while ((*_pch != '"') && (*_pch != '\0'))
+            {
+                if ((*_pch == '\\') && (_pch[1] != '\0'))
+                {
+                    _pch++;
+                }
+                pText->push_back(*_pch++);
+            }
+            if (*_pch != '"')
+            {
+                return false;
+            }
+            _pch++;
+            return true;
+        }
+
+        bool ParseValue(JsonValue *pValue)
+        {
+            SkipSpace();
+            if (*_pch == '{')
+            {
+                pValue->type = JsonValue::Type::Object;
+                _pch++;
+                SkipSpace();
+                while (*_pch != '}')
+                {
+                    std::pair<std::string, JsonValue> member;
+                    SkipSpace();
+                    if (!ParseString(&member.first) || (SkipSpace(), *_pch++ != ':') || !ParseValue(&member.second))
+                    {
+                        return false;
+                    }
+                    pValue->members.push_back(member);
+                    SkipSpace();
+                    if (*_pch == ',')
+                    {
+                        _pch++;
+                    }
+                    else if (*_pch != '}')
+                    {
+                        return false;
+                    }
+                }
+                _pch++;
+                return true;
+            }
+            if (*_pch == '[')
+            {
+                pValue->type = JsonValue::Type::Array;
+                _pch++;
+                SkipSpace();
+                while (*_pch != ']')
+                {
+                    JsonValue item;
+                    if (!ParseValue(&item))
+                    {
+                        return false;
+                    }
+                    pValue->items.push_back(item);
+                    SkipSpace();
+                    if (*_pch == ',')
+                    {
+                        _pch++;
+                    }
+                    else if (*_pch != ']')
+                    {
+                        return false;
+                    }
+                }
+                _pch++;
+                return true;
+            }
+            if (*_pch == '"')
+            {
+                pValue->type = JsonValue::Type::String;
+                return ParseString(&pValue->text);
+            }
+            if (SDL_strncmp(_pch, "true", 4) == 0 || SDL_strncmp(_pch, "false", 5) == 0)
+            {
+                pValue->type = JsonValue::Type::Bool;
+                pValue->number = (*_pch == 't') ? 1.0 : 0.0;
+                _pch += (*_pch == 't') ? 4 : 5;
+                return true;
+            }
+            if (SDL_strncmp(_pch, "null", 4) == 0)
+            {
+                _pch += 4;
+                return true;
+            }
+
+            char *pchEnd = nullptr;
+            pValue->type = JsonValue::Type::Number;
+            pValue->number = strtod(_pch, &pchEnd);
+            if (pchEnd == _pch)
+            {
+                return false;
+            }
+            _pch = pchEnd;
+            return true;
+        }
+
+        const char *_pch;
+    };
+
+    bool LoadJson(const char *szFileName, JsonValue *pValue)
+    {
+        FILE *pFile = fopen(szFileName, "rb");
+        if (pFile == nullptr)
+        {
+            printf("Unable to open %s\n", szFileName);
+            return false;
+        }
+        std::string text;
+        char buffer[4096];
+        size_t cbRead;
+        while ((cbRead = fread(buffer, 1, sizeof(buffer), pFile)) > 0)
+        {
+            text.append(buffer, cbRead);
+        }
+        fclose(pFile);
+
+        JsonParser parser(text.c_str());
+        if (!parser.Parse(pValue) || (pValue->type != JsonValue::Type::Object))
+        {
+            printf("%s is not valid JSON\n", szFileName);
+            return false;
+        }
+        return true;
+    }
+
+    // One thing compared: a benchmark's or scenario's metric, from one side
+    struct Measurement
+    {
+        std::string name;               // "Blinky::Update", "level-clear"
+        const char *szMetric;           // Display name, "ns/op"
+        const char *szThresholdKey;     // What --threshold calls it
+        bool fHigherIsBetter;
+        std::vector<double> samples;
+    };
+
+    struct Threshold
+    {
+        const char *szKey;
+        const char *szDescription;
+        double percent;
+    };
+
+    Threshold s_thresholds[] =
+    {
+        { "ns_per_op", "microbenchmark ns/op", 5.0 },
+        { "ticks_per_sec", "scenario ticks per second", 5.0 },
+        { "allocations", "scenario allocations per tick (from 0 any allocation regresses)", 0.0 },
+        { "rss", "scenario and suite peak RSS", 10.0 },
+    };
+
+    double ThresholdPercent(const char *szKey)
+    {
+        for (const Threshold &threshold : s_thresholds)
+        {
+            if (SDL_strcmp(threshold.szKey, szKey) == 0)
+            {
+                return threshold.percent;
+            }
+        }
+        return 0.0;
+    }
+
+    std::vector<double> Samples(const JsonValue *pSamples, const JsonValue *pFallback)
+    {
+        std::vector<double> samples;
+        if ((pSamples != nullptr) && (pSamples->type == JsonValue::Type::Array))
+        {
+            for (const JsonValue &item : pSamples->items)
+            {
+                samples.push_back(item.number);
+            }
+        }
+        // Results from before samples were written only have the summary
+        if (samples.empty() && (pFallback != nullptr))
+        {
+            samples.push_back(pFallback->number);
+        }
+        return samples;
+    }
+
+    // Metrics the run didn't report (no per scenario RSS off Linux) are left out
+    void AddMeasurement(std::vector<Measurement> *pMeasurements, const Measurement &measurement)
+    {
+        if (!measurement.samples.empty())
+        {
+            pMeasurements->push_back(measurement);
+        }
+    }
+
+    // Every metric in a microbench or scenarios result file
+    bool ReadMeasurements(const char *szFileName, std::vector<Measurement> *pMeasurements)
+    {
+        JsonValue root;
+        if (!LoadJson(szFileName, &root))
+        {
+            return false;
+        }
+
+        const JsonValue *pBenchmarks = root.Find("benchmarks");
+        const JsonValue *pScenarios = root.Find("scenarios");
+        if ((pBenchmarks != nullptr) && (pBenchmarks->type == JsonValue::Type::Array))
+        {
+            for (const JsonValue &bench : pBenchmarks->items)
+            {
+                const JsonValue *pName = bench.Find("name");
+                if (pName != nullptr)
+                {
+                    AddMeasurement(pMeasurements, { pName->text, "ns/op", "ns_per_op", false, Samples(bench.Find("samples"), bench.Find("median")) });
+                }
+            }
+            return true;
+        }
+        if ((pScenarios != nullptr) && (pScenarios->type == JsonValue::Type::Array))
+        {
+            const JsonValue *pRender = root.Find("render");
+            const char *szSuffix = ((pRender != nullptr) && (pRender->number != 0.0)) ? " (render)" : "";
+            for (const JsonValue &scenario : pScenarios->items)
+            {
+                const JsonValue *pName = scenario.Find("name");
+                if (pName == nullptr)
+                {
+                    continue;
+                }
+                std::string name = pName->text + szSuffix;
+                AddMeasurement(pMeasurements, { name, "ticks/sec", "ticks_per_sec", true,
+                    Samples(scenario.Find("samples_ticks_per_sec"), scenario.Find("ticks_per_sec")) });
+                AddMeasurement(pMeasurements, { name, "allocs/tick", "allocations", false, Samples(nullptr, scenario.Find("allocations_per_tick")) });
+                AddMeasurement(pMeasurements, { name, "peak RSS KB", "rss", false, Samples(nullptr, scenario.Find("peak_rss_kb")) });
+            }
+            AddMeasurement(pMeasurements, { std::string("(suite)") + szSuffix, "peak RSS KB", "rss", false, Samples(nullptr, root.Find("peak_rss_kb")) });
+            return true;
+        }
+
+        printf("%s has neither benchmarks nor scenarios\n", szFileName);
+        return false;
+    }
+
+    double Median(std::vector<double> samples)
+    {
+        std::sort(samples.begin(), samples.end());
+        size_t count = samples.size();
+        return (count % 2 == 1) ? samples[count / 2] : (samples[count / 2 - 1] + samples[count / 2]) / 2;
+    }
+
+    // Two sided p value of the Mann-Whitney U test, from the normal approximation with the correction for
+    // ties and for continuity.  Only used from c_minSamplesForTest samples a side, the suites take 5 to 15
+    double MannWhitneyP(const std::vector<double> &a, const std::vector<double> &b)
+    {
+        struct Ranked
+        {
+            double value;
+            bool fFromA;
+        };
+        std::vector<Ranked> all;
+        for (double value : a)
+        {
+            all.push_back({ value, true });
+        }
+        for (double value : b)
+        {
+            all.push_back({ value, false });
+        }
+        std::sort(all.begin(), all.end(), [](const Ranked &left, const Ranked &right) { return left.value < right.value; });
+
+        // Tied values share the average of their ranks
+        double rankSumA = 0.0;
+        double tieTerm = 0.0;
+        for (size_t first = 0; first < all.size();)
+        {
+            size_t last = first;
+            while ((last + 1 < all.size()) && (all[last + 1].value == all[first].value))
+            {
+                last++;
+            }
+            double cTied = static_cast<double>(last - first + 1);
+            double rank = (first + last) / 2.0 + 1.0;
+            for (size_t index = first; index <= last; index++)
+            {
+                rankSumA += all[index].fFromA ? rank : 0.0;
+            }
+            tieTerm += cTied * cTied * cTied - cTied;
+            first = last + 1;
+        }
+
+        double n1 = static_cast<double>(a.size());
+        double n2 = static_cast<double>(b.size());
+        double n = n1 + n2;
+        double u = rankSumA - n1 * (n1 + 1.0) / 2.0;
+        double mean = n1 * n2 / 2.0;
+        double variance = (n1 * n2 / 12.0) * ((n + 1.0) - tieTerm / (n * (n - 1.0)));
+        if (variance <= 0.0)
+        {
+            return 1.0;                 // Every sample the same value
+        }
+        double z = (fabs(u - mean) - 0.5) / sqrt(variance);
+        return (z <= 0.0) ? 1.0 : erfc(z / sqrt(2.0));
+    }
+
+    enum class Verdict
+    {
+        Same,
+        Regressed,
+        Improved,
+        Missing,
+    };
+
+    // Compares one metric and prints its row, returns how it went
+    Verdict CompareRow(const Measurement &baseline, const Measurement *pCurrent, double alpha)
+    {
+        if (pCurrent == nullptr)
+        {
+            printf("%-34s %-12s %14.4f %14s %9s %8s  %s\n", baseline.name.c_str(), baseline.szMetric, Median(baseline.samples),
+                "-", "-", "-", "missing");
+            return Verdict::Missing;
+        }
+
+        double baselineMedian = Median(baseline.samples);
+        double currentMedian = Median(pCurrent->samples);
+        double threshold = ThresholdPercent(baseline.szThresholdKey);
+        // Relative change in the "worse" direction, positive is a slowdown whichever way the metric runs
+        double changePercent = (baselineMedian != 0.0) ? (currentMedian - baselineMedian) * 100.0 / baselineMedian :
+            ((currentMedian != 0.0) ? 100.0 : 0.0);
+        double worsePercent = baseline.fHigherIsBetter ? -changePercent : changePercent;
+
+        bool fTested = (baseline.samples.size() >= c_minSamplesForTest) && (pCurrent->samples.size() >= c_minSamplesForTest);
+        double p = fTested ? MannWhitneyP(baseline.samples, pCurrent->samples) : 0.0;
+        bool fSignificant = !fTested || (p < alpha);
+
+        Verdict verdict = Verdict::Same;
+        if (fSignificant && (worsePercent > threshold))
+        {
+            verdict = Verdict::Regressed;
+        }
+        else if (fSignificant && (worsePercent < -threshold))
+        {
+            verdict = Verdict::Improved;
+        }
+
+        char szP[16];
+        if (fTested)
+        {
+            SDL_snprintf(szP, SDL_arraysize(szP), "%.4f", p);
+        }
+        else
+        {
+            SDL_strlcpy(szP, "n/a", SDL_arraysize(szP));
+        }
+        const char *szVerdicts[] = { "", "REGRESSED", "improved", "" };
+        printf("%-34s %-12s %14.4f %14.4f %+8.1f%% %8s  %s\n", baseline.name.c_str(), baseline.szMetric, baselineMedian,
+            currentMedian, changePercent, szP, szVerdicts[static_cast<int>(verdict)]);
+        return verdict;
+    }
+
+    void PrintUsage()
+    {
+        printf("usage: perfcompare [--alpha p] [--threshold metric=percent]... baseline.json current.json [baseline.json current.json]...\n");
+        printf("  compares microbench and scenarios results, metrics and default thresholds:\n");
+        for (const Threshold &threshold : s_thresholds)
+        {
+            printf("    %-14s %5.1f%%  %s\n", threshold.szKey, threshold.percent, threshold.szDescription);
+        }
+    }
+
+    bool SetThreshold(const char *szSetting)
+    {
+        const char *pchEquals = SDL_strchr(szSetting, '=');
+        if (pchEquals != nullptr)
+        {
+            for (Threshold &threshold : s_thresholds)
+            {
+                size_t cchKey = SDL_strlen(threshold.szKey);
+                if ((static_cast<size_t>(pchEquals - szSetting) == cchKey) && (SDL_strncmp(szSetting, threshold.szKey, cchKey) == 0))
+                {
+                    threshold.percent = atof(pchEquals + 1);
+                    return true;
+                }
+            }
+        }
+        printf("Unknown threshold %s\n", szSetting);
+        return false;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    double alpha = c_defaultAlpha;
+    std::vector<const char*> files;
+    for (int index = 1; index < argc; index++)
+    {
+        bool fHasValue = (index + 1 < argc);
+        if (fHasValue && SDL_strcmp(argv[index], "--alpha") == 0)
+        {
+            alpha = atof(argv[++index]);
+        }
+        else if (fHasValue && SDL_strcmp(argv[index], "--threshold") == 0)
+        {
+            if (!SetThreshold(argv[++index]))
+            {
+                PrintUsage();
+                return 1;
+            }
+        }
+        else if (argv[index][0] == '-')
+        {
+            PrintUsage();
+            return 1;
+        }
+        else
+        {
+            files.push_back(argv[index]);
+        }
+    }
+    if (files.empty() || (files.size() % 2 != 0))
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    Uint32 cRegressed = 0;
+    Uint32 cImproved = 0;
+    Uint32 cMissing = 0;
+    printf("%-34s %-12s %14s %14s %9s %8s\n", "benchmark", "metric", "baseline", "current", "change", "p");
+    for (size_t pair = 0; pair < files.size(); pair += 2)
+    {
+        std::vector<Measurement> baseline;
+        std::vector<Measurement> current;
+        if (!ReadMeasurements(files[pair], &baseline) || !ReadMeasurements(files[pair + 1], &current))
+        {
+            return 1;
+        }
+
+        for (const Measurement &measurement : baseline)
+        {
+            const Measurement *pCurrent = nullptr;
+            for (const Measurement &candidate : current)
+            {
+                if ((candidate.name == measurement.name) && (SDL_strcmp(candidate.szMetric, measurement.szMetric) == 0))
+                {
+                    pCurrent = &candidate;
+                    break;
+                }
+            }
+
+            switch (CompareRow(measurement, pCurrent, alpha))
+            {
+            case Verdict::Regressed:
+                cRegressed++;
+                break;
+            case Verdict::Improved:
+                cImproved++;
+                break;
+            case Verdict::Missing:
+                cMissing++;
+                break;
+            case Verdict::Same:
+                break;
+            }
+        }
+    }
+
+    printf("%u regressed, %u improved, %u missing from the current run (alpha %.3f)\n", cRegressed, cImproved, cMissing, alpha);
+    return (cRegressed == 0) ? 0 : 1;
+}
@@ -0,0 +1,446 @@
+// End to end throughput.  Each scenario scripts a whole session through one part of the game - a bot
+// clearing a level, the player looping through the warp tunnels, the ghost leaving the pen over and over,
+// and the level complete / reload cycle - headless, as fast as it will go.  For the measured ticks it
+// reports ticks per second, heap allocations per tick (on the simulation thread, see AllocationCounter)
+// and the peak RSS while it ran - on Linux the high-water mark is reset before each scenario, elsewhere only
+// the whole suite's peak is reported.  With --repeat each scenario runs that many times on fresh sessions and
+// the ticks per second of every run is kept as a sample for the regression comparator (bench/perfcompare.cpp).
+// Built and run by "make scenarios", see the makefile.
+#include "../include/gamesession.h"
+#include "../include/bot.h"
+#include "../include/alloccounter.h"
+#include <sys/resource.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include <algorithm>
+
+using namespace XplatGameTutorial::PacManClone;
+
+namespace
+{
+    const Uint32 c_maxTicks = 200000;           // Any scenario still going after this is stuck
+    const Uint32 c_tunnelTicks = 20000;
+    const Uint32 c_penCycles = 20;
+    const Uint32 c_reloadCycles = 20;
+
+    struct ScenarioResult
+    {
+        const char *szName;
+        bool fCompleted;
+        Uint32 cTicks;
+        Uint32 cIterations;                     // Whatever the scenario repeats - levels, warps, pen exits, reloads
+        double seconds;                         // Of the median run
+        Uint64 cAllocations;                    // Most any run made
+        long kbPeakRss;                         // While this scenario ran, 0 where that can't be measured
+        std::vector<double> ticksPerSecSamples; // One per run, sorted
+    };
+
+    // Peak RSS of the whole process so far
+    long SuitePeakRssKb()
+    {
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0)
+        {
+            return 0;
+        }
+#ifdef __APPLE__
+        return usage.ru_maxrss / 1024;          // Bytes there, kilobytes on Linux
+#else
+        return usage.ru_maxrss;
+#endif
+    }
+
+    // Start a new RSS high-water mark (Linux 4.0 and later), so PeakRssKb() covers only what ran since.
+    // Returns false where the mark can't be reset
+    bool ResetPeakRss()
+    {
+#ifdef __linux__
+        FILE *pFile = fopen("/proc/self/clear_refs", "w");
+        if (pFile == nullptr)
+        {
+            return false;
+        }
+        bool fResult = (fputs("5", pFile) >= 0);
+        return (fclose(pFile) == 0) && fResult;
+#else
+        return false;
+#endif
+    }
+
+    // The RSS high-water mark since the last ResetPeakRss(), from VmHWM
+    long PeakRssKb()
+    {
+        long kbPeak = 0;
+        FILE *pFile = fopen("/proc/self/status", "r");
+        if (pFile != nullptr)
+        {
+            char szLine[256];
+            while (fgets(szLine, sizeof(szLine), pFile) != nullptr)
+            {
+                if (SDL_strncmp(szLine, "VmHWM:", 6) == 0)
+                {
+                    kbPeak = strtol(szLine + 6, nullptr, 10);
+                    break;
+                }
+            }
+            fclose(pFile);
+        }
+        return kbPeak;
+    }
+
+    // Drives one fresh session.  Only ticks between StartMeasuring() and StopMeasuring() count, so each
+    // scenario can get the session into position first
+    class ScenarioRun
+    {
+    public:
+        ScenarioRun(GameSession &session, SDL_Renderer *pSDLRenderer) :
+            _session(session),
+            _pSDLRenderer(pSDLRenderer),
+            _fMeasuring(false),
+            _cTicks(0),
+            _cTotalTicks(0),
+            _startCounter(0),
+            _startAllocations(0),
+            _seconds(0.0),
+            _cAllocations(0)
+        {
+        }
+
+        // False once the scenario has run too long
+        bool Tick(Direction inputDirection)
+        {
+            _session.Tick(inputDirection);
+            if (_pSDLRenderer != nullptr)
+            {
+                SDL_RenderClear(_pSDLRenderer);
+                _session.Render(_pSDLRenderer);
+            }
+            if (_fMeasuring)
+            {
+                _cTicks++;
+            }
+            return (++_cTotalTicks < c_maxTicks);
+        }
+
+        bool TickUntilRunning()
+        {
+            while (!_session.IsRunning())
+            {
+                if (!Tick(Direction::None))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        void StartMeasuring()
+        {
+            _fMeasuring = true;
+            _startAllocations = AllocationCounter::ThreadCount();
+            _startCounter = SDL_GetPerformanceCounter();
+        }
+
+        void StopMeasuring()
+        {
+            _seconds = static_cast<double>(SDL_GetPerformanceCounter() - _startCounter) / SDL_GetPerformanceFrequency();
+            _cAllocations = AllocationCounter::ThreadCount() - _startAllocations;
+            _fMeasuring = false;
+        }
+
+        GameSession& Session() { return _session; }
+        Uint32 MeasuredTicks() { return _cTicks; }
+        double Seconds() { return _seconds; }
+        Uint64 Allocations() { return _cAllocations; }
+
+    private:
+        GameSession &_session;
+        SDL_Renderer *_pSDLRenderer;            // nullptr - simulation only
+        bool _fMeasuring;
+        Uint32 _cTicks;
+        Uint32 _cTotalTicks;
+        Uint64 _startCounter;
+        Uint64 _startAllocations;
+        double _seconds;
+        Uint64 _cAllocations;
+    };
+
+    typedef bool(*ScenarioFunction)(ScenarioRun &run, Uint32 &cIterations);
+
+    // The pellet bot from the first tick (loading included) until the level is cleared
+    bool RunLevelClear(ScenarioRun &run, Uint32 &cIterations)
+    {
+        PelletBot bot;
+        run.StartMeasuring();
+        while (run.Session().LevelsCompleted() == 0)
+        {
+            if (!run.Tick(bot.ChooseInput(run.Session())))
+            {
+                return false;
+            }
+        }
+        run.StopMeasuring();
+        cIterations = run.Session().LevelsCompleted();
+        return true;
+    }
+
+    // The player is dropped into the warp row and runs it end to end: holding a direction until it stops
+    // against the pen wall, then turning round, so every leg goes out through one tunnel and in the other
+    bool RunTunnelLoop(ScenarioRun &run, Uint32 &cIterations)
+    {
+        if (!run.TickUntilRunning())
+        {
+            return false;
+        }
+
+        Player *pPlayer = run.Session().GetPlayer();
+        SDL_Point startPoint = run.Session().GetMaze()->GetTileCoordinates(Constants::WarpRow, 21);
+        pPlayer->ResetPosition(startPoint.x, startPoint.y);
+
+        Direction inputDirection = Direction::Left;
+        bool fWasWarping = false;
+        cIterations = 0;
+        run.StartMeasuring();
+        for (Uint32 tick = 0; tick < c_tunnelTicks; tick++)
+        {
+            if (!pPlayer->IsWarping() && pPlayer->DX() == 0.0)
+            {
+                inputDirection = (inputDirection == Direction::Left) ? Direction::Right : Direction::Left;
+            }
+            run.Tick(inputDirection);
+
+            if (pPlayer->IsWarping() && !fWasWarping)
+            {
+                cIterations++;
+            }
+            fWasWarping = pPlayer->IsWarping();
+        }
+        run.StopMeasuring();
+        return (cIterations > 0);
+    }
+
+    // Level start through to Blinky being out of the pen, then restart the level and do it again
+    bool RunPenExits(ScenarioRun &run, Uint32 &cIterations)
+    {
+        if (!run.TickUntilRunning())
+        {
+            return false;
+        }
+
+        cIterations = 0;
+        run.StartMeasuring();
+        while (cIterations < c_penCycles)
+        {
+            run.Session().RestartLevel();
+            while (!run.Session().IsRunning() || run.Session().GetBlinky()->IsInPen())
+            {
+                if (!run.Tick(Direction::None))
+                {
+                    return false;
+                }
+            }
+            cIterations++;
+        }
+        run.StopMeasuring();
+        return true;
+    }
+
+    // Level complete flash, the swap to the prefetched maze and the start delay, over and over
+    bool RunLevelReloads(ScenarioRun &run, Uint32 &cIterations)
+    {
+        if (!run.TickUntilRunning())
+        {
+            return false;
+        }
+
+        cIterations = 0;
+        run.StartMeasuring();
+        while (cIterations < c_reloadCycles)
+        {
+            run.Session().CompleteLevel();
+            if (!run.Tick(Direction::None) || !run.TickUntilRunning())
+            {
+                return false;
+            }
+            cIterations++;
+        }
+        run.StopMeasuring();
+        return true;
+    }
+
+    struct Scenario
+    {
+        const char *szName;
+        ScenarioFunction pfnRun;
+    };
+
+    const Scenario c_scenarios[] =
+    {
+        { "level-clear", RunLevelClear },
+        { "tunnel-loop", RunTunnelLoop },
+        { "pen-exit", RunPenExits },
+        { "level-reload", RunLevelReloads },
+    };
+
+    bool WriteJson(const char *szFileName, const std::vector<ScenarioResult> &results, bool fRender, long kbSuitePeakRss)
+    {
+        FILE *pFile = fopen(szFileName, "w");
+        if (pFile == nullptr)
+        {
+            printf("Failed to open %s for the results\n", szFileName);
+            return false;
+        }
+
+        fprintf(pFile, "{\"render\":%s,\"peak_rss_kb\":%ld,\"scenarios\":[\n", fRender ? "true" : "false", kbSuitePeakRss);
+        for (size_t index = 0; index < results.size(); index++)
+        {
+            const ScenarioResult &result = results[index];
+            double ticksPerSecond = (result.seconds > 0.0) ? result.cTicks / result.seconds : 0.0;
+            double allocationsPerTick = (result.cTicks > 0) ? static_cast<double>(result.cAllocations) / result.cTicks : 0.0;
+            fprintf(pFile, "%s{\"name\":\"%s\",\"completed\":%s,\"ticks\":%u,\"iterations\":%u,\"seconds\":%.6f,"
+                "\"ticks_per_sec\":%.1f,\"allocations\":%llu,\"allocations_per_tick\":%.6f,",
+                (index == 0) ? "" : ",\n", result.szName, result.fCompleted ? "true" : "false", result.cTicks,
+                result.cIterations, result.seconds, ticksPerSecond, static_cast<unsigned long long>(result.cAllocations),
+                allocationsPerTick);
+            if (result.kbPeakRss > 0)
+            {
+                fprintf(pFile, "\"peak_rss_kb\":%ld,", result.kbPeakRss);
+            }
+            fprintf(pFile, "\"samples_ticks_per_sec\":[");
+            for (size_t sample = 0; sample < result.ticksPerSecSamples.size(); sample++)
+            {
+                fprintf(pFile, "%s%.1f", (sample == 0) ? "" : ",", result.ticksPerSecSamples[sample]);
+            }
+            fprintf(pFile, "]}");
+        }
+        fprintf(pFile, "\n]}\n");
+
+        bool fResult = (fclose(pFile) == 0);
+        printf("Wrote %u results to %s\n", static_cast<Uint32>(results.size()), szFileName);
+        return fResult;
+    }
+
+    void PrintUsage()
+    {
+        printf("usage: scenarios [--json file] [--scenario name] [--render] [--repeat n]\n");
+        printf("  --render also draws every tick to an offscreen software renderer\n");
+        printf("  scenarios:");
+        for (const Scenario &scenario : c_scenarios)
+        {
+            printf(" %s", scenario.szName);
+        }
+        printf("\n");
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const char *szJsonFile = nullptr;
+    const char *szScenario = nullptr;
+    bool fRender = false;
+    Uint32 cRepeats = 1;
+    for (int index = 1; index < argc; index++)
+    {
+        bool fHasValue = (index + 1 < argc);
+        if (fHasValue && SDL_strcmp(argv[index], "--json") == 0)
+        {
+            szJsonFile = argv[++index];
+        }
+        else if (fHasValue && SDL_strcmp(argv[index], "--scenario") == 0)
+        {
+            szScenario = argv[++index];
+        }
+        else if (fHasValue && SDL_strcmp(argv[index], "--repeat") == 0)
+        {
+            cRepeats = static_cast<Uint32>(SDL_atoi(argv[++index]));
+        }
+        else if (SDL_strcmp(argv[index], "--render") == 0)
+        {
+            fRender = true;
+        }
+        else
+        {
+            PrintUsage();
+            return 1;
+        }
+    }
+    if (cRepeats == 0)
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    // The session needs real textures to load a level even when nothing is drawn
+    SDL_Surface *pSDLSurface = nullptr;
+    SDL_Renderer *pSDLRenderer = nullptr;
+    if (!InitializeOffscreenSDL(&pSDLSurface, &pSDLRenderer))
+    {
+        return 1;
+    }
+
+    bool fResult = false;
+    {
+        TextureRegistry textureRegistry;
+        textureRegistry.Initialize(pSDLRenderer, nullptr, 0);
+        TextureHandle tilesTexture = textureRegistry.Acquire("tiles");
+        TextureHandle spriteTexture = textureRegistry.Acquire("sprites");
+        GlyphAtlas glyphAtlas;
+        if (!tilesTexture.IsNull() && !spriteTexture.IsNull() && glyphAtlas.Initialize(pSDLRenderer))
+        {
+            std::vector<ScenarioResult> results;
+            fResult = true;
+            printf("%-14s %10s %8s %10s %14s %12s %12s\n", "scenario", "ticks", "iters", "seconds", "ticks/sec", "allocs/tick", "peak RSS KB");
+            for (const Scenario &scenario : c_scenarios)
+            {
+                if (szScenario != nullptr && SDL_strcmp(szScenario, scenario.szName) != 0)
+                {
+                    continue;
+                }
+
+                // Every run is the same ticks on the same input, only the time varies
+                ScenarioResult result = { scenario.szName, true, 0, 0, 0.0, 0, 0, std::vector<double>() };
+                std::vector<double> runSeconds;
+                bool fScenarioRss = ResetPeakRss();
+                for (Uint32 repeat = 0; repeat < cRepeats; repeat++)
+                {
+                    GameSession session;
+                    session.Initialize(tilesTexture, spriteTexture, &glyphAtlas);
+                    ScenarioRun run(session, fRender ? pSDLRenderer : nullptr);
+                    result.fCompleted = scenario.pfnRun(run, result.cIterations) && result.fCompleted;
+                    result.cTicks = run.MeasuredTicks();
+                    result.cAllocations = SDL_max(result.cAllocations, run.Allocations());
+                    runSeconds.push_back(run.Seconds());
+                    result.ticksPerSecSamples.push_back((run.Seconds() > 0.0) ? run.MeasuredTicks() / run.Seconds() : 0.0);
+                }
+                std::sort(runSeconds.begin(), runSeconds.end());
+                std::sort(result.ticksPerSecSamples.begin(), result.ticksPerSecSamples.end());
+                result.seconds = runSeconds[runSeconds.size() / 2];
+                result.kbPeakRss = fScenarioRss ? PeakRssKb() : 0;
+                results.push_back(result);
+
+                printf("%-14s %10u %8u %10.3f %14.1f %12.4f %12ld%s\n", result.szName, result.cTicks, result.cIterations,
+                    result.seconds, (result.seconds > 0.0) ? result.cTicks / result.seconds : 0.0,
+                    (result.cTicks > 0) ? static_cast<double>(result.cAllocations) / result.cTicks : 0.0,
+                    result.kbPeakRss, result.fCompleted ? "" : "  (did not complete)");
+                fResult = fResult && result.fCompleted;
+            }
+
+            if (results.empty())
+            {
+                PrintUsage();
+                fResult = false;
+            }
+            else if (szJsonFile != nullptr)
+            {
+                fResult = WriteJson(szJsonFile, results, fRender, SuitePeakRssKb()) && fResult;
+            }
+            printf("Suite peak RSS %ld KB\n", SuitePeakRssKb());
+        }
+    }
+
+    SDL_DestroyRenderer(pSDLRenderer);
+    SDL_FreeSurface(pSDLSurface);
+    SDL_Quit();
+    return fResult ? 0 : 1;
+}
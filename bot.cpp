@@ -0,0 +1,82 @@
+#include "include/bot.h"
+#include "include/gamesession.h"
+
+using namespace XplatGameTutorial::PacManClone;
+
+Direction PelletBot::ChooseInput(GameSession &session)
+{
+    Maze *pMaze = session.GetMaze();
+    Player *pPlayer = session.GetPlayer();
+    if ((pMaze == nullptr) || (pPlayer == nullptr))
+    {
+        return Direction::None;
+    }
+
+    SDL_Point playerPoint = { static_cast<int>(pPlayer->X()), static_cast<int>(pPlayer->Y()) };
+    Uint16 row = 0;
+    Uint16 col = 0;
+    if (!pMaze->GetTileRowCol(playerPoint, row, col))
+    {
+        // Off the map in the warp tunnel, nothing to steer
+        return Direction::None;
+    }
+
+    // Only think again once we reach a new cell, or if the pellet we were heading for is gone
+    if ((row != _lastRow) || (col != _lastCol) || (_direction == Direction::None))
+    {
+        _lastRow = row;
+        _lastCol = col;
+        _direction = FindNearestPellet(session, row, col);
+    }
+    return _direction;
+}
+
+Direction PelletBot::FindNearestPellet(GameSession &session, Uint16 startRow, Uint16 startCol)
+{
+    Maze *pMaze = session.GetMaze();
+    const Direction directions[] = { Direction::Up, Direction::Down, Direction::Left, Direction::Right };
+    const Uint8 c_unvisited = static_cast<Uint8>(Direction::None);
+
+    SDL_memset(_firstStep, c_unvisited, sizeof(_firstStep));
+    Uint16 head = 0;
+    Uint16 tail = 0;
+
+    // The start cell is marked with any non None value so it isn't revisited
+    Uint16 startCell = startRow * Constants::MapCols + startCol;
+    _firstStep[startCell] = 0;
+    _queue[tail++] = startCell;
+
+    while (head < tail)
+    {
+        Uint16 cell = _queue[head++];
+        Uint16 row = cell / Constants::MapCols;
+        Uint16 col = cell % Constants::MapCols;
+
+        for (size_t index = 0; index < SDL_arraysize(directions); index++)
+        {
+            Uint16 nextRow = row;
+            Uint16 nextCol = col;
+            TranslateCell(nextRow, nextCol, directions[index]);
+            // Unsigned, so stepping off the top or left wraps to a large value
+            if ((nextRow >= Constants::MapRows) || (nextCol >= Constants::MapCols) || pMaze->IsTileSolid(nextRow, nextCol))
+            {
+                continue;
+            }
+
+            Uint16 nextCell = nextRow * Constants::MapCols + nextCol;
+            if (_firstStep[nextCell] != c_unvisited)
+            {
+                continue;
+            }
+
+            Uint8 firstStep = (cell == startCell) ? static_cast<Uint8>(directions[index]) : _firstStep[cell];
+            if (pMaze->IsTilePellet(nextRow, nextCol))
+            {
+                return static_cast<Direction>(firstStep);
+            }
+            _firstStep[nextCell] = firstStep;
+            _queue[tail++] = nextCell;
+        }
+    }
+    return Direction::None;
+}
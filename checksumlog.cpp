@@ -0,0 +1,129 @@
+#include "include/checksumlog.h"
+#include "include/log.h"
+
+using namespace XplatGameTutorial::PacManClone;
+
+namespace
+{
+    const char * const c_szComponentNames[static_cast<size_t>(StateComponent::Count)] = { "session", "player", "ghosts", "maze" };
+}
+
+// File layout is a small header { magic, version, components per tick } followed by the checksums, one
+// Uint64 per component per tick.  The component count is stored so a log from a build that hashes more
+// components is refused rather than misread
+bool ChecksumLog::Create(const char *szFileName)
+{
+    SDL_assert(_pFile == nullptr);
+    _pFile = fopen(szFileName, "wb");
+    if (_pFile == nullptr)
+    {
+        PMC_LOG_ERROR(LogCategory::Harness, "ChecksumLog::Create() : unable to open %s", szFileName);
+        return false;
+    }
+
+    Uint32 header[3] = { c_magic, c_version, static_cast<Uint32>(StateComponent::Count) };
+    if (fwrite(header, sizeof(header), 1, _pFile) != 1)
+    {
+        PMC_LOG_ERROR(LogCategory::Harness, "ChecksumLog::Create() : unable to write %s", szFileName);
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void ChecksumLog::Append(const StateChecksum &checksum)
+{
+    if (_pFile != nullptr)
+    {
+        fwrite(checksum.components, sizeof(checksum.components), 1, _pFile);
+    }
+}
+
+void ChecksumLog::Close()
+{
+    if (_pFile != nullptr)
+    {
+        fclose(_pFile);
+        _pFile = nullptr;
+    }
+}
+
+bool ChecksumLog::Load(const char *szFileName)
+{
+    _checksums.clear();
+    FILE *pFile = fopen(szFileName, "rb");
+    if (pFile == nullptr)
+    {
+        PMC_LOG_ERROR(LogCategory::Harness, "ChecksumLog::Load() : unable to open %s", szFileName);
+        return false;
+    }
+
+    bool fResult = false;
+    Uint32 header[3] = { 0, 0, 0 };
+    if ((fread(header, sizeof(header), 1, pFile) != 1) || (header[0] != c_magic) || (header[1] != c_version))
+    {
+        PMC_LOG_ERROR(LogCategory::Harness, "ChecksumLog::Load() : %s is not a checksum log", szFileName);
+    }
+    else if (header[2] != static_cast<Uint32>(StateComponent::Count))
+    {
+        PMC_LOG_ERROR(LogCategory::Harness, "ChecksumLog::Load() : %s has %u components per tick, this build hashes %u", szFileName, header[2],
+            static_cast<Uint32>(StateComponent::Count));
+    }
+    else
+    {
+        StateChecksum checksum;
+        while (fread(checksum.components, sizeof(checksum.components), 1, pFile) == 1)
+        {
+            _checksums.push_back(checksum);
+        }
+        fResult = true;
+    }
+    fclose(pFile);
+    return fResult;
+}
+
+bool ChecksumLog::ReportDivergence(Uint32 tick, const StateChecksum &expected, const StateChecksum &actual)
+{
+    bool fDiverged = false;
+    for (size_t index = 0; index < static_cast<size_t>(StateComponent::Count); index++)
+    {
+        if (expected.components[index] != actual.components[index])
+        {
+            if (!fDiverged)
+            {
+                printf("Diverged at tick %u:\n", tick);
+                fDiverged = true;
+            }
+            printf("  %-8s expected %016llx, got %016llx\n", c_szComponentNames[index],
+                static_cast<unsigned long long>(expected.components[index]), static_cast<unsigned long long>(actual.components[index]));
+        }
+    }
+    return fDiverged;
+}
+
+bool ChecksumLog::Compare(const char *szExpectedFile, const char *szActualFile)
+{
+    ChecksumLog expected;
+    ChecksumLog actual;
+    if (!expected.Load(szExpectedFile) || !actual.Load(szActualFile))
+    {
+        return false;
+    }
+
+    Uint32 cTicks = SDL_min(expected.Length(), actual.Length());
+    for (Uint32 tick = 0; tick < cTicks; tick++)
+    {
+        if (ReportDivergence(tick, expected.At(tick), actual.At(tick)))
+        {
+            return false;
+        }
+    }
+
+    printf("%u ticks match", cTicks);
+    if (expected.Length() != actual.Length())
+    {
+        printf(" (%s has %u ticks, %s has %u)", szExpectedFile, expected.Length(), szActualFile, actual.Length());
+    }
+    printf("\n");
+    return true;
+}
@@ -0,0 +1,61 @@
+#include "include/configurableghost.h"
+
+using namespace XplatGameTutorial::PacManClone;
+
+ConfigurableGhost::ConfigurableGhost(TextureWrapper* pTextureWrapper, const AnimationSet *pAnimationSet, GhostTargetFunction pfnTarget, void *pContext) :
+    GhostT<ConfigurableGhost>(pTextureWrapper, pAnimationSet),
+    _pfnTarget(pfnTarget),
+    _pContext(pContext)
+{
+    SDL_assert(_pfnTarget != nullptr);
+}
+
+bool ConfigurableGhost::Initialize()
+{
+    return _pAnimationSet->FitsTexture(_pTextureWrapper);
+}
+
+bool ConfigurableGhost::Reset(Maze *pMaze)
+{
+    ResetToPen(pMaze);
+    return true;
+}
+
+void ConfigurableGhost::TargetAhead(void *, Ghost *, Player *pPlayer, Maze *, double &xTarget, double &yTarget)
+{
+    const double c_cellsAhead = 4.0;
+    xTarget = pPlayer->X();
+    yTarget = pPlayer->Y();
+    switch (pPlayer->CurrentDirection())
+    {
+    case Direction::Up:
+        yTarget -= c_cellsAhead * Constants::TileHeight;
+        break;
+    case Direction::Down:
+        yTarget += c_cellsAhead * Constants::TileHeight;
+        break;
+    case Direction::Left:
+        xTarget -= c_cellsAhead * Constants::TileWidth;
+        break;
+    case Direction::Right:
+        xTarget += c_cellsAhead * Constants::TileWidth;
+        break;
+    default:
+        break;
+    }
+}
+
+void ConfigurableGhost::TargetCell(void *pContext, Ghost *, Player *, Maze *pMaze, double &xTarget, double &yTarget)
+{
+    const SDL_Point *pCell = static_cast<const SDL_Point*>(pContext);
+    SDL_Point point = pMaze->GetTileCoordinates(static_cast<Uint16>(pCell->y), static_cast<Uint16>(pCell->x));
+    xTarget = point.x;
+    yTarget = point.y;
+}
+
+void ConfigurableGhost::SetTarget(GhostTargetFunction pfnTarget, void *pContext)
+{
+    SDL_assert(pfnTarget != nullptr);
+    _pfnTarget = pfnTarget;
+    _pContext = pContext;
+}
@@ -8,6 +8,8 @@ namespace PacManClone
     const SDL_Color Constants::SDLColorGrey = { 128, 128, 128, 255 };       // Grey used for "background"
     const SDL_Color Constants::SDLColorMagenta = { 0xFF, 0, 0xFF, 0 };      // Color Key used for transparency
     const SDL_Color Constants::RenderDrawColor = Constants::SDLColorGrey;   // sets background when renderer cleared
+    const SDL_Color Constants::TextColorWhite = { 255, 255, 255, 255 };     // HUD text
+    const SDL_Color Constants::TextColorYellow = { 255, 255, 0, 255 };      // "READY!"
     const char * const Constants::WindowTitle = "Pac-Man Clone";
 
     const double Constants::PlayerMaxSpeed = 2.0;
@@ -111,5 +113,11 @@ namespace PacManClone
 
     const char * const Constants::TilesImage = "./grfx/tiles.png";
     const char * const Constants::SpritesImage = "./grfx/spritesheet.png";
+
+    const Constants::TextureAsset Constants::TextureAssets[TextureAssetCount] =
+    {
+        { "tiles", TilesImage, nullptr },
+        { "sprites", SpritesImage, &SDLColorMagenta },
+    };
 }
 };
\ No newline at end of file
@@ -0,0 +1,233 @@
+#include "include/entitystore.h"
+#include "include/sprite.h"
+#include "include/maze.h"
+
+using namespace XplatGameTutorial::PacManClone;
+
+EntityStore::~EntityStore()
+{
+    Release();
+}
+
+void EntityStore::Reserve(Uint32 cEntities)
+{
+    if (cEntities <= _capacity)
+    {
+        return;
+    }
+
+    // Nothing worth keeping across a grow, the store is refilled after it anyway
+    Release();
+    _pX = new float[cEntities];
+    _pY = new float[cEntities];
+    _pDX = new float[cEntities];
+    _pDY = new float[cEntities];
+    _pRow = new Sint16[cEntities];
+    _pCol = new Sint16[cEntities];
+    _pMode = new EntityMode[cEntities];
+    _pAtCenter = new Uint8[cEntities];
+    _capacity = cEntities;
+}
+
+void EntityStore::Release()
+{
+    delete[] _pX;
+    delete[] _pY;
+    delete[] _pDX;
+    delete[] _pDY;
+    delete[] _pRow;
+    delete[] _pCol;
+    delete[] _pMode;
+    delete[] _pAtCenter;
+    _pX = _pY = _pDX = _pDY = nullptr;
+    _pRow = _pCol = nullptr;
+    _pMode = nullptr;
+    _pAtCenter = nullptr;
+    _capacity = 0;
+    _count = 0;
+}
+
+void EntityStore::Clear()
+{
+    _count = 0;
+}
+
+// Scatters the entities over open tiles, each heading down one of its tile's open exits at 1 or 2 pixels
+// a tick.  Same seed, same maze - same entities
+void EntityStore::SpawnWanderers(Maze *pMaze, Uint32 cEntities, Uint32 seed)
+{
+    Clear();
+    _random = (seed != 0) ? seed : 1;
+
+    SDL_Rect mapBounds = pMaze->GetMapBounds();
+    Direction directions[] = { Direction::Up, Direction::Down, Direction::Left, Direction::Right };
+    while (_count < SDL_min(cEntities, _capacity))
+    {
+        Uint16 row = static_cast<Uint16>(1 + NextRandom() % (Constants::MapRows - 2));
+        Uint16 col = static_cast<Uint16>(1 + NextRandom() % (Constants::MapCols - 2));
+        Direction direction = directions[NextRandom() % SDL_arraysize(directions)];
+        Uint16 nextRow = 0;
+        Uint16 nextCol = 0;
+        pMaze->GetNextCell(row, col, nextRow, nextCol, direction);
+        if (pMaze->IsTileSolid(row, col) || pMaze->IsTileSolid(nextRow, nextCol))
+        {
+            continue;
+        }
+
+        float speed = static_cast<float>(1 + (_count & 1));
+        Uint32 index = _count++;
+        _pX[index] = static_cast<float>(mapBounds.x + col * Constants::TileWidth + Constants::TileWidth / 2);
+        _pY[index] = static_cast<float>(mapBounds.y + row * Constants::TileHeight + Constants::TileHeight / 2);
+        _pDX[index] = (direction == Direction::Left) ? -speed : ((direction == Direction::Right) ? speed : 0.0f);
+        _pDY[index] = (direction == Direction::Up) ? -speed : ((direction == Direction::Down) ? speed : 0.0f);
+        _pRow[index] = static_cast<Sint16>(row);
+        _pCol[index] = static_cast<Sint16>(col);
+        _pMode[index] = EntityMode::Wander;
+    }
+}
+
+void EntityStore::Update(Maze *pMaze)
+{
+    Uint64 startCounter = SDL_GetPerformanceCounter();
+
+    SDL_Rect mapBounds = pMaze->GetMapBounds();
+    IntegrateMotion();
+    WrapTunnels(mapBounds.x, mapBounds.w);
+    UpdateCells(mapBounds.x, mapBounds.y);
+    FindCenters(mapBounds.x, mapBounds.y);
+    Steer(pMaze);
+
+    _updateCounter += SDL_GetPerformanceCounter() - startCounter;
+    _cUpdates++;
+}
+
+void EntityStore::Render(SDL_Renderer *pSDLRenderer, SDL_Texture *pTexture, const SDL_Rect &frameRect, int xFrameOffset, int yFrameOffset)
+{
+    for (Uint32 index = 0; index < _count; index++)
+    {
+        SDL_Rect targetRect = { static_cast<int>(_pX[index]) + xFrameOffset, static_cast<int>(_pY[index]) + yFrameOffset, frameRect.w, frameRect.h };
+        SDL_RenderCopy(pSDLRenderer, pTexture, &frameRect, &targetRect);
+    }
+}
+
+void EntityStore::PrintStats()
+{
+    if (_cUpdates > 0)
+    {
+        double msPerUpdate = (_updateCounter * 1000.0) / SDL_GetPerformanceFrequency() / _cUpdates;
+        printf("Entities: %u, %.3f ms per update over %u updates\n", _count, msPerUpdate, _cUpdates);
+    }
+}
+
+void EntityStore::IntegrateMotion()
+{
+    float *pX = _pX;
+    float *pY = _pY;
+    const float *pDX = _pDX;
+    const float *pDY = _pDY;
+    for (Uint32 index = 0; index < _count; index++)
+    {
+        pX[index] += pDX[index];
+        pY[index] += pDY[index];
+    }
+}
+
+// Anything that has run out of either end of the tunnel (a full tile past the edge column's center)
+// comes back in on the other side
+void EntityStore::WrapTunnels(int xMap, int cxMap)
+{
+    float *pX = _pX;
+    const float left = static_cast<float>(xMap - Constants::TileWidth / 2);
+    const float right = static_cast<float>(xMap + cxMap + Constants::TileWidth / 2);
+    const float width = static_cast<float>(cxMap);
+    for (Uint32 index = 0; index < _count; index++)
+    {
+        float x = pX[index];
+        x = (x <= left) ? (x + width) : x;
+        x = (x >= right) ? (x - width) : x;
+        pX[index] = x;
+    }
+}
+
+// Positions never go more than half a tile outside the map, so adding a tile keeps the division positive
+// and the truncation a floor
+void EntityStore::UpdateCells(int xMap, int yMap)
+{
+    const float *pX = _pX;
+    const float *pY = _pY;
+    Sint16 *pRow = _pRow;
+    Sint16 *pCol = _pCol;
+    EntityMode *pMode = _pMode;
+    for (Uint32 index = 0; index < _count; index++)
+    {
+        int col = (static_cast<int>(pX[index]) - xMap + Constants::TileWidth) / Constants::TileWidth - 1;
+        int row = (static_cast<int>(pY[index]) - yMap + Constants::TileHeight) / Constants::TileHeight - 1;
+        pCol[index] = static_cast<Sint16>(col);
+        pRow[index] = static_cast<Sint16>(row);
+        pMode[index] = ((col <= 0) || (col >= Constants::MapCols - 1)) ? EntityMode::Tunnel : EntityMode::Wander;
+    }
+}
+
+void EntityStore::FindCenters(int xMap, int yMap)
+{
+    const float *pX = _pX;
+    const float *pY = _pY;
+    const EntityMode *pMode = _pMode;
+    Uint8 *pAtCenter = _pAtCenter;
+    for (Uint32 index = 0; index < _count; index++)
+    {
+        int xInTile = (static_cast<int>(pX[index]) - xMap) % Constants::TileWidth;
+        int yInTile = (static_cast<int>(pY[index]) - yMap) % Constants::TileHeight;
+        pAtCenter[index] = ((pMode[index] == EntityMode::Wander) &&
+            (xInTile == Constants::TileWidth / 2) && (yInTile == Constants::TileHeight / 2)) ? 1 : 0;
+    }
+}
+
+// The only scalar pass.  On a tile center pick any open exit other than straight back, or turn around at
+// a dead end
+void EntityStore::Steer(Maze *pMaze)
+{
+    Direction directions[] = { Direction::Up, Direction::Down, Direction::Left, Direction::Right };
+    for (Uint32 index = 0; index < _count; index++)
+    {
+        if (_pAtCenter[index] == 0)
+        {
+            continue;
+        }
+
+        Direction current = (_pDX[index] < 0) ? Direction::Left : ((_pDX[index] > 0) ? Direction::Right :
+            ((_pDY[index] < 0) ? Direction::Up : Direction::Down));
+        Direction back = Opposite(current);
+        Uint16 row = static_cast<Uint16>(_pRow[index]);
+        Uint16 col = static_cast<Uint16>(_pCol[index]);
+
+        Direction exits[SDL_arraysize(directions)];
+        Uint32 cExits = 0;
+        for (size_t iDirection = 0; iDirection < SDL_arraysize(directions); iDirection++)
+        {
+            Uint16 nextRow = 0;
+            Uint16 nextCol = 0;
+            pMaze->GetNextCell(row, col, nextRow, nextCol, directions[iDirection]);
+            if ((directions[iDirection] != back) && !pMaze->IsTileSolid(nextRow, nextCol))
+            {
+                exits[cExits++] = directions[iDirection];
+            }
+        }
+
+        Direction next = (cExits > 0) ? exits[(cExits > 1) ? (NextRandom() % cExits) : 0] : back;
+        if (next != current)
+        {
+            float speed = static_cast<float>(SDL_fabs(_pDX[index] + _pDY[index]));
+            _pDX[index] = (next == Direction::Left) ? -speed : ((next == Direction::Right) ? speed : 0.0f);
+            _pDY[index] = (next == Direction::Up) ? -speed : ((next == Direction::Down) ? speed : 0.0f);
+        }
+    }
+}
+
+Uint32 EntityStore::NextRandom()
+{
+    _random ^= _random << 13;
+    _random ^= _random >> 17;
+    _random ^= _random << 5;
+    return _random;
+}
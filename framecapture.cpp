@@ -0,0 +1,190 @@
+#include "include/framecapture.h"
+#include "include/log.h"
+#include "include/constants.h"
+
+using namespace XplatGameTutorial::PacManClone;
+
+FrameCapture::FrameCapture() :
+    _pFile(nullptr),
+    _width(0),
+    _height(0),
+    _cPixels(0),
+    _encoding(Encoding::Delta),
+    _pPool(nullptr),
+    _pPrevious(nullptr),
+    _pScratch(nullptr),
+    _heldBuffer(c_noBuffer),
+    _fStopping(false),
+    _cCaptured(0),
+    _cDropped(0),
+    _cBytesWritten(0)
+{
+}
+
+FrameCapture::~FrameCapture()
+{
+    Close();
+}
+
+// Everything the capture will ever need is allocated here, so neither thread allocates afterwards
+bool FrameCapture::Open(const char *szFileName, int width, int height, Encoding encoding)
+{
+    SDL_assert(!IsOpen());
+    _pFile = fopen(szFileName, "wb");
+    if (_pFile == nullptr)
+    {
+        PMC_LOG_ERROR(LogCategory::Harness, "FrameCapture::Open() : unable to open %s", szFileName);
+        return false;
+    }
+
+    _width = width;
+    _height = height;
+    _cPixels = static_cast<Uint32>(width * height);
+    _encoding = encoding;
+    _pPool = new Uint32[_cPixels * c_poolSize];
+    _pPrevious = new Uint32[_cPixels]{};
+    // Worst case delta is every pixel a literal plus a run header for each
+    _pScratch = new Uint32[_cPixels * 3];
+
+    for (Uint32 index = 0; index < c_poolSize; index++)
+    {
+        _freeBuffers.TryPush(index);
+    }
+    _heldBuffer = c_noBuffer;
+
+    Uint32 header[] = { c_magic, c_version, static_cast<Uint32>(width), static_cast<Uint32>(height), Constants::FramesPerSecond };
+    fwrite(header, sizeof(header), 1, _pFile);
+
+    _cCaptured = 0;
+    _cDropped = 0;
+    _cBytesWritten = sizeof(header);
+    _fStopping = false;
+    _writer = std::thread(&FrameCapture::WriterThread, this);
+    PMC_LOG_INFO(LogCategory::Harness, "Capturing frames to %s (%s)", szFileName, (encoding == Encoding::Raw) ? "raw" : "delta");
+    return true;
+}
+
+// Only the writer pushes to _freeBuffers, so a buffer this thread took but couldn't fill is held on to for the
+// next frame rather than handed back
+void FrameCapture::Capture(SDL_Renderer *pSDLRenderer, Uint32 frameNumber)
+{
+    Uint32 bufferIndex = _heldBuffer;
+    if ((bufferIndex == c_noBuffer) && !_freeBuffers.TryPop(bufferIndex))
+    {
+        // Writer is behind - drop this frame instead of waiting on it
+        _cDropped++;
+        return;
+    }
+    _heldBuffer = c_noBuffer;
+
+    Uint32 *pBuffer = _pPool + (bufferIndex * _cPixels);
+    if (SDL_RenderReadPixels(pSDLRenderer, nullptr, SDL_PIXELFORMAT_ABGR8888, pBuffer, _width * sizeof(Uint32)) != 0)
+    {
+        PMC_LOG_ERROR(LogCategory::Render, "SDL_RenderReadPixels() failed, error = %s", SDL_GetError());
+        _heldBuffer = bufferIndex;
+        _cDropped++;
+        return;
+    }
+
+    // The queues are sized above the pool, so there is always room for a buffer we own
+    Slot slot = { bufferIndex, frameNumber };
+    _filledBuffers.TryPush(slot);
+    _cCaptured++;
+}
+
+void FrameCapture::Close()
+{
+    if (!IsOpen())
+    {
+        return;
+    }
+
+    // The writer drains whatever is queued before it notices the flag
+    _fStopping = true;
+    _writer.join();
+    fclose(_pFile);
+    _pFile = nullptr;
+
+    printf("Frame capture: %u frames written, %u dropped, %.1f MB\n", _cCaptured, _cDropped,
+        static_cast<double>(_cBytesWritten) / (1024.0 * 1024.0));
+
+    delete[] _pPool;
+    delete[] _pPrevious;
+    delete[] _pScratch;
+    _pPool = nullptr;
+    _pPrevious = nullptr;
+    _pScratch = nullptr;
+}
+
+void FrameCapture::WriterThread()
+{
+    Slot slot;
+    for (;;)
+    {
+        if (_filledBuffers.TryPop(slot))
+        {
+            WriteFrame(slot);
+            _freeBuffers.TryPush(slot.bufferIndex);
+        }
+        else if (_fStopping)
+        {
+            break;
+        }
+        else
+        {
+            // Nothing queued, a frame is 16ms away so there is no point spinning
+            SDL_Delay(1);
+        }
+    }
+}
+
+void FrameCapture::WriteFrame(const Slot &slot)
+{
+    const Uint32 *pFrame = _pPool + (slot.bufferIndex * _cPixels);
+    FrameRecord record = { slot.frameNumber, static_cast<Uint32>(_encoding), 0 };
+
+    if (_encoding == Encoding::Raw)
+    {
+        record.payloadBytes = _cPixels * sizeof(Uint32);
+        fwrite(&record, sizeof(record), 1, _pFile);
+        fwrite(pFrame, record.payloadBytes, 1, _pFile);
+    }
+    else
+    {
+        record.payloadBytes = EncodeDelta(pFrame) * sizeof(Uint32);
+        fwrite(&record, sizeof(record), 1, _pFile);
+        fwrite(_pScratch, record.payloadBytes, 1, _pFile);
+        SDL_memcpy(_pPrevious, pFrame, _cPixels * sizeof(Uint32));
+    }
+    _cBytesWritten += sizeof(record) + record.payloadBytes;
+}
+
+// XOR against the previous frame and run length encode the zeros (unchanged pixels).  Returns the
+// number of 32 bit words written to the scratch buffer
+Uint32 FrameCapture::EncodeDelta(const Uint32 *pFrame)
+{
+    Uint32 cOut = 0;
+    Uint32 index = 0;
+    while (index < _cPixels)
+    {
+        Uint32 zeroRun = 0;
+        while ((index < _cPixels) && (pFrame[index] == _pPrevious[index]))
+        {
+            zeroRun++;
+            index++;
+        }
+
+        // Reserve the literal count and fill it in once we know it
+        _pScratch[cOut++] = zeroRun;
+        Uint32 literalCountAt = cOut++;
+        Uint32 cLiterals = 0;
+        while ((index < _cPixels) && (pFrame[index] != _pPrevious[index]))
+        {
+            _pScratch[cOut++] = pFrame[index] ^ _pPrevious[index];
+            cLiterals++;
+            index++;
+        }
+        _pScratch[literalCountAt] = cLiterals;
+    }
+    return cOut;
+}
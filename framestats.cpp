@@ -0,0 +1,251 @@
+#include "include/framestats.h"
+#include "include/log.h"
+#include "include/constants.h"
+#include "include/metrics.h"
+
+using namespace XplatGameTutorial::PacManClone;
+
+const double FrameStats::c_sloFraction = 0.999;
+
+static double UsToMs(Uint32 us)
+{
+    return us / 1000.0;
+}
+
+void LatencyHistogram::Record(Uint32 us)
+{
+    _counts[BucketIndex(us)]++;
+    _count++;
+    _max = SDL_max(_max, us);
+}
+
+void LatencyHistogram::Reset()
+{
+    SDL_memset(_counts, 0, sizeof(_counts));
+    _count = 0;
+    _max = 0;
+}
+
+Uint32 LatencyHistogram::Percentile(double fraction) const
+{
+    if (_count == 0)
+    {
+        return 0;
+    }
+
+    Uint32 target = static_cast<Uint32>(fraction * _count + 0.999999);
+    target = SDL_max(1u, SDL_min(target, _count));
+    Uint32 cSeen = 0;
+    for (Uint32 index = 0; index < c_buckets; index++)
+    {
+        cSeen += _counts[index];
+        if (cSeen >= target)
+        {
+            return SDL_min(BucketTop(index), _max);
+        }
+    }
+    return _max;
+}
+
+// The first 2 * c_subBuckets values get a bucket each, after that every power of 2 is split into
+// c_subBuckets by the bits under the top one
+Uint32 LatencyHistogram::BucketIndex(Uint32 us)
+{
+    if (us < 2 * c_subBuckets)
+    {
+        return us;
+    }
+
+    Uint32 shift = static_cast<Uint32>(SDL_MostSignificantBitIndex32(us)) - c_subBucketBits;
+    return (shift + 1) * c_subBuckets + (us >> shift) - c_subBuckets;
+}
+
+Uint32 LatencyHistogram::BucketTop(Uint32 index)
+{
+    if (index < 2 * c_subBuckets)
+    {
+        return index;
+    }
+
+    Uint32 shift = index / c_subBuckets - 1;
+    Uint64 subBucket = (index % c_subBuckets) + c_subBuckets;
+    return static_cast<Uint32>(((subBucket + 1) << shift) - 1);
+}
+
+FrameStats::~FrameStats()
+{
+    Close();
+}
+
+bool FrameStats::Initialize(GlyphAtlas *pGlyphAtlas, Uint32 usBudget, const char *szCsvFile)
+{
+    _usBudget = usBudget;
+    for (Uint16 index = 0; index < c_cLabels; index++)
+    {
+        _labels[index].Initialize(pGlyphAtlas, 8, 8 + index * (GlyphAtlas::GlyphHeight + 4), TextAlign::Left,
+            (index == 0) ? Constants::TextColorYellow : Constants::TextColorWhite);
+    }
+    _labels[0].SetText("FRAME MS");
+    LayoutOverlay();
+
+    if (szCsvFile != nullptr)
+    {
+        _pCsvFile = fopen(szCsvFile, "w");
+        if (_pCsvFile == nullptr)
+        {
+            PMC_LOG_ERROR(LogCategory::Harness, "Failed to open %s for the frame times", szCsvFile);
+            return false;
+        }
+        fprintf(_pCsvFile, "second,frames,missed,frame_p50_ms,frame_p95_ms,frame_p99_ms,frame_max_ms,sim_p99_ms,present_p99_ms\n");
+    }
+    return true;
+}
+
+void FrameStats::AddFrame(Uint32 usFrame, Uint32 usSim, Uint32 usPresent)
+{
+    _frameTimes.Record(usFrame);
+    _simTimes.Record(usSim);
+    _presentTimes.Record(usPresent);
+    _secondFrameTimes.Record(usFrame);
+    _secondSimTimes.Record(usSim);
+    _secondPresentTimes.Record(usPresent);
+    _cFrames++;
+    if (usFrame > _usBudget)
+    {
+        _cMissed++;
+        _cSecondMissed++;
+        Metrics::FramesMissed.Add();
+    }
+    Metrics::Frames.Add();
+    Metrics::FrameTime.Record(usFrame);
+    Metrics::SimTime.Record(usSim);
+
+    _recentFrames[_iRecent] = usFrame;
+    _iRecent = (_iRecent + 1) % c_recentFrames;
+
+    _usSecondElapsed += usFrame;
+    if (_usSecondElapsed >= 1000000)
+    {
+        EndSecond();
+    }
+
+    if (_fOverlay && (++_cFramesSinceLayout >= Constants::FramesPerSecond / 4))
+    {
+        LayoutOverlay();
+    }
+}
+
+// One CSV row per second of frames, then start the next second
+void FrameStats::EndSecond()
+{
+    if (_pCsvFile != nullptr)
+    {
+        fprintf(_pCsvFile, "%u,%u,%u,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f\n", _iSecond, _secondFrameTimes.Count(), _cSecondMissed,
+            UsToMs(_secondFrameTimes.Percentile(0.50)), UsToMs(_secondFrameTimes.Percentile(0.95)),
+            UsToMs(_secondFrameTimes.Percentile(0.99)), UsToMs(_secondFrameTimes.Max()),
+            UsToMs(_secondSimTimes.Percentile(0.99)), UsToMs(_secondPresentTimes.Percentile(0.99)));
+        fflush(_pCsvFile);
+    }
+
+    _secondFrameTimes.Reset();
+    _secondSimTimes.Reset();
+    _secondPresentTimes.Reset();
+    _cSecondMissed = 0;
+    _usSecondElapsed = 0;
+    _iSecond++;
+}
+
+void FrameStats::LayoutOverlay()
+{
+    char szText[TextLabel::c_maxChars + 1];
+    SDL_snprintf(szText, SDL_arraysize(szText), "P50 %.1f", UsToMs(_frameTimes.Percentile(0.50)));
+    _labels[1].SetText(szText);
+    SDL_snprintf(szText, SDL_arraysize(szText), "P95 %.1f", UsToMs(_frameTimes.Percentile(0.95)));
+    _labels[2].SetText(szText);
+    SDL_snprintf(szText, SDL_arraysize(szText), "P99 %.1f", UsToMs(_frameTimes.Percentile(0.99)));
+    _labels[3].SetText(szText);
+    SDL_snprintf(szText, SDL_arraysize(szText), "MAX %.1f", UsToMs(_frameTimes.Max()));
+    _labels[4].SetText(szText);
+    SDL_snprintf(szText, SDL_arraysize(szText), "MISS %u", static_cast<Uint32>(_cMissed));
+    _labels[5].SetText(szText);
+    _cFramesSinceLayout = 0;
+}
+
+// The text, then a bar per recent frame under it - green in budget, red over, with a line at the budget.
+// Bars are scaled so twice the budget fills the graph
+void FrameStats::RenderOverlay(SDL_Renderer *pSDLRenderer)
+{
+    if (!_fOverlay)
+    {
+        return;
+    }
+
+    // The session leaves the clip on the maze, the overlay is in the margin
+    SDL_RenderSetClipRect(pSDLRenderer, nullptr);
+    for (Uint16 index = 0; index < c_cLabels; index++)
+    {
+        _labels[index].Render(pSDLRenderer);
+    }
+
+    const int cxBar = 2;
+    const int cyGraph = 48;
+    SDL_Rect graphRect = { 8, 8 + c_cLabels * (GlyphAtlas::GlyphHeight + 4) + 4, static_cast<int>(c_recentFrames) * cxBar, cyGraph };
+    SDL_SetRenderDrawBlendMode(pSDLRenderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(pSDLRenderer, 0, 0, 0, 160);
+    SDL_RenderFillRect(pSDLRenderer, &graphRect);
+
+    for (Uint32 index = 0; index < c_recentFrames; index++)
+    {
+        // Oldest on the left
+        Uint32 usFrame = _recentFrames[(_iRecent + index) % c_recentFrames];
+        int cyBar = static_cast<int>((static_cast<Uint64>(SDL_min(usFrame, 2 * _usBudget)) * cyGraph) / (2 * _usBudget));
+        SDL_Rect barRect = { graphRect.x + static_cast<int>(index) * cxBar, graphRect.y + cyGraph - cyBar, cxBar, cyBar };
+        if (usFrame > _usBudget)
+        {
+            SDL_SetRenderDrawColor(pSDLRenderer, 255, 0, 0, 255);
+        }
+        else
+        {
+            SDL_SetRenderDrawColor(pSDLRenderer, 0, 200, 0, 255);
+        }
+        SDL_RenderFillRect(pSDLRenderer, &barRect);
+    }
+
+    SDL_SetRenderDrawColor(pSDLRenderer, 255, 255, 0, 255);
+    SDL_RenderDrawLine(pSDLRenderer, graphRect.x, graphRect.y + cyGraph / 2, graphRect.x + graphRect.w - 1, graphRect.y + cyGraph / 2);
+
+    // Back to what RenderClear expects
+    SDL_SetRenderDrawBlendMode(pSDLRenderer, SDL_BLENDMODE_NONE);
+    SDL_SetRenderDrawColor(pSDLRenderer, Constants::RenderDrawColor.r, Constants::RenderDrawColor.g,
+        Constants::RenderDrawColor.b, Constants::RenderDrawColor.a);
+}
+
+void FrameStats::PrintSummary()
+{
+    if (_cFrames == 0)
+    {
+        return;
+    }
+
+    double fractionInBudget = static_cast<double>(_cFrames - _cMissed) / _cFrames;
+    printf("Frames: %llu, frame time p50 %.2fms p95 %.2fms p99 %.2fms p99.9 %.2fms max %.2fms\n",
+        static_cast<unsigned long long>(_cFrames), UsToMs(_frameTimes.Percentile(0.50)), UsToMs(_frameTimes.Percentile(0.95)),
+        UsToMs(_frameTimes.Percentile(0.99)), UsToMs(_frameTimes.Percentile(0.999)), UsToMs(_frameTimes.Max()));
+    printf("  sim p99 %.2fms, present p99 %.2fms\n", UsToMs(_simTimes.Percentile(0.99)), UsToMs(_presentTimes.Percentile(0.99)));
+    printf("  %llu missed the %.2fms budget, %.3f%% in budget - SLO %.1f%%: %s\n", static_cast<unsigned long long>(_cMissed),
+        UsToMs(_usBudget), fractionInBudget * 100.0, c_sloFraction * 100.0, (fractionInBudget >= c_sloFraction) ? "met" : "MISSED");
+}
+
+void FrameStats::Close()
+{
+    if (_pCsvFile != nullptr)
+    {
+        // The partial last second still counts
+        if (_secondFrameTimes.Count() > 0)
+        {
+            EndSecond();
+        }
+        fclose(_pCsvFile);
+        _pCsvFile = nullptr;
+    }
+}
@@ -1,25 +1,118 @@
 #include "include/gameharness.h"
+#include "include/golden.h"
+#include "include/bot.h"
+#include "include/alloccounter.h"
+#include "include/profiler.h"
+#include "include/perfcounters.h"
+#include "include/log.h"
+#include "include/metrics.h"
 
 using namespace XplatGameTutorial::PacManClone;
 
+static double CounterToMs(Uint64 counterDelta)
+{
+    return (counterDelta * 1000.0) / SDL_GetPerformanceFrequency();
+}
+
+static Uint32 CounterToUs(Uint64 counterDelta)
+{
+    return static_cast<Uint32>((counterDelta * 1000000) / SDL_GetPerformanceFrequency());
+}
+
 // Start up SDL and load our textures - the stuff we'll need for the entire process lifetime
-SDL_bool GameHarness::Initialize()
+SDL_bool GameHarness::Initialize(const GameOptions &options)
 {
     SDL_assert(_fInitialized == false);
+    PMC_ALLOC_PHASE("Startup");
     SDL_bool result = SDL_FALSE;
-    if (InitializeSDL(&_pSDLWindow, &_pSDLRenderer) == SDL_TRUE)
+    _options = options;
+
+    // A baked asset pack needs no decode at all.  Without one, kick off the image decode first so it overlaps
+    // SDL and window creation, and only the upload has to wait
+    _startCounter = SDL_GetPerformanceCounter();
+    bool fFromPack = (_options.pszPackFile != nullptr) && _assetPack.Open(_options.pszPackFile);
+    bool fDecoding = true;
+    int tilesAsset = -1;
+    int spritesAsset = -1;
+    if (!fFromPack)
     {
-        // Load our textures
         SDL_Color colorKey = Constants::SDLColorMagenta;
-        _pTilesTexture = new TextureWrapper(Constants::TilesImage, SDL_strlen(Constants::TilesImage), _pSDLRenderer, nullptr);
-        _pSpriteTexture = new TextureWrapper(Constants::SpritesImage, SDL_strlen(Constants::SpritesImage), _pSDLRenderer, &colorKey);
+        tilesAsset = _assetLoader.Add(Constants::TilesImage, nullptr);
+        spritesAsset = _assetLoader.Add(Constants::SpritesImage, &colorKey);
+        fDecoding = _assetLoader.StartDecode();
+    }
+
+    RendererSettings rendererSettings = { _options.pszRenderer, _options.fVSync, _options.pszScaleQuality };
+    bool fSDLReady = _options.fHeadless ?
+        InitializeOffscreenSDL(&_pSDLSurface, &_pSDLRenderer) :
+        InitializeSDL(&_pSDLWindow, &_pSDLRenderer, rendererSettings);
+    _msSDLInit = CounterToMs(SDL_GetPerformanceCounter() - _startCounter);
+    _assetLoader.WaitForDecode();
+
+    if (fSDLReady && fDecoding)
+    {
+        // Upload our textures, this part needs the renderer's thread.  The registry owns them from here on
+        Uint64 uploadCounter = SDL_GetPerformanceCounter();
+        _textureRegistry.Initialize(_pSDLRenderer, fFromPack ? &_assetPack : nullptr, _options.textureBudget);
+        bool fLevelReady = true;
+        if (fFromPack)
+        {
+            _tilesTexture = _textureRegistry.Acquire("tiles");
+            _spriteTexture = _textureRegistry.Acquire("sprites");
+            fLevelReady = LoadLevelFromPack();
+        }
+        else
+        {
+            _tilesTexture = _textureRegistry.Adopt("tiles", _assetLoader.CreateTexture(tilesAsset, _pSDLRenderer));
+            _spriteTexture = _textureRegistry.Adopt("sprites", _assetLoader.CreateTexture(spritesAsset, _pSDLRenderer));
+        }
+        _pGlyphAtlas = new GlyphAtlas();
+        bool fAtlasReady = _pGlyphAtlas->Initialize(_pSDLRenderer);
+        _msUpload = CounterToMs(SDL_GetPerformanceCounter() - uploadCounter);
 
-        if (_pTilesTexture->IsNull() || _pSpriteTexture->IsNull())
+        if (_tilesTexture.IsNull() || _spriteTexture.IsNull() || !fAtlasReady)
+        {
+            PMC_LOG_ERROR(LogCategory::Assets, "Failed to load one or more textures");
+        }
+        else if (!fLevelReady)
+        {
+            PMC_LOG_ERROR(LogCategory::Assets, "Failed to load the level from the asset pack");
+        }
+        else if ((_options.pszReplayFile != nullptr) && !_replay.Load(_options.pszReplayFile))
+        {
+            PMC_LOG_ERROR(LogCategory::Harness, "Failed to load replay");
+        }
+        else if (((_options.pszChecksumFile != nullptr) && !_checksumLog.Create(_options.pszChecksumFile)) ||
+            ((_options.pszChecksumVerifyFile != nullptr) && !_expectedChecksums.Load(_options.pszChecksumVerifyFile)))
+        {
+            PMC_LOG_ERROR(LogCategory::Harness, "Failed to open the checksum logs");
+        }
+        else if ((_options.pszCaptureFile != nullptr) && !_capture.Open(_options.pszCaptureFile,
+            Constants::ScreenWidth, Constants::ScreenHeight, _options.fCaptureRaw ? FrameCapture::Encoding::Raw : FrameCapture::Encoding::Delta))
+        {
+            PMC_LOG_ERROR(LogCategory::Harness, "Failed to start frame capture");
+        }
+        else if (!_frameStats.Initialize(_pGlyphAtlas, _options.frameBudget, _options.pszFrameCsvFile))
         {
-            printf("Failed to load one or more textures\n");
+            PMC_LOG_ERROR(LogCategory::Harness, "Failed to start the frame time log");
         }
         else
         {
+            _frameStats.SetOverlay(_options.fFrameOverlay);
+            _session.Initialize(_tilesTexture, _spriteTexture, _pGlyphAtlas);
+            _session.SetTickAnimation(_options.fTickAnimation);
+            _session.SetStressEntities(_options.cStressEntities);
+            _session.SetModGhosts(_options.cModGhosts);
+            if (_options.fPerfCounters)
+            {
+                // Not having them isn't fatal, the game just runs without
+                PerfCounters::Open();
+            }
+            if (_options.pszMetricsTarget != nullptr)
+            {
+                // Same here, a soak run is still worth having without its telemetry
+                Metrics::StartExport(_options.pszMetricsTarget, _options.msMetricsInterval);
+            }
             _fInitialized = true;
             result = SDL_TRUE;
         }
@@ -27,57 +120,100 @@ SDL_bool GameHarness::Initialize()
     return result;
 }
 
-// Main loop, process window messages and dispatch to the current GameState handler
-void GameHarness::Run()
+// The pack's level and tile layout replace the built in ones.  The session reads the tiles straight out of
+// the mapping, so the pack stays open until Cleanup()
+bool GameHarness::LoadLevelFromPack()
+{
+    Uint32 cbLevel = 0;
+    Uint32 cols = 0;
+    Uint32 rows = 0;
+    Uint32 cbAtlas = 0;
+    const Uint16 *pLevelTiles = static_cast<const Uint16*>(_assetPack.Find("level1", AssetPack::EntryType::LevelTiles, &cbLevel, &cols, &rows));
+    const AssetPack::TileAtlasInfo *pAtlas = static_cast<const AssetPack::TileAtlasInfo*>(
+        _assetPack.Find("tiles.atlas", AssetPack::EntryType::TileAtlas, &cbAtlas, nullptr, nullptr));
+
+    if ((pLevelTiles == nullptr) || (cols != Constants::MapCols) || (rows != Constants::MapRows) ||
+        (cbLevel != Constants::MapRows * Constants::MapCols * sizeof(Uint16)) || (pAtlas == nullptr) || (cbAtlas != sizeof(*pAtlas)))
+    {
+        return false;
+    }
+
+    SDL_Rect textureRect = { 0, 0, static_cast<int>(pAtlas->textureWidth), static_cast<int>(pAtlas->textureHeight) };
+    SDL_Rect tileRect = { 0, 0, static_cast<int>(pAtlas->tileWidth), static_cast<int>(pAtlas->tileHeight) };
+    _session.SetLevel(pLevelTiles, textureRect, tileRect);
+    return true;
+}
+
+int GameHarness::Run()
 {
     SDL_assert(_fInitialized);
-    static bool fQuit = false;
+    PMC_PROFILE_THREAD("main");
+    int exitCode = 0;
+    if (_options.fAllocCheck)
+    {
+        exitCode = RunAllocCheck();
+    }
+    else if (_options.fLookaheadCheck)
+    {
+        exitCode = RunLookaheadCheck();
+    }
+    else if (_options.cMosaicInstances != 0)
+    {
+        exitCode = RunMosaic();
+    }
+    else
+    {
+        exitCode = _options.fHeadless ? RunHeadless() : RunWindowed();
+    }
+
+    if (_options.pszRecordFile != nullptr)
+    {
+        _replay.Save(_options.pszRecordFile);
+    }
+
+    // cleanup
+    Cleanup();
+    return exitCode;
+}
+
+// Main loop, process window messages, step the session and keep to the frame rate
+int GameHarness::RunWindowed()
+{
+    int exitCode = 0;
+    bool fQuit = false;
     SDL_Event eventSDL;
 
     Uint32 startTicks;
     while (!fQuit)
     {
+        PMC_PROFILE_ZONE("Frame");
+        Uint64 frameCounter = SDL_GetPerformanceCounter();
         startTicks = SDL_GetTicks();
         while (SDL_PollEvent(&eventSDL) != 0)
         {
-            if (eventSDL.type == SDL_QUIT)
-            {
-                fQuit = true;
-            }
+            fQuit |= HandleEvent(eventSDL);
+        }
+
+        // INPUT - from the keyboard, or from the replay if we're playing one back
+        Direction inputDirection = Direction::None;
+        fQuit |= ProcessInput(&inputDirection);
+        if (_options.pszReplayFile != nullptr)
+        {
+            inputDirection = _replay.InputAt(_session.TickCount());
         }
 
         if (!fQuit)
         {
-            switch (_state)
+            if (_options.pszRecordFile != nullptr)
             {
-            case GameState::Title:
-                // Skipping this for now
-                _state = GameState::LoadingLevel;
-                break;
-            case GameState::LoadingLevel:
-                // Loads the current maze and the sprites if needed
-                _state = OnLoading();
-                break;
-            case GameState::WaitingToStartLevel:
-                // Small delay before level starts
-                _state = OnWaitingToStartLevel();
-                break;
-            case GameState::Running:
-                // Normal gameplay
-                _state = OnRunning();
-                break;
-            case GameState::PlayerDying:
-                // Death animation, skip for now since no ghosts
-                break;
-            case GameState::LevelComplete:
-                // Flashing level animation
-                _state = OnLevelComplete();
-                break;
-            case GameState::GameOver:
-                // Final drawing of level, score, etc
-                break;
-            case GameState::Exiting:
-                fQuit = true;
+                _replay.Record(inputDirection);
+            }
+            Uint64 simCounter = SDL_GetPerformanceCounter();
+            _session.Tick(inputDirection);
+            Uint32 usSim = CounterToUs(SDL_GetPerformanceCounter() - simCounter);
+            if (!CheckTick())
+            {
+                exitCode = 1;
                 break;
             }
 
@@ -90,57 +226,314 @@ void GameHarness::Run()
             Uint32 elapsedTicks = endTicks - startTicks;
             if (elapsedTicks < Constants::TicksPerFrame)
             {
+                PMC_PROFILE_ZONE("Sleep");
                 SDL_Delay(Constants::TicksPerFrame - elapsedTicks);
             }
+            _frameStats.AddFrame(CounterToUs(SDL_GetPerformanceCounter() - frameCounter), usSim, _usLastPresent);
         }
     }
+    return exitCode;
+}
 
-    // cleanup
-    Cleanup();
+// Runs the replay flat out with no window.  Only the ticks being checked against golden images are
+// rendered, the rest are pure simulation, which is what lets a whole replay be verified in seconds.
+// Returns non zero if any frame failed to match.
+int GameHarness::RunHeadless()
+{
+    Uint32 totalTicks = (_options.maxTicks != 0) ? _options.maxTicks : _replay.Length();
+    Uint32 cFramesChecked = 0;
+    Uint32 cFramesFailed = 0;
+    char szGolden[512];
+
+    PMC_LOG_INFO(LogCategory::Harness, "Running %u ticks headless...", totalTicks);
+    Uint64 startCounter = SDL_GetPerformanceCounter();
+    for (Uint32 tick = 0; tick < totalTicks; tick++)
+    {
+        Direction inputDirection = _replay.InputAt(tick);
+        if (_options.pszRecordFile != nullptr)
+        {
+            _replay.Record(inputDirection);
+        }
+        _session.Tick(inputDirection);
+        if (!CheckTick())
+        {
+            cFramesFailed++;
+            totalTicks = tick + 1;
+            break;
+        }
+
+        bool fGoldenTick = (_options.pszGoldenDir != nullptr) && ((tick % _options.goldenEvery) == 0);
+        if (fGoldenTick || _capture.IsOpen())
+        {
+            Render();
+        }
+
+        if (fGoldenTick)
+        {
+            GoldenImage::FileNameForTick(_options.pszGoldenDir, tick, szGolden, SDL_arraysize(szGolden));
+            if (_options.fGoldenWrite)
+            {
+                cFramesFailed += GoldenImage::Save(_pSDLSurface, szGolden) ? 0 : 1;
+            }
+            else
+            {
+                GoldenResult result;
+                bool fLoaded = GoldenImage::Compare(_pSDLSurface, szGolden, _options.goldenTolerance, &result);
+                if (!fLoaded || (result.cPixelsDifferent > _options.goldenMaxPixels))
+                {
+                    PMC_LOG_ERROR(LogCategory::Render, "tick %u: MISMATCH %u pixels over tolerance (max channel delta %u) vs %s",
+                        tick, result.cPixelsDifferent, result.maxChannelDelta, szGolden);
+                    cFramesFailed++;
+                }
+            }
+            cFramesChecked++;
+        }
+    }
+
+    double seconds = static_cast<double>(SDL_GetPerformanceCounter() - startCounter) / SDL_GetPerformanceFrequency();
+    printf("%u ticks in %.3fs (%.0f ticks/s), %u frames %s, %u failed\n", totalTicks, seconds,
+        (seconds > 0.0) ? totalTicks / seconds : 0.0, cFramesChecked, _options.fGoldenWrite ? "written" : "checked", cFramesFailed);
+    return (cFramesFailed == 0) ? 0 : 1;
+}
+
+// Many bot driven sessions in one window.  The sessions run on the mosaic's own thread, this loop only
+// draws whatever they last published at the normal frame rate
+int GameHarness::RunMosaic()
+{
+    Mosaic mosaic;
+    SDL_Rect viewRect = { 0, 0, Constants::ScreenWidth, Constants::ScreenHeight };
+    mosaic.Initialize(_options.cMosaicInstances, _pSDLRenderer, _tilesTexture, _spriteTexture, viewRect);
+    mosaic.Start();
+
+    bool fQuit = false;
+    SDL_Event eventSDL;
+    Uint32 cFrames = 0;
+    Uint32 firstTicks = SDL_GetTicks();
+    while (!fQuit)
+    {
+        PMC_PROFILE_ZONE("Frame");
+        Uint64 frameCounter = SDL_GetPerformanceCounter();
+        Uint32 startTicks = SDL_GetTicks();
+        while (SDL_PollEvent(&eventSDL) != 0)
+        {
+            fQuit |= HandleEvent(eventSDL);
+        }
+
+        Direction unused;
+        fQuit |= ProcessInput(&unused);
+
+        SDL_RenderClear(_pSDLRenderer);
+        {
+            PMC_PROFILE_ZONE("Mosaic::Render");
+            mosaic.Render(_pSDLRenderer);
+        }
+        if (_capture.IsOpen())
+        {
+            _capture.Capture(_pSDLRenderer, cFrames);
+        }
+        _frameStats.RenderOverlay(_pSDLRenderer);
+        {
+            PMC_PROFILE_ZONE("SDL_RenderPresent");
+            Uint64 presentCounter = SDL_GetPerformanceCounter();
+            SDL_RenderPresent(_pSDLRenderer);
+            _usLastPresent = CounterToUs(SDL_GetPerformanceCounter() - presentCounter);
+        }
+        if (cFrames == 0)
+        {
+            _fFirstFramePresented = true;
+            PrintTimeToFirstFrame();
+        }
+        cFrames++;
+
+        Uint32 elapsedTicks = SDL_GetTicks() - startTicks;
+        if (elapsedTicks < Constants::TicksPerFrame)
+        {
+            PMC_PROFILE_ZONE("Sleep");
+            SDL_Delay(Constants::TicksPerFrame - elapsedTicks);
+        }
+        // The games tick on their own thread, the main loop has no sim time of its own
+        _frameStats.AddFrame(CounterToUs(SDL_GetPerformanceCounter() - frameCounter), 0, _usLastPresent);
+    }
+
+    mosaic.Stop();
+    double seconds = (SDL_GetTicks() - firstTicks) / 1000.0;
+    if (seconds > 0.0)
+    {
+        printf("Mosaic: %.1f frames/s drawn, %.1f ticks/s per game\n", cFrames / seconds, mosaic.SimTicks() / seconds);
+    }
+    return 0;
+}
+
+// Self check that the steady state never touches the heap.  A bot plays the first level long enough for
+// everything that is created once (maze, sprites) to exist, then the level is restarted over and over with a
+// stretch of play after each restart, counting this thread's allocations across both.  The mod ghosts are
+// always in play so their batched update is covered too.  Returns non zero if either path allocated
+int GameHarness::RunAllocCheck()
+{
+    const Uint32 c_warmupTicks = 600;
+    const Uint32 c_restarts = 200;
+    const Uint32 c_ticksPerRestart = 600;      // Short of clearing the level, so this is restarts and running only
+
+    _session.SetModGhosts(Constants::MaxModGhosts);   // Spawned with the first level, during the warm up
+    PelletBot bot;
+    for (Uint32 tick = 0; tick < c_warmupTicks; tick++)
+    {
+        _session.Tick(bot.ChooseInput(_session));
+    }
+
+    Uint64 cRestartAllocations = 0;
+    Uint64 cRunningAllocations = 0;
+    for (Uint32 restart = 0; restart < c_restarts; restart++)
+    {
+        Uint64 cBefore = AllocationCounter::ThreadCount();
+        _session.RestartLevel();
+        cRestartAllocations += AllocationCounter::ThreadCount() - cBefore;
+
+        cBefore = AllocationCounter::ThreadCount();
+        for (Uint32 tick = 0; tick < c_ticksPerRestart; tick++)
+        {
+            _session.Tick(bot.ChooseInput(_session));
+        }
+        cRunningAllocations += AllocationCounter::ThreadCount() - cBefore;
+    }
+
+    printf("Allocation check: %u restarts, %u ticks - %llu allocations restarting, %llu running\n", c_restarts,
+        c_restarts * c_ticksPerRestart, static_cast<unsigned long long>(cRestartAllocations), static_cast<unsigned long long>(cRunningAllocations));
+    return ((cRestartAllocations == 0) && (cRunningAllocations == 0)) ? 0 : 1;
+}
+
+// Self check for deciding more than one cell ahead.  For each lookahead the ring holds, a bot plays from a
+// restarted level while every queued decision of every ghost is checked against the one before it: a ghost may never
+// be sent straight back the way it arrives.  Returns non zero if any decision was
+int GameHarness::RunLookaheadCheck()
+{
+    const Uint8 c_lookaheads[] = { 2, 3 };
+    const Uint32 c_ticksPerLookahead = 20000;
+
+    // The mod ghosts too, so targeting other than Blinky's is covered
+    _session.SetModGhosts(Constants::MaxModGhosts);
+    Uint32 cReversals = 0;
+    for (Uint8 lookahead : c_lookaheads)
+    {
+        PelletBot bot;
+        _session.SetGhostLookahead(lookahead);
+        _session.RestartLevel();
+        Uint32 cLookaheadReversals = 0;
+        for (Uint32 tick = 0; tick < c_ticksPerLookahead; tick++)
+        {
+            _session.Tick(bot.ChooseInput(_session));
+            if (_session.HasReversedGhostDecision())
+            {
+                cLookaheadReversals++;
+            }
+        }
+        printf("Lookahead check: lookahead %u, %u ticks - %u ticks with a reversed decision\n", lookahead,
+            c_ticksPerLookahead, cLookaheadReversals);
+        cReversals += cLookaheadReversals;
+    }
+    _session.SetGhostLookahead(Constants::GhostLookahead);
+    return (cReversals == 0) ? 0 : 1;
+}
+
+// After every tick of the windowed and headless loops: appends the state checksum to the log being written
+// and checks it against the expected log while that has ticks left.  Returns false at a divergence
+bool GameHarness::CheckTick()
+{
+    bool fWriting = (_options.pszChecksumFile != nullptr);
+    bool fVerifying = (_expectedChecksums.Length() > 0);
+    if (!fWriting && !fVerifying)
+    {
+        return true;
+    }
+
+    StateChecksum checksum;
+    _session.Checksum(&checksum);
+    _checksumLog.Append(checksum);
+
+    Uint32 tick = _session.TickCount() - 1;
+    if (fVerifying && (tick < _expectedChecksums.Length()) &&
+        ChecksumLog::ReportDivergence(tick, _expectedChecksums.At(tick), checksum))
+    {
+        return false;
+    }
+    return true;
 }
 
 void GameHarness::Cleanup()
 {
     SDL_assert(_fInitialized);
-    SafeDelete<TextureWrapper>(_pTilesTexture);
-    SafeDelete<TextureWrapper>(_pSpriteTexture);
-    SafeDelete<Maze>(_pMaze);
-    SafeDelete<Player>(_pPlayer);
-    SafeDelete<Blinky>(_pBlinky);
+    PMC_ALLOC_PHASE("Shutdown");
+    _capture.Close();
+    _checksumLog.Close();
+    Metrics::StopExport();
+    if (_options.pszTraceFile != nullptr)
+    {
+        WriteTrace();
+    }
+    PerfCounters::PrintReport();
+    PerfCounters::Close();
+    AllocationTracker::PrintReport();
+    _session.Entities().PrintStats();
+    _frameStats.PrintSummary();
+    _frameStats.Close();
+    _textureRegistry.PrintReport();
+    _session.ReleaseTextures();
+    _tilesTexture.Reset();
+    _spriteTexture.Reset();
+    _textureRegistry.Clear();
+    SafeDelete<GlyphAtlas>(_pGlyphAtlas);
+    _assetPack.Close();
 
     SDL_DestroyRenderer(_pSDLRenderer);
     _pSDLRenderer = nullptr;
 
-    SDL_DestroyWindow(_pSDLWindow);
-    _pSDLWindow = nullptr;
+    if (_pSDLWindow != nullptr)
+    {
+        SDL_DestroyWindow(_pSDLWindow);
+        _pSDLWindow = nullptr;
+    }
+
+    if (_pSDLSurface != nullptr)
+    {
+        SDL_FreeSurface(_pSDLSurface);
+        _pSDLSurface = nullptr;
+    }
 
     IMG_Quit();
     SDL_Quit();
     _fInitialized = false;
 }
 
-void GameHarness::InitializeSprites()
+// Window events for the windowed loops, returns true to quit
+bool GameHarness::HandleEvent(const SDL_Event &eventSDL)
 {
-    SDL_assert(_fInitialized);
-    
-    if (_pPlayer == nullptr)
+    if (eventSDL.type == SDL_QUIT)
     {
-        _pPlayer = new Player(_pSpriteTexture);
-        _pPlayer->Initialize();
+        return true;
     }
-    _pPlayer->Reset(_pMaze);
 
-    if (_pBlinky == nullptr)
+    if (eventSDL.type == SDL_KEYDOWN)
     {
-        _pBlinky = new Blinky(_pSpriteTexture);
-        _pBlinky->Initialize();
+        switch (eventSDL.key.keysym.scancode)
+        {
+        case SDL_SCANCODE_F3:
+            _frameStats.ToggleOverlay();
+            break;
+        case SDL_SCANCODE_F9:
+            WriteTrace();
+            break;
+        default:
+            break;
+        }
     }
-    _pBlinky->Reset(_pMaze);
+    return false;
 }
 
-// Record key presses we care about
+// Record key presses we care about, returns true if we should exit
 bool GameHarness::ProcessInput(Direction *pInputDirection)
 {
+    PMC_PROFILE_ZONE("ProcessInput");
+    PMC_ALLOC_PHASE("Input");
     *pInputDirection = Direction::None;
     bool fResult = false;
 
@@ -165,160 +558,70 @@ bool GameHarness::ProcessInput(Direction *pInputDirection)
     }
     else if (pCurrentKeyState[SDL_SCANCODE_ESCAPE])
     {
-        printf("ESC hit - exiting main loop...\n");
+        PMC_LOG_INFO(LogCategory::Harness, "ESC hit - exiting main loop...");
         fResult = true;
     }
     return fResult;
 }
 
-Uint16 GameHarness::HandlePelletCollision()
-{
-    Uint16 ret = 0;
-    SDL_Point playerPoint = { static_cast<int>(_pPlayer->X()), static_cast<int>(_pPlayer->Y()) };
-    Uint16 row = 0;
-    Uint16 col = 0;
-    _pMaze->GetTileRowCol(playerPoint, row, col);
-
-    if (_pMaze->IsTilePellet(row, col))
-    {
-        _pMaze->EatPellet(row, col);
-        ret++;
-    }
-    return ret;
-}
-
 void GameHarness::Render()
 {
+    PMC_PROFILE_ZONE("GameHarness::Render");
+    PMC_ALLOC_PHASE("Render");
     SDL_RenderClear(_pSDLRenderer);
-    if (_pMaze != nullptr)
     {
-        _pMaze->Render(_pSDLRenderer);
+        PerfPhaseScope phase(PerfPhase::Render);
+        _session.Render(_pSDLRenderer);
     }
 
-    if (_pPlayer != nullptr)
+    // Grab the finished frame before it is presented, this never waits on the writer
+    if (_capture.IsOpen())
     {
-        _pPlayer->Render(_pSDLRenderer);
+        _capture.Capture(_pSDLRenderer, _session.TickCount());
     }
 
-    if (_pBlinky != nullptr)
+    // Offscreen the surface already holds the finished frame.  The overlay goes on after the capture, it
+    // isn't part of the game
+    if (_pSDLWindow != nullptr)
     {
-        _pBlinky->Render(_pSDLRenderer);
+        _frameStats.RenderOverlay(_pSDLRenderer);
+        PMC_PROFILE_ZONE("SDL_RenderPresent");
+        Uint64 presentCounter = SDL_GetPerformanceCounter();
+        SDL_RenderPresent(_pSDLRenderer);
+        _usLastPresent = CounterToUs(SDL_GetPerformanceCounter() - presentCounter);
     }
 
-    SDL_RenderPresent(_pSDLRenderer);
-}
-
-GameHarness::GameState GameHarness::OnLoading()
-{
-    // This should be know, but it should also match what we just queried
-    SDL_assert(_pTilesTexture->Width() == Constants::TileTextureWidth);
-    SDL_assert(_pTilesTexture->Height() == Constants::TileTextureHeight);
-    SDL_Rect textureRect{ 0, 0, Constants::TileTextureWidth, Constants::TileTextureHeight };
-
-    SDL_SetTextureColorMod(_pTilesTexture->Ptr(), 255, 255, 255);
-
-    // Initialize our tiled map object
-    SafeDelete(_pMaze);
-    _pMaze = new Maze(Constants::MapRows, Constants::MapCols, Constants::ScreenWidth, Constants::ScreenHeight);
-
-    _pMaze->Initialize(textureRect, { 0, 0,  Constants::TileWidth,  Constants::TileHeight }, _pTilesTexture->Ptr(),
-        Constants::MapIndicies, Constants::MapRows *  Constants::MapCols);
-
-    // Clip around the maze so nothing draws there (this will help with the wrap around for example)
-    SDL_Rect mapBounds = _pMaze->GetMapBounds();
-    if (SDL_RenderSetClipRect(_pSDLRenderer, &mapBounds) != 0)
-    {
-        printf("SDL_RenderSetClipRect() failed, error = %s\n", SDL_GetError());
-    }
-    else
+    if (!_fFirstFramePresented)
     {
-        // Initialize our sprites
-        InitializeSprites();
+        _fFirstFramePresented = true;
+        PrintTimeToFirstFrame();
     }
-    return GameState::WaitingToStartLevel;
 }
 
-// This is the traditional delay before the level starts, normally you hear the little
-// tune that signals play is about to begin, then you transition.  We have no sound yet
-// so just delay the game a bit
-GameHarness::GameState GameHarness::OnWaitingToStartLevel()
+// Cold start report, from the top of Initialize() to the first finished frame
+void GameHarness::PrintTimeToFirstFrame()
 {
-    static StateTimer timer;
-    
-    if (!timer.IsStarted())
-    {
-        timer.Start(Constants::LevelLoadDelay);
-    }
-
-    if (timer.IsDone())
+    printf("Time to first frame: %.2fms\n", CounterToMs(SDL_GetPerformanceCounter() - _startCounter));
+    printf("  SDL + window init: %.2fms\n", _msSDLInit);
+    if (_assetPack.IsOpen())
     {
-        timer.Reset();
-        return GameState::Running;
-    }
-    return GameState::WaitingToStartLevel;
-}
-
-// Normal game play, check for collisions, update based on input, eventually the ghosts
-// and their updates will need to be in here as well.  
-GameHarness::GameState GameHarness::OnRunning()
-{
-    static Uint16 pelletsEaten = 0;
-    GameState stateResult = GameState::Running;
-
-    // INPUT
-    Direction inputDirection = Direction::None;
-    bool fQuit = ProcessInput(&inputDirection);
-    if (!fQuit)
-    {
-        // UPDATE
-        _pPlayer->Update(_pMaze, inputDirection); 
-        _pBlinky->Update(_pPlayer, _pMaze);
-        
-        // COLLISIONS
-        pelletsEaten += HandlePelletCollision();
-        if (pelletsEaten == Constants::TotalPellets)
-        {
-            pelletsEaten = 0;
-            return GameState::LevelComplete;
-        }
+        printf("  decode: none, textures from the asset pack\n");
     }
     else
     {
-        // Input told us to exit above
-        stateResult = GameState::Exiting;
+        _assetLoader.PrintDecodeTimes();
     }
-    return stateResult;
+    printf("  texture upload: %.2fms\n", _msUpload);
 }
 
-// All 244 pellets have been eaten, so we briefly flash the screen before moving to the
-// next level.  We only have the one level, so it just restarts
-GameHarness::GameState GameHarness::OnLevelComplete()
+// On exit with --trace, or F9 at any time (to pmc_trace.json without --trace).  Without PMC_PROFILER there
+// are no zones to write
+void GameHarness::WriteTrace()
 {
-    static StateTimer timer;
-    static Uint16 counter = 0;
-    static bool flip;
-
-    if (!timer.IsStarted())
-    {
-        counter = 0;
-        flip = false;
-        timer.Start(Constants::LevelCompleteDelay);
-    }
-    
-    if (counter++ > 60)
-    {
-        counter = 0;
-        flip = !flip;
-    }
-
-    // This will add a blue multiplier to the texture, making the shade chage.
-    // We flip this back and forth roughly every second until the overall timer is done.
-    SDL_SetTextureColorMod(_pTilesTexture->Ptr(), 255, 255, flip ? 100 : 255);
-    
-    if (timer.IsDone())
+    if (!Profiler::IsCompiledIn())
     {
-        timer.Reset();
-        return GameState::LoadingLevel;
+        PMC_LOG_WARNING(LogCategory::Harness, "Built without the profiler (make PROFILER=1), no trace to write");
+        return;
     }
-    return GameState::LevelComplete;
+    Profiler::WriteChromeTrace((_options.pszTraceFile != nullptr) ? _options.pszTraceFile : "pmc_trace.json");
 }
@@ -0,0 +1,601 @@
+#include "include/gamesession.h"
+#include "include/log.h"
+#include "include/profiler.h"
+#include "include/perfcounters.h"
+#include "include/alloccounter.h"
+#include <utility>
+
+using namespace XplatGameTutorial::PacManClone;
+
+namespace
+{
+    // Cells the corner patrolling mod ghosts head for, { col, row }
+    SDL_Point s_modGhostCells[] = { { 1, 4 }, { 26, 32 }, { 26, 4 } };
+}
+
+GameSession::~GameSession()
+{
+    FinishPrefetch();
+    SafeDelete<Maze>(_pNextMaze);
+    SafeDelete<Maze>(_pMaze);
+    SafeDelete<Player>(_pPlayer);
+    SafeDelete<Blinky>(_pBlinky);
+    for (ConfigurableGhost *&pGhost : _modGhosts)
+    {
+        SafeDelete<ConfigurableGhost>(pGhost);
+    }
+    Metrics::Sessions.Add(-1);
+}
+
+void GameSession::Initialize(const TextureHandle &tilesTexture, const TextureHandle &spriteTexture, GlyphAtlas *pGlyphAtlas)
+{
+    _tilesTexture = tilesTexture;
+    _spriteTexture = spriteTexture;
+    _pGlyphAtlas = pGlyphAtlas;
+
+    // The HUD sits in the empty rows at the top of the maze and the open row under the ghost pen,
+    // laid out on the tile grid like the arcade
+    int xMap = (Constants::ScreenWidth - (Constants::MapCols * Constants::TileWidth)) / 2;
+    int yMap = (Constants::ScreenHeight - (Constants::MapRows * Constants::TileHeight)) / 2;
+    auto TileX = [xMap](int col) { return xMap + col * Constants::TileWidth; };
+    auto TileY = [yMap](int row) { return yMap + row * Constants::TileHeight; };
+
+    _oneUpLabel.Initialize(pGlyphAtlas, TileX(3), TileY(0), TextAlign::Left, Constants::TextColorWhite);
+    _scoreLabel.Initialize(pGlyphAtlas, TileX(7), TileY(1), TextAlign::Right, Constants::TextColorWhite);
+    _highScoreTitleLabel.Initialize(pGlyphAtlas, TileX(9), TileY(0), TextAlign::Left, Constants::TextColorWhite);
+    _highScoreLabel.Initialize(pGlyphAtlas, TileX(17), TileY(1), TextAlign::Right, Constants::TextColorWhite);
+    _readyLabel.Initialize(pGlyphAtlas, TileX(11), TileY(20), TextAlign::Left, Constants::TextColorYellow);
+
+    _oneUpLabel.SetText("1UP");
+    _highScoreTitleLabel.SetText("HIGH SCORE");
+    _readyLabel.SetText("READY!");
+    _scoreLabel.SetNumber(_score);
+    _highScoreLabel.SetNumber(_highScore);
+}
+
+// The sprites still hold the raw sprite texture, they are only ever used again through Tick() and Render()
+void GameSession::ReleaseTextures()
+{
+    FinishPrefetch();
+    _tilesTexture.Reset();
+    _spriteTexture.Reset();
+}
+
+void GameSession::SetLevel(const Uint16 *pMapIndicies, SDL_Rect textureRect, SDL_Rect tileRect)
+{
+    _pLevelTiles = pMapIndicies;
+    _levelTextureRect = textureRect;
+    _levelTileRect = tileRect;
+}
+
+// Dispatch to the current GameState handler.  Everything the handlers (and the sprites under them)
+// read from the GameClock sees this session's time, which moves exactly one frame per tick.  Tick animated
+// sprites read it again when drawn, so Render() and Snapshot() belong on the thread that ticks the session
+void GameSession::Tick(Direction inputDirection)
+{
+    PMC_PROFILE_ZONE("GameSession::Tick");
+    SDL_assert(!_tilesTexture.IsNull());
+    GameClock::Set(_simTicks, _tickCount);
+    Metrics::Ticks.Add();
+
+    switch (_state)
+    {
+    case GameState::Title:
+        // Skipping this for now
+        _state = GameState::LoadingLevel;
+        break;
+    case GameState::LoadingLevel:
+        // Loads the current maze and the sprites if needed
+        _state = OnLoading();
+        break;
+    case GameState::WaitingToStartLevel:
+        // Small delay before level starts
+        _state = OnWaitingToStartLevel();
+        break;
+    case GameState::Running:
+        // Normal gameplay
+        _state = OnRunning(inputDirection);
+        break;
+    case GameState::PlayerDying:
+        // Death animation, skip for now since no ghosts
+        break;
+    case GameState::LevelComplete:
+        // Flashing level animation
+        _state = OnLevelComplete();
+        break;
+    case GameState::GameOver:
+        // Final drawing of level, score, etc
+        break;
+    }
+
+    _simTicks += Constants::TicksPerFrame;
+    _tickCount++;
+}
+
+void GameSession::Render(SDL_Renderer *pSDLRenderer)
+{
+    if (_pMaze != nullptr)
+    {
+        // Clip around the maze so nothing draws there (this will help with the wrap around for example)
+        SDL_Rect mapBounds = _pMaze->GetMapBounds();
+        if (SDL_RenderSetClipRect(pSDLRenderer, &mapBounds) != 0)
+        {
+            PMC_LOG_ERROR(LogCategory::Render, "SDL_RenderSetClipRect() failed, error = %s", SDL_GetError());
+        }
+
+        // This will add a blue multiplier to the texture, making the shade chage.  The texture may be
+        // shared with other sessions, so the tint is applied every time we draw rather than left set
+        SDL_SetTextureColorMod(_tilesTexture.Get()->Ptr(), 255, 255, _fFlashTiles ? 100 : 255);
+        PMC_PROFILE_ZONE("TiledMap::Render");
+        _pMaze->Render(pSDLRenderer);
+    }
+
+    if (_entities.Count() > 0)
+    {
+        // They all wear Blinky's first frame, it is the motion being stressed rather than the drawing
+        const AnimationSet &set = AnimationLibrary::Get().Blinky();
+        const SDL_Rect &frameRect = set.frames[set.sequences[Constants::AnimationIndexLeft].pFrames[0]];
+        PMC_PROFILE_ZONE("EntityStore::Render");
+        _entities.Render(pSDLRenderer, _spriteTexture.Get()->Ptr(), frameRect, set.xFrameOffset, set.yFrameOffset);
+    }
+
+    {
+        PMC_PROFILE_ZONE("Sprite::Render");
+        if (_pPlayer != nullptr)
+        {
+            _pPlayer->Render(pSDLRenderer);
+        }
+
+        if (_pBlinky != nullptr)
+        {
+            _pBlinky->Render(pSDLRenderer);
+        }
+
+        for (Uint32 index = 0; index < _cModGhostsSpawned; index++)
+        {
+            _modGhosts[index]->Render(pSDLRenderer);
+        }
+    }
+
+    RenderHud(pSDLRenderer);
+}
+
+// The labels already hold their laid out glyphs, so this is just the copies
+void GameSession::RenderHud(SDL_Renderer *pSDLRenderer)
+{
+    if (_pGlyphAtlas == nullptr)
+    {
+        return;
+    }
+
+    PMC_PROFILE_ZONE("GameSession::RenderHud");
+    _oneUpLabel.Render(pSDLRenderer);
+    _scoreLabel.Render(pSDLRenderer);
+    _highScoreTitleLabel.Render(pSDLRenderer);
+    _highScoreLabel.Render(pSDLRenderer);
+    if (_state == GameState::WaitingToStartLevel)
+    {
+        _readyLabel.Render(pSDLRenderer);
+    }
+}
+
+// The labels only re-layout when the number they show changes
+void GameSession::AddScore(Uint32 points)
+{
+    _score += points;
+    _scoreLabel.SetNumber(_score);
+    if (_score > _highScore)
+    {
+        _highScore = _score;
+        _highScoreLabel.SetNumber(_highScore);
+    }
+}
+
+// The session's own state in one hash, then each sprite and the maze's tiles in theirs.  The sprites only
+// exist from the first level load, until then they hash as nothing
+void GameSession::Checksum(StateChecksum *pChecksum)
+{
+    StateHasher session;
+    session.Add(static_cast<Uint64>(_state));
+    session.Add((static_cast<Uint64>(_simTicks) << 32) | _tickCount);
+    _stateTimer.HashState(session);
+    session.Add((static_cast<Uint64>(_pelletsEaten) << 32) | _cLevelsCompleted);
+    session.Add((static_cast<Uint64>(_score) << 32) | _highScore);
+    session.Add((static_cast<Uint64>(_flashCounter) << 8) | (_fFlashTiles ? 1 : 0));
+    pChecksum->components[static_cast<size_t>(StateComponent::Session)] = session.Value();
+
+    StateHasher player;
+    if (_pPlayer != nullptr)
+    {
+        _pPlayer->HashState(player);
+    }
+    pChecksum->components[static_cast<size_t>(StateComponent::Player)] = player.Value();
+
+    StateHasher ghosts;
+    if (_pBlinky != nullptr)
+    {
+        _pBlinky->HashState(ghosts);
+    }
+    for (Uint32 index = 0; index < _cModGhostsSpawned; index++)
+    {
+        _modGhosts[index]->HashState(ghosts);
+    }
+    pChecksum->components[static_cast<size_t>(StateComponent::Ghosts)] = ghosts.Value();
+
+    pChecksum->components[static_cast<size_t>(StateComponent::Maze)] = (_pMaze != nullptr) ? _pMaze->TilesHash() : 0;
+}
+
+bool GameSession::HasReversedGhostDecision()
+{
+    if ((_pBlinky != nullptr) && _pBlinky->HasReversedDecision())
+    {
+        return true;
+    }
+    for (Uint32 index = 0; index < _cModGhostsSpawned; index++)
+    {
+        if (_modGhosts[index]->HasReversedDecision())
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void GameSession::Snapshot(SessionSnapshot *pSnapshot)
+{
+    pSnapshot->tick = _tickCount;
+    pSnapshot->fFlashTiles = _fFlashTiles;
+    pSnapshot->cSprites = 0;
+    if (_pMaze == nullptr)
+    {
+        pSnapshot->tilesVersion = 0;
+        return;
+    }
+
+    pSnapshot->mapBounds = _pMaze->GetMapBounds();
+    if (pSnapshot->tilesVersion != _tilesVersion)
+    {
+        SDL_memcpy(pSnapshot->tiles, _pMaze->TileIndices(), sizeof(pSnapshot->tiles));
+        pSnapshot->tilesVersion = _tilesVersion;
+    }
+
+    Sprite* sprites[SessionSnapshot::c_maxSprites] = { _pPlayer, _pBlinky };
+    for (Uint32 index = 0; index < _cModGhostsSpawned; index++)
+    {
+        sprites[2 + index] = _modGhosts[index];
+    }
+    for (size_t index = 0; index < SDL_arraysize(sprites); index++)
+    {
+        Uint16 slot = pSnapshot->cSprites;
+        if ((sprites[index] != nullptr) && sprites[index]->GetRenderRects(pSnapshot->spriteSource[slot], pSnapshot->spriteTarget[slot]))
+        {
+            pSnapshot->cSprites++;
+        }
+    }
+}
+
+void GameSession::SetTickAnimation(bool fTickAnimation)
+{
+    _fTickAnimation = fTickAnimation;
+    if (_pPlayer != nullptr)
+    {
+        _pPlayer->SetTickAnimation(fTickAnimation);
+    }
+    if (_pBlinky != nullptr)
+    {
+        _pBlinky->SetTickAnimation(fTickAnimation);
+    }
+    for (ConfigurableGhost *pGhost : _modGhosts)
+    {
+        if (pGhost != nullptr)
+        {
+            pGhost->SetTickAnimation(fTickAnimation);
+        }
+    }
+}
+
+void GameSession::SetStressEntities(Uint32 cEntities)
+{
+    _cStressEntities = cEntities;
+}
+
+void GameSession::SetGhostLookahead(Uint8 lookahead)
+{
+    _ghostLookahead = lookahead;
+    if (_pBlinky != nullptr)
+    {
+        _pBlinky->SetLookahead(lookahead);
+    }
+    for (ConfigurableGhost *pGhost : _modGhosts)
+    {
+        if (pGhost != nullptr)
+        {
+            pGhost->SetLookahead(lookahead);
+        }
+    }
+}
+
+void GameSession::SetModGhosts(Uint32 cGhosts)
+{
+    _cModGhosts = SDL_min(cGhosts, static_cast<Uint32>(Constants::MaxModGhosts));
+}
+
+void GameSession::InitializeSprites()
+{
+    if (_pPlayer == nullptr)
+    {
+        _pPlayer = new Player(_spriteTexture.Get());
+        _pPlayer->Initialize();
+        _pPlayer->SetTickAnimation(_fTickAnimation);
+    }
+    _pPlayer->Reset(_pMaze);
+
+    if (_pBlinky == nullptr)
+    {
+        _pBlinky = new Blinky(_spriteTexture.Get());
+        _pBlinky->Initialize();
+        _pBlinky->SetTickAnimation(_fTickAnimation);
+        _pBlinky->SetLookahead(_ghostLookahead);
+    }
+    _pBlinky->Reset(_pMaze);
+
+    // Mod ghosts alternate between cutting the player off and patrolling a corner, to exercise the runtime
+    // targeting.  Like the player and Blinky they are only allocated the first time
+    for (Uint32 index = 0; index < _cModGhosts; index++)
+    {
+        if (_modGhosts[index] == nullptr)
+        {
+            if (index % 2 == 0)
+            {
+                _modGhosts[index] = new ConfigurableGhost(_spriteTexture.Get(), &AnimationLibrary::Get().Blinky(), ConfigurableGhost::TargetAhead, nullptr);
+            }
+            else
+            {
+                SDL_Point *pCell = &s_modGhostCells[(index / 2) % SDL_arraysize(s_modGhostCells)];
+                _modGhosts[index] = new ConfigurableGhost(_spriteTexture.Get(), &AnimationLibrary::Get().Blinky(), ConfigurableGhost::TargetCell, pCell);
+            }
+            _modGhosts[index]->Initialize();
+            _modGhosts[index]->SetTickAnimation(_fTickAnimation);
+            _modGhosts[index]->SetLookahead(_ghostLookahead);
+        }
+        _modGhosts[index]->Reset(_pMaze);
+    }
+    _cModGhostsSpawned = _cModGhosts;
+
+    // The store only allocates the first time, a restart just respawns into the same arrays.  Fixed seed so
+    // every level (and every run) starts the same
+    if (_cStressEntities > 0)
+    {
+        _entities.Reserve(_cStressEntities);
+        _entities.SpawnWanderers(_pMaze, _cStressEntities, Constants::StressEntitySeed);
+    }
+}
+
+Uint16 GameSession::HandlePelletCollision()
+{
+    Uint16 ret = 0;
+    SDL_Point playerPoint = { static_cast<int>(_pPlayer->X()), static_cast<int>(_pPlayer->Y()) };
+    Uint16 row = 0;
+    Uint16 col = 0;
+    _pMaze->GetTileRowCol(playerPoint, row, col);
+
+    if (_pMaze->IsTilePellet(row, col))
+    {
+        AddScore(_pMaze->IsTilePowerPellet(row, col) ? Constants::PowerPelletPoints : Constants::PelletPoints);
+        _pMaze->EatPellet(row, col);
+        _tilesVersion++;
+        ret++;
+    }
+    return ret;
+}
+
+// Makes *ppMaze a ready to play copy of the current level.  The first time this creates it - tiles copied, tile
+// rects cut and the navigation table built - after that it only copies the pristine tiles back in, so a
+// level reset never allocates.  It only reads the level data and constants so it is safe to run on the
+// prefetch thread
+void GameSession::PrepareMaze(Maze **ppMaze)
+{
+    PMC_PROFILE_ZONE("GameSession::PrepareMaze");
+    if (*ppMaze == nullptr)
+    {
+        *ppMaze = new Maze(Constants::MapRows, Constants::MapCols, Constants::ScreenWidth, Constants::ScreenHeight);
+    }
+
+    Maze *pMaze = *ppMaze;
+    if (pMaze->IsInitialized())
+    {
+        pMaze->RestoreTiles(_pLevelTiles);
+    }
+    else
+    {
+        pMaze->Initialize(_levelTextureRect, _levelTileRect, _tilesTexture.Get()->Ptr(),
+            _pLevelTiles, Constants::MapRows *  Constants::MapCols);
+        pMaze->BuildNavigation();
+    }
+}
+
+// The level complete sequence is several seconds of nothing but flashing, so the next level is prepared
+// then.  Building a maze from scratch happens in the background; once the spare exists, refilling it is just
+// a copy of the tiles and isn't worth a thread.  The result doesn't depend on when the thread runs, so
+// replays stay deterministic
+void GameSession::StartPrefetch()
+{
+    FinishPrefetch();
+    if (_pNextMaze != nullptr)
+    {
+        PrepareMaze(&_pNextMaze);
+        _fNextMazeReady = true;
+    }
+    else
+    {
+        _prefetchThread = std::thread([this]()
+        {
+            PMC_PROFILE_THREAD("level prefetch");
+            PMC_ALLOC_PHASE("LevelPrefetch");
+            PrepareMaze(&_pNextMaze);
+            _fNextMazeReady = true;
+        });
+    }
+}
+
+void GameSession::FinishPrefetch()
+{
+    if (_prefetchThread.joinable())
+    {
+        _prefetchThread.join();
+    }
+}
+
+GameSession::GameState GameSession::OnLoading()
+{
+    PMC_ALLOC_PHASE("Loading");
+    // This should be know, but it should also match what we just queried
+    SDL_assert(_tilesTexture.Get()->Width() == _levelTextureRect.w);
+    SDL_assert(_tilesTexture.Get()->Height() == _levelTextureRect.h);
+
+    _fFlashTiles = false;
+
+    // Normally the prefetch already has the level waiting and this is just the swap.  The very first level
+    // has nothing to overlap with so it is built here.  The finished maze becomes the next spare
+    FinishPrefetch();
+    if (!_fNextMazeReady)
+    {
+        PrepareMaze(&_pNextMaze);
+    }
+    std::swap(_pMaze, _pNextMaze);
+    _fNextMazeReady = false;
+    _tilesVersion++;
+
+    // Initialize our sprites
+    InitializeSprites();
+    return GameState::WaitingToStartLevel;
+}
+
+// Start the current level over - pristine tiles back into the maze's own buffers, sprites reset in place
+// and the score cleared.  Nothing is allocated, which matters for bots that restart constantly
+void GameSession::RestartLevel()
+{
+    PMC_ALLOC_PHASE("RestartLevel");
+    FinishPrefetch();
+    _stateTimer.Reset();
+    _fFlashTiles = false;
+    _pelletsEaten = 0;
+    _score = 0;
+    _scoreLabel.SetNumber(_score);
+    if (_pMaze == nullptr)
+    {
+        // Nothing loaded yet, the normal load is already a fresh start
+        _state = GameState::LoadingLevel;
+        return;
+    }
+
+    PrepareMaze(&_pMaze);
+    _tilesVersion++;
+    InitializeSprites();
+    _state = GameState::WaitingToStartLevel;
+}
+
+// The level complete path (flash, prefetch, reload) without having to eat every pellet first.  The pellets
+// left on the level don't matter, the next level starts from the pristine tiles anyway
+void GameSession::CompleteLevel()
+{
+    if (_state == GameState::Running)
+    {
+        _pelletsEaten = 0;
+        _cLevelsCompleted++;
+        Metrics::LevelsCompleted.Add();
+        _state = GameState::LevelComplete;
+    }
+}
+
+// This is the traditional delay before the level starts, normally you hear the little
+// tune that signals play is about to begin, then you transition.  We have no sound yet
+// so just delay the game a bit
+GameSession::GameState GameSession::OnWaitingToStartLevel()
+{
+    PMC_ALLOC_PHASE("WaitingToStartLevel");
+    if (!_stateTimer.IsStarted())
+    {
+        _stateTimer.Start(Constants::LevelLoadDelay);
+    }
+
+    if (_stateTimer.IsDone())
+    {
+        _stateTimer.Reset();
+        return GameState::Running;
+    }
+    return GameState::WaitingToStartLevel;
+}
+
+// Normal game play, check for collisions, update based on input, eventually the ghosts
+// and their updates will need to be in here as well.
+GameSession::GameState GameSession::OnRunning(Direction inputDirection)
+{
+    // Steady state gameplay, tracking builds assert if anything in here reaches the heap
+    PMC_NO_ALLOC_PHASE("Running");
+
+    // UPDATE
+    {
+        PerfPhaseScope phase(PerfPhase::Update);
+        {
+            PMC_PROFILE_ZONE("Player::Update");
+            _pPlayer->Update(_pMaze, inputDirection);
+        }
+        {
+            PMC_PROFILE_ZONE("Ghost::Update");
+            _pBlinky->Update(_pPlayer, _pMaze);
+        }
+        if (_cModGhostsSpawned > 0)
+        {
+            PMC_PROFILE_ZONE("ConfigurableGhost::UpdateBatch");
+            ConfigurableGhost::UpdateBatch(_modGhosts, _cModGhostsSpawned, _pPlayer, _pMaze);
+        }
+        {
+            PMC_PROFILE_ZONE("EntityStore::Update");
+            _entities.Update(_pMaze);
+        }
+    }
+
+    // COLLISIONS
+    {
+        PerfPhaseScope phase(PerfPhase::Collision);
+        PMC_PROFILE_ZONE("HandlePelletCollision");
+        _pelletsEaten += HandlePelletCollision();
+    }
+    if (_pelletsEaten == Constants::TotalPellets)
+    {
+        _pelletsEaten = 0;
+        _cLevelsCompleted++;
+        Metrics::LevelsCompleted.Add();
+        return GameState::LevelComplete;
+    }
+    return GameState::Running;
+}
+
+// All 244 pellets have been eaten, so we briefly flash the screen before moving to the
+// next level.  We only have the one level, so it just restarts
+GameSession::GameState GameSession::OnLevelComplete()
+{
+    PMC_ALLOC_PHASE("LevelComplete");
+    if (!_stateTimer.IsStarted())
+    {
+        _flashCounter = 0;
+        _fFlashTiles = false;
+        _stateTimer.Start(Constants::LevelCompleteDelay);
+        StartPrefetch();
+    }
+
+    // We flip the tint back and forth roughly every second until the overall timer is done.
+    if (_flashCounter++ > 60)
+    {
+        _flashCounter = 0;
+        _fFlashTiles = !_fFlashTiles;
+    }
+
+    if (_stateTimer.IsDone())
+    {
+        _stateTimer.Reset();
+        return GameState::LoadingLevel;
+    }
+    return GameState::LevelComplete;
+}
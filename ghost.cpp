@@ -1,20 +1,21 @@
 #include "include/ghost.h"
 #include "include/constants.h"
+#include "include/blinky.h"
+#include "include/configurableghost.h"
 
 using namespace XplatGameTutorial::PacManClone;
 
-Ghost::Ghost(TextureWrapper *pTextureWrapper, Uint16 cxFrame, Uint16 cyFrame, Uint16 cFramesTotal, Uint16 cAnimationsTotal) :
-    Sprite(pTextureWrapper, Constants::GhostSpriteWidth, Constants::GhostSpriteHeight, Constants::GhostTotalFrameCount, Constants::GhostTotalAnimationCount),
+Ghost::Ghost(TextureWrapper *pTextureWrapper, const AnimationSet *pAnimationSet) :
+    Sprite(pTextureWrapper, pAnimationSet),
     _currentRow(0),
     _currentCol(0),
     _mode(Mode::Chase),
-    _pNextDecision(nullptr),
-    _pCurrentDecision(nullptr) 
+    _lookahead(Constants::GhostLookahead)
 {
 }
 
 // Call the subroutine based on our internal state
-void Ghost::Update(Player* pPlayer, Maze* pMaze)
+template <class TGhost> void Ghost::UpdateAs(Player* pPlayer, Maze* pMaze)
 {
     switch (_mode)
     {
@@ -28,7 +29,7 @@ void Ghost::Update(Player* pPlayer, Maze* pMaze)
         OnWarpingIn(pPlayer, pMaze);
         break;
     case Mode::Chase:
-        OnChasing(pPlayer, pMaze);
+        OnChasing<TGhost>(pPlayer, pMaze);
         break;
     case Mode::Scatter:
         // Not implemented
@@ -38,8 +39,8 @@ void Ghost::Update(Player* pPlayer, Maze* pMaze)
 
 // The conditions under which this is called is when the current cell is
 // *NOT* an intersection, and thus should only have 1 valid exit that is not
-// in the reverse direction of the sprite
-Direction Ghost::GetNextDirection(Uint16 r, Uint16 c, Maze *pMaze)
+// in the reverse direction of the sprite (the direction it arrived in)
+Direction Ghost::GetNextDirection(Uint16 r, Uint16 c, Direction arrivingDirection, Maze *pMaze)
 {
     Direction options[] = // Logic assumes the order here matches the enum
     {
@@ -50,7 +51,7 @@ Direction Ghost::GetNextDirection(Uint16 r, Uint16 c, Maze *pMaze)
     };
 
     // This option is automatically invalid
-    size_t oppositeOption = static_cast<size_t>(Opposite(_pCurrentDecision->GetDirection()));
+    size_t oppositeOption = static_cast<size_t>(Opposite(arrivingDirection));
     SDL_assert(oppositeOption != static_cast<size_t>(Direction::None));
 
     // Now there are 3 options left
@@ -73,19 +74,15 @@ Direction Ghost::GetNextDirection(Uint16 r, Uint16 c, Maze *pMaze)
     return Direction::None;
 }
 
-// Look ahead one tile and make a decision about what to do when we
-// eventually get there.  If the tile is an intersection, we will ask
-// our specific ghost implementation what to do.
-Ghost::Decision* Ghost::GetNextDecision(Player *pPlayer, Maze* pMaze)
+// Look ahead one tile past the previous decision's cell and make a decision about
+// what to do when we eventually get there.  If the tile is an intersection, we will
+// ask our specific ghost type where it is headed.
+template <class TGhost> Ghost::Decision Ghost::GetDecisionAfter(Decision &previous, Player *pPlayer, Maze* pMaze)
 {
-    // Record current cell
-    SDL_Point ghostPoint = { static_cast<int>(X()), static_cast<int>(Y()) };
-    pMaze->GetTileRowCol(ghostPoint, _currentRow, _currentCol);
-
-    // Get the next cell based only on Direction of current decision
-    Uint16 r = _currentRow;
-    Uint16 c = _currentCol;
-    TranslateCell(r, c, _pCurrentDecision->GetDirection());
+    // Get the next cell based only on Direction of the previous decision
+    Uint16 r = previous.Row();
+    Uint16 c = previous.Col();
+    TranslateCell(r, c, previous.GetDirection());
 
     // This cell should be free
     SDL_assert(pMaze->IsTileSolid(r, c) == SDL_FALSE);
@@ -94,17 +91,44 @@ Ghost::Decision* Ghost::GetNextDecision(Player *pPlayer, Maze* pMaze)
     // Is the next cell an intersection?
     if (pMaze->IsTileIntersection(r, c))
     {
-        // Yes - Now we need to as the derived class
-        newDirection = MakeBranchDecision(r, c, pPlayer, pMaze);
+        // Yes - Now we need to ask the ghost type
+        double xTarget = 0.0;
+        double yTarget = 0.0;
+        static_cast<TGhost*>(this)->GetTarget(pPlayer, pMaze, xTarget, yTarget);
+        newDirection = ClosestExit(r, c, previous.GetDirection(), xTarget, yTarget, pMaze);
     }
     else
     {
         // Should only be one option left
-        newDirection = GetNextDirection(r, c, pMaze);
+        newDirection = GetNextDirection(r, c, previous.GetDirection(), pMaze);
     }
 
     SDL_assert(newDirection != Direction::None);
-    return new Decision(r, c, newDirection);
+    return Decision(r, c, newDirection);
+}
+
+// Decide the coming cells until we're _lookahead cells ahead.  Looking ahead stops at the warp
+// tunnel mouth, past it the ghost is in WarpingOut and the cells are off the map
+template <class TGhost> void Ghost::FillDecisions(Player *pPlayer, Maze* pMaze)
+{
+    if (_decisions.Count() == 1)
+    {
+        // Record current cell, the first step is taken from where we actually are
+        SDL_Point ghostPoint = { static_cast<int>(X()), static_cast<int>(Y()) };
+        pMaze->GetTileRowCol(ghostPoint, _currentRow, _currentCol);
+        CurrentDecision() = Decision(_currentRow, _currentCol, CurrentDecision().GetDirection());
+    }
+
+    while (_decisions.Count() <= _lookahead)
+    {
+        Decision &last = _decisions.Back();
+        if ((_decisions.Count() > 1) && (last.Row() == Constants::WarpRow) &&
+            ((last.Col() <= Constants::WarpColGhostLeft) || (last.Col() >= Constants::WarpColGhostRight)))
+        {
+            break;
+        }
+        _decisions.Push(GetDecisionAfter<TGhost>(last, pPlayer, pMaze));
+    }
 }
 
 bool Ghost::IsGhostWarpingOut(Maze* pMaze)
@@ -132,9 +156,6 @@ void Ghost::OnExitingPen(Player* pPlayer, Maze* pMaze)
         ResetPosition(centerPoint.x, centerPoint.y);
         _currentRow = Constants::GhostPenRowExit;
         _currentCol = Constants::GhostPenCol;
-        SafeDelete<Decision>(_pNextDecision);
-        SafeDelete<Decision>(_pCurrentDecision);
-
         double speed = Constants::GhostBaseSpeed * 1.75;
         if (pPlayer->X() < X())
         {
@@ -142,7 +163,7 @@ void Ghost::OnExitingPen(Player* pPlayer, Maze* pMaze)
         }
 
         SetVelocity(speed, 0.0);
-        _pCurrentDecision = new Decision(Constants::GhostPenRowExit, Constants::GhostPenCol, CurrentDirection());
+        SetCurrentDecision(Decision(Constants::GhostPenRowExit, Constants::GhostPenCol, CurrentDirection()));
         _mode = Mode::Chase;
     }
 }
@@ -186,13 +207,11 @@ void Ghost::OnWarpingIn(Player* pPlayer, Maze* pMaze)
         _currentCol = col;
         _mode = Mode::Chase;
         // Need a new decision as well
-        SafeDelete<Decision>(_pNextDecision);
-        SafeDelete<Decision>(_pCurrentDecision);
-        _pCurrentDecision = new Decision(row, col, CurrentDirection());
+        SetCurrentDecision(Decision(row, col, CurrentDirection()));
     }
 }
 
-void Ghost::OnChasing(Player* pPlayer, Maze* pMaze)
+template <class TGhost> void Ghost::OnChasing(Player* pPlayer, Maze* pMaze)
 {
     if (IsGhostPenned())
     {
@@ -221,17 +240,16 @@ void Ghost::OnChasing(Player* pPlayer, Maze* pMaze)
         SDL_Point centerPoint = pMaze->GetTileCoordinates(_currentRow, _currentCol);
         Sprite::Update();
         if (pMaze->IsSpritePastCenter(_currentRow, _currentCol, this) &&
-            _pCurrentDecision->GetDirection() != CurrentDirection())
+            CurrentDecision().GetDirection() != CurrentDirection())
         {
             ResetPosition(centerPoint.x, centerPoint.y);
             Stop();
         }
         else
         {
-            SDL_assert(_pCurrentDecision != nullptr);
-            if (_pNextDecision == nullptr)
+            if (_decisions.Count() <= _lookahead)
             {
-                _pNextDecision = GetNextDecision(pPlayer, pMaze);
+                FillDecisions<TGhost>(pPlayer, pMaze);
             }
 
             SDL_Point updatedPoint = { static_cast<int>(X()), static_cast<int>(Y()) };
@@ -244,10 +262,8 @@ void Ghost::OnChasing(Player* pPlayer, Maze* pMaze)
                 // Entering a new cell
                 _currentRow = row;
                 _currentCol = col;
-                SDL_assert(_pNextDecision != nullptr);
-                SafeDelete<Decision>(_pCurrentDecision);
-                _pCurrentDecision = _pNextDecision;
-                _pNextDecision = nullptr;
+                SDL_assert(_decisions.Count() > 1);
+                _decisions.PopFront();
 
                 // Did we move into a warp cell?
                 if (IsGhostWarpingOut(pMaze))
@@ -262,7 +278,7 @@ void Ghost::OnChasing(Player* pPlayer, Maze* pMaze)
                 if (IsStopped())
                 {
                     // Set Direction
-                    UpdateAnimation(_pCurrentDecision->GetDirection());
+                    UpdateAnimation(CurrentDecision().GetDirection());
                 }
             }
         }
@@ -293,4 +309,142 @@ void Ghost::UpdateAnimation(Direction direction)
     case Direction::None:
         break;
     }
-}
\ No newline at end of file
+}
+
+void Ghost::HashState(StateHasher &hasher)
+{
+    Sprite::HashState(hasher);
+    hasher.Add(static_cast<Uint64>(_mode));
+    hasher.Add((static_cast<Uint64>(_currentRow) << 16) | _currentCol);
+    _penTimer.HashState(hasher);
+    hasher.Add(_decisions.Count());
+    for (Uint8 index = 0; index < _decisions.Count(); index++)
+    {
+        Decision &decision = _decisions.At(index);
+        hasher.Add((static_cast<Uint64>(decision.Row()) << 32) | (static_cast<Uint64>(decision.Col()) << 16) |
+            static_cast<Uint64>(decision.GetDirection()));
+    }
+}
+
+void Ghost::SetLookahead(Uint8 lookahead)
+{
+    SDL_assert((lookahead >= 1) && (lookahead < DecisionRing::c_capacity));
+    _lookahead = SDL_min(SDL_max(lookahead, static_cast<Uint8>(1)), static_cast<Uint8>(DecisionRing::c_capacity - 1));
+}
+
+bool Ghost::HasReversedDecision()
+{
+    for (Uint8 index = 1; index < _decisions.Count(); index++)
+    {
+        if (_decisions.At(index).GetDirection() == Opposite(_decisions.At(index - 1).GetDirection()))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Ghost::ResetToPen(Maze *pMaze)
+{
+    SetAnimation(Constants::AnimationIndexUp);
+    SDL_Point penCoord = pMaze->GetTileCoordinates(Constants::GhostPenRow, Constants::GhostPenCol);
+    _currentRow = Constants::GhostPenRow;
+    _currentCol = Constants::GhostPenCol;
+    ResetPosition(penCoord.x, penCoord.y);
+    SetVelocity(0, Constants::GhostBaseSpeed * -1.75);
+
+    SetCurrentDecision(Decision(Constants::GhostPenRow, Constants::GhostPenCol, CurrentDirection()));
+    _penTimer.Reset();
+}
+
+Direction Ghost::ClosestExit(Uint16 nRow, Uint16 nCol, Direction arrivingDirection, double xTarget, double yTarget, Maze *pMaze)
+{
+    Direction result = arrivingDirection;
+
+    // What is the shortest available exit in cell[nRow, nCol]?
+    // we know this cell should be an intersection
+    SDL_assert(pMaze->IsTileIntersection(nRow, nCol) == SDL_TRUE);
+
+    // This means there should be at least 2 options to pick from minus the
+    // reverse of the direction we arrive in, which is invalid.  That is the previous
+    // decision's direction, not our velocity - with lookahead the cell can be several
+    // steps ahead of us
+    // ...
+    struct MAZECELL
+    {
+        Uint16 row;
+        Uint16 col;
+        double distance;
+        bool valid;
+    };
+    
+    // Direction order should match the Direction Enum for easy array access
+    MAZECELL options[] = { 
+        { static_cast<Uint16>(nRow - 1), nCol, 0, false }, // UP
+        { static_cast<Uint16>(nRow + 1), nCol, 0, false }, // DOWN
+        { nRow, static_cast<Uint16>(nCol - 1), 0, false }, // LEFT
+        { nRow, static_cast<Uint16>(nCol + 1), 0, false }  // RIGHT
+    };
+
+    for (size_t index = 0; index < SDL_arraysize(options); index++)
+    {
+        options[index].valid = (pMaze->IsTileSolid(options[index].row, options[index].col) == SDL_FALSE);
+        if (Opposite(static_cast<Direction>(index)) == arrivingDirection)
+        {
+            options[index].valid = false; // even though it's non solid
+        }
+
+        if (options[index].valid)
+        {
+            //Distance Cell and Target(P, C)
+            SDL_Point point = pMaze->GetTileCoordinates(options[index].row, options[index].col);
+            options[index].distance = SDL_sqrt(SDL_abs(xTarget - point.x) * SDL_abs(xTarget - point.x) +
+                SDL_abs(yTarget - point.y) * SDL_abs(yTarget - point.y));
+        }
+    }
+
+    size_t index = 0;
+    size_t shortest = 0;
+    for (;index < SDL_arraysize(options); index++)
+    {
+        if (options[index].valid)
+        {
+            shortest = index;
+            break;
+        }
+    }
+        
+    for (index = shortest+1 ;index < SDL_arraysize(options); index++)
+    {
+        if (options[index].distance < options[shortest].distance && options[index].valid)
+        {
+            shortest = index;
+        }
+    }
+
+    SDL_assert(options[shortest].valid);
+
+    // Remember I said the order should match the enum?
+    switch (shortest)
+    {
+    case 0:
+        result = Direction::Up;
+        break;
+    case 1:
+        result = Direction::Down;
+        break;
+    case 2:
+        result = Direction::Left;
+        break;
+    case 3:
+        result = Direction::Right;
+        break;
+    }
+
+    return result;
+}
+
+// Every ghost type gets its own copy of the update path, with its targeting compiled in.  New ghost types
+// go here too
+template void Ghost::UpdateAs<Blinky>(Player* pPlayer, Maze* pMaze);
+template void Ghost::UpdateAs<ConfigurableGhost>(Player* pPlayer, Maze* pMaze);
@@ -0,0 +1,200 @@
+#include "include/glyphatlas.h"
+#include "include/log.h"
+#include <stdio.h>
+
+using namespace XplatGameTutorial::PacManClone;
+
+// 5x7 font, one byte per row with bit 4 the leftmost pixel
+struct GlyphBitmap
+{
+    char ch;
+    Uint8 rows[7];
+};
+
+static const GlyphBitmap c_font[] =
+{
+    { '0', { 0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E } },
+    { '1', { 0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E } },
+    { '2', { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F } },
+    { '3', { 0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E } },
+    { '4', { 0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02 } },
+    { '5', { 0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E } },
+    { '6', { 0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E } },
+    { '7', { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 } },
+    { '8', { 0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E } },
+    { '9', { 0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C } },
+    { 'A', { 0x0E, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 } },
+    { 'B', { 0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E } },
+    { 'C', { 0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E } },
+    { 'D', { 0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C } },
+    { 'E', { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F } },
+    { 'F', { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10 } },
+    { 'G', { 0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F } },
+    { 'H', { 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 } },
+    { 'I', { 0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E } },
+    { 'J', { 0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C } },
+    { 'K', { 0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11 } },
+    { 'L', { 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F } },
+    { 'M', { 0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11 } },
+    { 'N', { 0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11 } },
+    { 'O', { 0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E } },
+    { 'P', { 0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10 } },
+    { 'Q', { 0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D } },
+    { 'R', { 0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11 } },
+    { 'S', { 0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E } },
+    { 'T', { 0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 } },
+    { 'U', { 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E } },
+    { 'V', { 0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04 } },
+    { 'W', { 0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A } },
+    { 'X', { 0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11 } },
+    { 'Y', { 0x11, 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04 } },
+    { 'Z', { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F } },
+    { '-', { 0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00 } },
+    { ':', { 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00 } },
+    { '.', { 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C } },
+    { '!', { 0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04 } },
+    { '/', { 0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00 } },
+    { '%', { 0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03 } },
+};
+
+GlyphAtlas::~GlyphAtlas()
+{
+    if (_pTexture != nullptr)
+    {
+        SDL_DestroyTexture(_pTexture);
+        _pTexture = nullptr;
+    }
+}
+
+// Draw every glyph at 2x into a transparent surface, then upload it once
+bool GlyphAtlas::Initialize(SDL_Renderer *pSDLRenderer)
+{
+    SDL_assert(_pTexture == nullptr);
+    const int cGlyphs = SDL_arraysize(c_font);
+    const int cRows = (cGlyphs + c_glyphsPerRow - 1) / c_glyphsPerRow;
+    const int scale = 2;
+    const int xInset = (GlyphWidth - (5 * scale)) / 2;
+    const int yInset = (GlyphHeight - (7 * scale)) / 2;
+
+    SDL_Surface *pSurface = SDL_CreateRGBSurface(0, c_glyphsPerRow * GlyphWidth, cRows * GlyphHeight, 32,
+        0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000);
+    if (pSurface == nullptr)
+    {
+        PMC_LOG_ERROR(LogCategory::Render, "SDL_CreateRGBSurface() failed, error = %s", SDL_GetError());
+        return false;
+    }
+
+    SDL_FillRect(pSurface, nullptr, SDL_MapRGBA(pSurface->format, 0, 0, 0, 0));
+    Uint32 white = SDL_MapRGBA(pSurface->format, 255, 255, 255, 255);
+    for (int glyph = 0; glyph < cGlyphs; glyph++)
+    {
+        int xCell = (glyph % c_glyphsPerRow) * GlyphWidth + xInset;
+        int yCell = (glyph / c_glyphsPerRow) * GlyphHeight + yInset;
+        for (int row = 0; row < 7; row++)
+        {
+            for (int col = 0; col < 5; col++)
+            {
+                if ((c_font[glyph].rows[row] & (0x10 >> col)) != 0)
+                {
+                    SDL_Rect pixel = { xCell + col * scale, yCell + row * scale, scale, scale };
+                    SDL_FillRect(pSurface, &pixel, white);
+                }
+            }
+        }
+        _glyphSlots[static_cast<Uint8>(c_font[glyph].ch)] = static_cast<Uint8>(glyph);
+    }
+
+    _pTexture = SDL_CreateTextureFromSurface(pSDLRenderer, pSurface);
+    SDL_FreeSurface(pSurface);
+    if (_pTexture == nullptr)
+    {
+        PMC_LOG_ERROR(LogCategory::Render, "SDL_CreateTextureFromSurface() failed for the glyph atlas, error = %s", SDL_GetError());
+        return false;
+    }
+    SDL_SetTextureBlendMode(_pTexture, SDL_BLENDMODE_BLEND);
+    return true;
+}
+
+bool GlyphAtlas::GetGlyph(char ch, SDL_Rect &sourceRect)
+{
+    // The font only has capitals
+    if ((ch >= 'a') && (ch <= 'z'))
+    {
+        ch = static_cast<char>(ch - 'a' + 'A');
+    }
+
+    Uint8 slot = (static_cast<Uint8>(ch) < SDL_arraysize(_glyphSlots)) ? _glyphSlots[static_cast<Uint8>(ch)] : 0xFF;
+    if (slot == 0xFF)
+    {
+        return false;
+    }
+    sourceRect = { (slot % c_glyphsPerRow) * GlyphWidth, (slot / c_glyphsPerRow) * GlyphHeight, GlyphWidth, GlyphHeight };
+    return true;
+}
+
+void TextLabel::Initialize(GlyphAtlas *pGlyphAtlas, int x, int y, TextAlign align, SDL_Color color)
+{
+    _pGlyphAtlas = pGlyphAtlas;
+    _x = x;
+    _y = y;
+    _align = align;
+    _color = color;
+    Layout();
+}
+
+void TextLabel::SetText(const char *szText)
+{
+    _fHasNumber = false;
+    if (SDL_strncmp(_szText, szText, c_maxChars) != 0)
+    {
+        SDL_strlcpy(_szText, szText, SDL_arraysize(_szText));
+        Layout();
+    }
+}
+
+void TextLabel::SetNumber(Uint32 value)
+{
+    if (!_fHasNumber || (_number != value))
+    {
+        SDL_snprintf(_szText, SDL_arraysize(_szText), "%u", value);
+        _number = value;
+        _fHasNumber = true;
+        Layout();
+    }
+}
+
+// Every glyph is the same width, so each character's place only depends on its position in the string
+void TextLabel::Layout()
+{
+    _cGlyphs = 0;
+    if (_pGlyphAtlas == nullptr)
+    {
+        return;
+    }
+
+    int cch = static_cast<int>(SDL_strlen(_szText));
+    int xStart = (_align == TextAlign::Left) ? _x : _x - (cch * GlyphAtlas::GlyphWidth);
+    for (int index = 0; index < cch; index++)
+    {
+        if (_pGlyphAtlas->GetGlyph(_szText[index], _sourceRects[_cGlyphs]))
+        {
+            _targetRects[_cGlyphs] = { xStart + index * GlyphAtlas::GlyphWidth, _y, GlyphAtlas::GlyphWidth, GlyphAtlas::GlyphHeight };
+            _cGlyphs++;
+        }
+    }
+}
+
+void TextLabel::Render(SDL_Renderer *pSDLRenderer)
+{
+    if (_cGlyphs == 0)
+    {
+        return;
+    }
+
+    // Labels share the atlas, so the color goes on right before drawing
+    SDL_SetTextureColorMod(_pGlyphAtlas->Ptr(), _color.r, _color.g, _color.b);
+    for (Uint16 index = 0; index < _cGlyphs; index++)
+    {
+        SDL_RenderCopy(pSDLRenderer, _pGlyphAtlas->Ptr(), &_sourceRects[index], &_targetRects[index]);
+    }
+}
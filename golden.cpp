@@ -0,0 +1,92 @@
+#include "include/golden.h"
+#include "include/log.h"
+#include "SDL_image.h"
+#include <stdio.h>
+
+using namespace XplatGameTutorial::PacManClone;
+
+void GoldenImage::FileNameForTick(const char *szDir, Uint32 tick, char *szFileName, size_t cchFileName)
+{
+    SDL_snprintf(szFileName, cchFileName, "%s/tick_%06u.png", szDir, tick);
+}
+
+bool GoldenImage::Save(SDL_Surface *pFrame, const char *szFileName)
+{
+    bool fResult = (IMG_SavePNG(pFrame, szFileName) == 0);
+    if (!fResult)
+    {
+        PMC_LOG_ERROR(LogCategory::Harness, "IMG_SavePNG() failed for %s, error = %s", szFileName, IMG_GetError());
+    }
+    return fResult;
+}
+
+// Both images end up in the same 32bpp format, so this is a straight walk over the bytes.  The
+// alpha channel is skipped, the renderer leaves it at whatever the clear color says
+bool GoldenImage::Compare(SDL_Surface *pFrame, const char *szFileName, Uint8 tolerance, GoldenResult *pResult)
+{
+    SDL_assert(pFrame->format->BytesPerPixel == 4);
+    pResult->cPixelsDifferent = 0;
+    pResult->maxChannelDelta = 0;
+
+    SDL_Surface *pLoaded = IMG_Load(szFileName);
+    if (pLoaded == nullptr)
+    {
+        PMC_LOG_ERROR(LogCategory::Harness, "IMG_Load() failed for golden %s, error = %s", szFileName, IMG_GetError());
+        return false;
+    }
+
+    SDL_Surface *pGolden = SDL_ConvertSurfaceFormat(pLoaded, pFrame->format->format, 0);
+    SDL_FreeSurface(pLoaded);
+    if (pGolden == nullptr)
+    {
+        PMC_LOG_ERROR(LogCategory::Harness, "SDL_ConvertSurfaceFormat() failed for golden %s, error = %s", szFileName, SDL_GetError());
+        return false;
+    }
+
+    bool fResult = true;
+    if ((pGolden->w != pFrame->w) || (pGolden->h != pFrame->h))
+    {
+        PMC_LOG_ERROR(LogCategory::Harness, "Golden %s is %dx%d, frame is %dx%d", szFileName, pGolden->w, pGolden->h, pFrame->w, pFrame->h);
+        pResult->cPixelsDifferent = static_cast<Uint32>(pFrame->w * pFrame->h);
+        pResult->maxChannelDelta = 255;
+    }
+    else
+    {
+        // The software renderer does not need locking, but the converted golden might be RLE
+        SDL_LockSurface(pGolden);
+        Uint32 alphaMask = pFrame->format->Amask;
+        for (int y = 0; y < pFrame->h; y++)
+        {
+            const Uint32 *pFrameRow = reinterpret_cast<const Uint32*>(static_cast<const Uint8*>(pFrame->pixels) + y * pFrame->pitch);
+            const Uint32 *pGoldenRow = reinterpret_cast<const Uint32*>(static_cast<const Uint8*>(pGolden->pixels) + y * pGolden->pitch);
+            for (int x = 0; x < pFrame->w; x++)
+            {
+                Uint32 frame = pFrameRow[x] & ~alphaMask;
+                Uint32 golden = pGoldenRow[x] & ~alphaMask;
+                if (frame == golden)
+                {
+                    continue;
+                }
+
+                // Walk the channels, the alpha channel was masked to 0 in both above
+                Uint8 pixelDelta = 0;
+                for (int shift = 0; shift < 32; shift += 8)
+                {
+                    int a = (frame >> shift) & 0xFF;
+                    int b = (golden >> shift) & 0xFF;
+                    Uint8 delta = static_cast<Uint8>(SDL_abs(a - b));
+                    pixelDelta = SDL_max(pixelDelta, delta);
+                }
+
+                pResult->maxChannelDelta = SDL_max(pResult->maxChannelDelta, pixelDelta);
+                if (pixelDelta > tolerance)
+                {
+                    pResult->cPixelsDifferent++;
+                }
+            }
+        }
+        SDL_UnlockSurface(pGolden);
+    }
+    SDL_FreeSurface(pGolden);
+    return fResult;
+}
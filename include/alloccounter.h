@@ -0,0 +1,78 @@
+#pragma once
+#include "SDL.h"
+
+// Allocation phases.  PMC_ALLOC_PHASE("name") attributes every allocation the thread makes from there to the
+// end of the enclosing scope to that phase, PMC_NO_ALLOC_PHASE("name") does the same and also fails an
+// SDL_assert on the first allocation.  Phases nest, the innermost wins.  They only exist in builds with
+// PMC_ALLOC_TRACKING defined (make ALLOC_TRACKING=1), otherwise the macros are empty and cost nothing.
+// Names must be string literals, only the pointer is kept
+#ifdef PMC_ALLOC_TRACKING
+#define PMC_ALLOC_CONCAT_INNER(a, b) a##b
+#define PMC_ALLOC_CONCAT(a, b) PMC_ALLOC_CONCAT_INNER(a, b)
+#define PMC_ALLOC_PHASE_SCOPE(szName, fNoAlloc) \
+    static const Uint32 PMC_ALLOC_CONCAT(_allocPhaseIndex, __LINE__) = XplatGameTutorial::PacManClone::AllocationTracker::RegisterPhase(szName, fNoAlloc); \
+    XplatGameTutorial::PacManClone::AllocationPhaseScope PMC_ALLOC_CONCAT(_allocPhase, __LINE__)(PMC_ALLOC_CONCAT(_allocPhaseIndex, __LINE__))
+#define PMC_ALLOC_PHASE(szName) PMC_ALLOC_PHASE_SCOPE(szName, false)
+#define PMC_NO_ALLOC_PHASE(szName) PMC_ALLOC_PHASE_SCOPE(szName, true)
+#else
+#define PMC_ALLOC_PHASE(szName)
+#define PMC_NO_ALLOC_PHASE(szName)
+#endif
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    // Counts the heap allocations made through operator new, per thread.  alloccounter.cpp replaces the global
+    // operator new/delete to do the counting, which costs one thread local increment per allocation.  Used to
+    // check that code which is supposed to be allocation free (the game loop, level restarts) stays that way.
+    class AllocationCounter
+    {
+    public:
+        // Allocations made by the calling thread since it started
+        static Uint64 ThreadCount();
+        // Allocations made by every thread since the process started, for the metrics
+        static Uint64 ProcessCount();
+    };
+
+    // The tracking build on top of the counter: every operator new, and on glibc every malloc/calloc/realloc
+    // in the process (SDL's and the C library's included), is added to the calling thread's current phase
+    // and to its call site - the return address - within that phase.  Everything is kept in fixed tables
+    // behind a spin lock, so tracking never allocates itself, but it does serialize allocations across
+    // threads.  Meant for finding where allocations come from, not for shipping.
+    class AllocationTracker
+    {
+    public:
+        static const Uint32 c_maxPhases = 32;
+        static const Uint32 c_callSiteSlots = 4096;     // Power of 2, sites past this only count in their phase
+
+        // False when built without PMC_ALLOC_TRACKING, there is never anything to report
+        static bool IsCompiledIn();
+        // Index for the phase called szName, made the first time the name is seen (see PMC_ALLOC_PHASE)
+        static Uint32 RegisterPhase(const char *szName, bool fNoAlloc);
+        // Phase the calling thread is in, 0 - outside every phase
+        static Uint32 CurrentPhase();
+        static void SetCurrentPhase(Uint32 phaseIndex);
+        // Totals per phase, then the busiest call sites with their symbols where the loader knows them
+        static void PrintReport();
+    };
+
+    class AllocationPhaseScope
+    {
+    public:
+        AllocationPhaseScope(Uint32 phaseIndex) :
+            _previousPhase(AllocationTracker::CurrentPhase())
+        {
+            AllocationTracker::SetCurrentPhase(phaseIndex);
+        }
+
+        ~AllocationPhaseScope()
+        {
+            AllocationTracker::SetCurrentPhase(_previousPhase);
+        }
+
+    private:
+        Uint32 _previousPhase;
+    };
+}
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include "utils.h"
+#include "spriteanimation.h"
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    // Everything about how one kind of sprite looks - its frame rects on the sprite texture, its animation
+    // sequences and where the frame sits relative to the sprite's position.  Immutable once built, so any
+    // number of sprites can share one.
+    struct AnimationSet
+    {
+        static const Uint16 c_maxFrames = 24;
+        static const Uint16 c_maxSequences = 5;
+
+        SDL_Rect frames[c_maxFrames];               // Frame rects in the texture
+        Uint16 cFrames;
+        Uint16 cxFrame;                             // Every frame is the same size
+        Uint16 cyFrame;
+        int xFrameOffset;                           // Offset of the frame's left side from the position (can be negative)
+        int yFrameOffset;                           // Offset of the frame's top side
+        AnimationSequence sequences[c_maxSequences];
+        Uint16 cSequences;                          // 0 for a static sprite
+
+        // Checks every frame lies on the texture (which is loaded separately, possibly more than once)
+        bool FitsTexture(TextureWrapper *pTextureWrapper) const;
+    };
+
+    // The animation sets for every sprite in the game, built from Constants the first time it is used and
+    // shared by every session in the process after that
+    class AnimationLibrary
+    {
+    public:
+        static const AnimationLibrary& Get();
+
+        const AnimationSet& Player() const { return _player; }
+        const AnimationSet& Blinky() const { return _blinky; }
+
+    private:
+        AnimationLibrary();
+
+        static void LoadFrames(AnimationSet &set, Uint16 indexStart, Uint16 xTextureStart, Uint16 yTextureStart, Uint16 cFramesToLoad);
+        static void LoadSequence(AnimationSet &set, Uint16 index, AnimationType animationType, const int *pSequence, Uint16 cFrames, Uint16 speed);
+
+        AnimationSet _player;
+        AnimationSet _blinky;
+    };
+}
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include "SDL_image.h"
+#include "utils.h"
+#include <stdio.h>
+#include <atomic>
+#include <thread>
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    // Decodes image files into SDL_Surfaces on a small pool of worker threads so startup isn't a serial
+    // chain of IMG_Load calls, and so the decode can overlap SDL and window creation.  Surfaces never touch
+    // the renderer off the main thread - CreateTexture() does the upload, and has to be called on the thread
+    // that owns the renderer.  The SDL_image codecs are started for just the formats in the asset list.
+    class AssetLoader
+    {
+    public:
+        static const int c_maxAssets = 16;
+
+        AssetLoader();
+        ~AssetLoader();
+
+        // Returns the asset's index for CreateTexture(), or -1 if the list is full
+        int Add(const char *szFileName, const SDL_Color *pColorKey);
+        bool StartDecode();
+        void WaitForDecode();
+        // Uploads a decoded asset and frees its surface, nullptr if it failed to decode
+        TextureWrapper* CreateTexture(int index, SDL_Renderer *pSDLRenderer);
+
+        double DecodeWallMs() { return _msDecodeWall; }
+        void PrintDecodeTimes();
+
+    private:
+        struct Asset
+        {
+            const char *pszFileName;
+            bool fColorKey;
+            SDL_Color colorKey;
+            SDL_Surface *pSurface;
+            double msDecode;
+        };
+
+        bool InitializeCodecs();
+        void WorkerThread();
+        void Decode(Asset *pAsset);
+
+        Asset _assets[c_maxAssets];
+        int _cAssets;
+        std::atomic<int> _nextAsset;
+        std::atomic<int> _cFinished;
+        std::thread _workers[c_maxAssets];
+        int _cWorkers;
+        Uint64 _startCounter;
+        Uint64 _endCounter;             // Set by whichever worker finishes the last asset, read after the join
+        double _msDecodeWall;
+    };
+}
+}
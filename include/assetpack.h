@@ -0,0 +1,91 @@
+#pragma once
+#include "utils.h"
+#include <stdio.h>
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    // A single file holding everything startup needs, baked ahead of time by Build() (make pack).  Textures
+    // are stored already decoded in c_pixelFormat - what the SDL renderers use natively - with the color key
+    // already turned into alpha, so loading one is a single SDL_UpdateTexture straight out of the mapped
+    // file.  The level's tile indices and the tile atlas layout live alongside them.  The header carries a hash
+    // of what the pack was baked from, and Open() turns down a pack whose sources have changed since, so an
+    // edited image or level is never hidden behind a stale pack.
+    //
+    // File layout: a header { magic, version, entry count, reserved, source hash } then the table of contents, one Entry
+    // per asset, then the payloads, each 16 byte aligned.  Open() maps the file read only and hands out
+    // pointers into the mapping, which stay valid until Close().
+    class AssetPack
+    {
+    public:
+        enum class EntryType : Uint32
+        {
+            Texture = 1,        // width * height pixels, pitch bytes per row, in format
+            LevelTiles = 2,     // width (cols) * height (rows) Uint16 tile indices, row major
+            TileAtlas = 3,      // TileAtlasInfo
+        };
+
+        struct TileAtlasInfo
+        {
+            Uint32 textureWidth;
+            Uint32 textureHeight;
+            Uint32 tileWidth;
+            Uint32 tileHeight;
+        };
+
+        static const Uint32 c_pixelFormat = SDL_PIXELFORMAT_ARGB8888;
+
+        AssetPack();
+        ~AssetPack();
+
+        // Decodes the game's images and writes them, the level and the atlas layout to szFileName
+        static bool Build(const char *szFileName);
+
+        bool Open(const char *szFileName);
+        void Close();
+        bool IsOpen() { return _pData != nullptr; }
+
+        // Creates and fills a texture from the named entry, nullptr if it isn't in the pack
+        TextureWrapper* CreateTexture(const char *szName, SDL_Renderer *pSDLRenderer);
+        // Pointer to the named payload inside the mapping, pcbData, pWidth and pHeight are optional
+        const void* Find(const char *szName, EntryType type, Uint32 *pcbData, Uint32 *pWidth, Uint32 *pHeight);
+
+    private:
+        static const Uint32 c_magic = 0x4B434D50;  // 'PMCK'
+        static const Uint32 c_version = 2;
+        static const Uint32 c_alignment = 16;
+        static const Uint32 c_flagAlpha = 0x1;     // Texture has transparent pixels, draw it blended
+
+        struct Header
+        {
+            Uint32 magic;
+            Uint32 version;
+            Uint32 cEntries;
+            Uint32 reserved;
+            Uint64 sourceHash;      // HashSources() when it was built
+        };
+
+        struct Entry
+        {
+            char szName[32];
+            Uint32 type;
+            Uint32 offset;          // From the start of the file
+            Uint32 cbData;
+            Uint32 width;
+            Uint32 height;
+            Uint32 pitch;
+            Uint32 format;
+            Uint32 flags;
+        };
+
+        static bool HashSources(Uint64 *pHash);
+        const Entry* FindEntry(const char *szName, EntryType type);
+
+        const Uint8 *_pData;        // The mapped file
+        size_t _cbData;
+        const Entry *_pEntries;     // Table of contents, inside the mapping
+        Uint32 _cEntries;
+    };
+}
+}
@@ -9,15 +9,21 @@ namespace PacManClone
     // specific tile initialization code for example
     // This level also defines the specific movement behavior in the various ghost states,
     // e.g. what are its target tiles
-    class Blinky : public Ghost
+    class Blinky : public GhostT<Blinky>
     {
     public:
         Blinky(TextureWrapper* pTextureWrapper);
 
-        // "Interface" for my ghosts to implement
         bool Initialize();
         bool Reset(Maze *pMaze);
-        Direction MakeBranchDecision(Uint16 nRow, Uint16 nCol, Player* pPlayer, Maze *pMaze);
+
+        // Blinky's target is the player itself
+        // We won't bother with "Elroy" states at the moment
+        void GetTarget(Player* pPlayer, Maze *pMaze, double &xTarget, double &yTarget)
+        {
+            xTarget = pPlayer->X();
+            yTarget = pPlayer->Y();
+        }
     };
 }
-}
\ No newline at end of file
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include "utils.h"
+#include "constants.h"
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    class GameSession;
+
+    // Simple automatic player for unattended runs.  Each time the player reaches a new cell it does a breadth
+    // first search over the open cells for the nearest pellet and steers along the first step of that path.
+    // It ignores the ghosts, and since it only reads the session it is fully deterministic.
+    class PelletBot
+    {
+    public:
+        PelletBot() :
+            _lastRow(0xFFFF),
+            _lastCol(0xFFFF),
+            _direction(Direction::None)
+        {
+        }
+
+        // Input to feed the session on its next tick
+        Direction ChooseInput(GameSession &session);
+
+    private:
+        static const Uint16 c_cellCount = Constants::MapRows * Constants::MapCols;
+
+        Direction FindNearestPellet(GameSession &session, Uint16 row, Uint16 col);
+
+        Uint16 _lastRow;                    // Cell the last decision was made in
+        Uint16 _lastCol;
+        Direction _direction;               // Last decision
+        Uint16 _queue[c_cellCount];         // Search scratch, kept here so searching doesn't allocate
+        Uint8 _firstStep[c_cellCount];      // Direction of the first step taken to reach each cell (None = unvisited)
+    };
+}
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <stdio.h>
+#include <vector>
+#include "statehash.h"
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    // One StateChecksum per simulation tick, written next to a replay so a later run of the same input -
+    // another build, an optimized refactor - can be checked against it tick by tick.  The first tick whose
+    // checksum differs is where the runs diverged, and the components that differ say which part of the game
+    // went first.
+    class ChecksumLog
+    {
+    public:
+        ChecksumLog() :
+            _pFile(nullptr)
+        {
+        }
+
+        ~ChecksumLog()
+        {
+            Close();
+        }
+
+        // Start a new log to append to, one entry per tick from the first
+        bool Create(const char *szFileName);
+        void Append(const StateChecksum &checksum);
+        void Close();
+
+        // Read a whole log for At()
+        bool Load(const char *szFileName);
+        Uint32 Length() { return static_cast<Uint32>(_checksums.size()); }
+        const StateChecksum& At(Uint32 tick) { return _checksums[tick]; }
+
+        // Which components differ between expected and actual at tick, returns false if none do
+        static bool ReportDivergence(Uint32 tick, const StateChecksum &expected, const StateChecksum &actual);
+        // Both logs tick by tick up to the shorter one, reporting the first divergence.  Returns true only if
+        // both loaded and matched over every tick they have in common
+        static bool Compare(const char *szExpectedFile, const char *szActualFile);
+
+    private:
+        static const Uint32 c_magic = 0x53434D50;   // "PMCS"
+        static const Uint32 c_version = 1;
+
+        FILE *_pFile;
+        std::vector<StateChecksum> _checksums;
+    };
+}
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include "ghost.h"
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    // Where a configurable ghost is headed, filled in as a screen point.  pContext is whatever was handed to
+    // the ghost along with the function
+    typedef void (*GhostTargetFunction)(void *pContext, Ghost *pGhost, Player *pPlayer, Maze *pMaze, double &xTarget, double &yTarget);
+
+    // A ghost whose targeting is picked at runtime, for mods and experiments that don't want to add a ghost
+    // type.  It moves exactly like the built in ghosts but every branch decision is a call through a
+    // function pointer, so it is the slow path - real ghost types derive from GhostT themselves
+    class ConfigurableGhost : public GhostT<ConfigurableGhost>
+    {
+    public:
+        ConfigurableGhost(TextureWrapper* pTextureWrapper, const AnimationSet *pAnimationSet, GhostTargetFunction pfnTarget, void *pContext);
+
+        bool Initialize();
+        bool Reset(Maze *pMaze);
+        // Swap the targeting, takes effect from the next decision
+        void SetTarget(GhostTargetFunction pfnTarget, void *pContext);
+
+        void GetTarget(Player* pPlayer, Maze *pMaze, double &xTarget, double &yTarget)
+        {
+            _pfnTarget(_pContext, this, pPlayer, pMaze, xTarget, yTarget);
+        }
+
+        // Targeting the --mod-ghosts use, and examples for mods.  Four cells ahead of the player, pContext unused
+        static void TargetAhead(void *pContext, Ghost *pGhost, Player *pPlayer, Maze *pMaze, double &xTarget, double &yTarget);
+        // The cell pContext points at, a const SDL_Point holding { col, row }
+        static void TargetCell(void *pContext, Ghost *pGhost, Player *pPlayer, Maze *pMaze, double &xTarget, double &yTarget);
+
+    private:
+        GhostTargetFunction _pfnTarget;
+        void *_pContext;
+    };
+}
+}
@@ -15,6 +15,8 @@ namespace PacManClone
         static const SDL_Color SDLColorGrey;
         static const SDL_Color SDLColorMagenta;
         static const SDL_Color RenderDrawColor;
+        static const SDL_Color TextColorWhite;
+        static const SDL_Color TextColorYellow;
         static const char * const WindowTitle;
         static const Uint16 MapRows = 36;
         static const Uint16 MapCols = 28;
@@ -39,6 +41,11 @@ namespace PacManClone
         static const Uint16 GhostPenRowExit = 14;
         static const Uint16 GhostPenRow = 17;
         static const Uint16 GhostPenCol = 13;
+        static const Uint8 GhostLookahead = 1;         // Cells ahead a ghost decides its turns, at most 3
+        static const Uint32 StressEntitySeed = 0x5EED;  // Where --stress-entities wanderers start, same every level
+        static const Uint16 MaxModGhosts = 4;           // Most --mod-ghosts a session runs
+        static const Uint16 PelletPoints = 10;
+        static const Uint16 PowerPelletPoints = 50;
 
         static const double PlayerMaxSpeed;
         static const double GhostBaseSpeed;
@@ -81,6 +88,16 @@ namespace PacManClone
         static const char * const TilesImage;
         static const char * const SpritesImage;
 
+        // Every texture the game loads, by the asset id it is packed and registered under
+        struct TextureAsset
+        {
+            const char *pszId;
+            const char *pszFileName;
+            const SDL_Color *pColorKey;     // Pixels of this color are transparent, nullptr for none
+        };
+        static const Uint16 TextureAssetCount = 2;
+        static const TextureAsset TextureAssets[TextureAssetCount];
+
     private:
         static const Uint32 c_msPerSecond = 1000;
         static const Uint32 c_msPerFrame = (c_msPerSecond / FramesPerSecond);
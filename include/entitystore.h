@@ -0,0 +1,88 @@
+#pragma once
+#include "SDL.h"
+#include "constants.h"
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    class Maze;
+
+    // What a stored entity is doing, decides which systems touch it
+    enum class EntityMode : Uint8
+    {
+        Wander = 0,     // In the maze, turns at tile centers
+        Tunnel = 1,     // In the warp tunnel columns, just keeps going until it wraps
+    };
+
+    // Lots of simple moving things - stress load for the simulation.  Rather than one object per entity,
+    // every component lives in its own contiguous array (positions, velocities, cells, mode) and each
+    // system is a straight loop over one or two of them, so the compiler can vectorize the motion passes.
+    // Only entities sitting exactly on a tile center go through the (scalar) steering pass.
+    // The arrays are allocated once by Reserve(), spawning and updating never allocate.  Entities move a
+    // whole number of pixels that divides the half tile, so every center is landed on exactly and runs are
+    // deterministic for a given seed.
+    class EntityStore
+    {
+    public:
+        EntityStore() :
+            _capacity(0),
+            _count(0),
+            _pX(nullptr),
+            _pY(nullptr),
+            _pDX(nullptr),
+            _pDY(nullptr),
+            _pRow(nullptr),
+            _pCol(nullptr),
+            _pMode(nullptr),
+            _pAtCenter(nullptr),
+            _random(1),
+            _updateCounter(0),
+            _cUpdates(0)
+        {
+        }
+
+        ~EntityStore();
+
+        // Make room for cEntities, only allocates when growing
+        void Reserve(Uint32 cEntities);
+        // Drop every entity, keeps the arrays
+        void Clear();
+        // Fill the store (up to the reserved capacity) with wanderers on random open tiles of pMaze
+        void SpawnWanderers(Maze *pMaze, Uint32 cEntities, Uint32 seed);
+        // Run every system once - one fixed tick
+        void Update(Maze *pMaze);
+        // Draw every entity with the same frame from the sprite texture
+        void Render(SDL_Renderer *pSDLRenderer, SDL_Texture *pTexture, const SDL_Rect &frameRect, int xFrameOffset, int yFrameOffset);
+
+        Uint32 Count() { return _count; }
+        // Average time spent in Update() so far
+        void PrintStats();
+
+    private:
+        // Systems, each a single pass over the arrays
+        void IntegrateMotion();
+        void UpdateCells(int xMap, int yMap);
+        void WrapTunnels(int xMap, int cxMap);
+        void FindCenters(int xMap, int yMap);
+        void Steer(Maze *pMaze);
+
+        void Release();
+        Uint32 NextRandom();
+
+        Uint32 _capacity;
+        Uint32 _count;
+        float *_pX;                     // Position (center of the entity)
+        float *_pY;
+        float *_pDX;                    // Velocity, whole pixels per tick along one axis
+        float *_pDY;
+        Sint16 *_pRow;                  // Tile the position is in, -1/MapCols just outside the tunnel ends
+        Sint16 *_pCol;
+        EntityMode *_pMode;
+        Uint8 *_pAtCenter;              // Scratch for the steering pass, 1 - exactly on the tile center this tick
+        Uint32 _random;                 // xorshift state, seeded by SpawnWanderers()
+        Uint64 _updateCounter;          // Performance counter ticks spent in Update()
+        Uint32 _cUpdates;
+    };
+}
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include "spscqueue.h"
+#include <stdio.h>
+#include <thread>
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    // Records presented frames to disk without holding up the main loop.  Each frame is read back into one
+    // of a fixed pool of buffers allocated up front, and the buffer is handed to a writer thread through a
+    // lock-free queue.  If the writer falls behind and no buffer is free the frame is dropped (and counted)
+    // rather than waiting, so the game's frame pacing never depends on the disk.
+    //
+    // File layout: a header { magic, version, width, height, fps } then one record per frame
+    // { frameNumber, encoding, payloadBytes } + payload.  Raw payloads are width * height RGBA pixels.  Delta
+    // payloads are the XOR against the previous written frame, stored as pairs of { zero run, literal count }
+    // 32 bit words followed by the literal pixels - gameplay frames are mostly unchanged so this is small.
+    class FrameCapture
+    {
+    public:
+        enum class Encoding : Uint32
+        {
+            Raw = 0,
+            Delta = 1,
+        };
+
+        FrameCapture();
+        ~FrameCapture();
+
+        bool Open(const char *szFileName, int width, int height, Encoding encoding);
+        // Read back the current render target (call before SDL_RenderPresent), never blocks
+        void Capture(SDL_Renderer *pSDLRenderer, Uint32 frameNumber);
+        void Close();
+
+        bool IsOpen() { return _pFile != nullptr; }
+        Uint32 FramesCaptured() { return _cCaptured; }
+        Uint32 FramesDropped() { return _cDropped; }
+
+    private:
+        static const Uint32 c_magic = 0x56434D50;   // "PMCV"
+        static const Uint32 c_version = 1;
+        static const Uint32 c_poolSize = 8;         // Frames in flight between the game and the writer
+        static const Uint32 c_noBuffer = 0xFFFFFFFF;
+
+        struct FrameRecord
+        {
+            Uint32 frameNumber;
+            Uint32 encoding;
+            Uint32 payloadBytes;
+        };
+
+        struct Slot
+        {
+            Uint32 bufferIndex;
+            Uint32 frameNumber;
+        };
+
+        void WriterThread();
+        void WriteFrame(const Slot &slot);
+        Uint32 EncodeDelta(const Uint32 *pFrame);
+
+        FILE *_pFile;
+        int _width;
+        int _height;
+        Uint32 _cPixels;
+        Encoding _encoding;
+        Uint32 *_pPool;                             // c_poolSize frames back to back
+        Uint32 *_pPrevious;                         // Last frame written (writer only, delta encoding)
+        Uint32 *_pScratch;                          // Encoded delta output (writer only)
+        SpscQueue<Uint32, 16> _freeBuffers;         // Writer -> game: buffers ready to fill
+        SpscQueue<Slot, 16> _filledBuffers;         // Game -> writer: frames ready to write
+        Uint32 _heldBuffer;                         // Game only: taken but not filled (failed read back), used next
+        std::atomic<bool> _fStopping;
+        std::thread _writer;
+        Uint32 _cCaptured;
+        Uint32 _cDropped;
+        Uint64 _cBytesWritten;                      // Writer only, read after join
+    };
+}
+}
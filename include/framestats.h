@@ -0,0 +1,102 @@
+#pragma once
+#include "SDL.h"
+#include <stdio.h>
+#include "glyphatlas.h"
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    // Counts of durations in microseconds, HDR histogram style: exact below 64us, then 32 buckets for every
+    // power of 2 above that, so any value is placed to within about 3% and the whole range up to an hour
+    // fits in a fixed array.  Recording is an index calculation and an increment.
+    class LatencyHistogram
+    {
+    public:
+        LatencyHistogram() { Reset(); }
+
+        void Record(Uint32 us);
+        void Reset();
+        // Smallest value that at least fraction (0-1) of the recorded values are at or below, as the top of
+        // its bucket so it never reads optimistic
+        Uint32 Percentile(double fraction) const;
+        Uint32 Max() const { return _max; }
+        Uint32 Count() const { return _count; }
+
+    private:
+        static const Uint32 c_subBucketBits = 5;
+        static const Uint32 c_subBuckets = 1 << c_subBucketBits;
+        static const Uint32 c_buckets = (32 - c_subBucketBits + 1) * c_subBuckets;
+
+        static Uint32 BucketIndex(Uint32 us);
+        static Uint32 BucketTop(Uint32 index);
+
+        Uint32 _counts[c_buckets];
+        Uint32 _count;
+        Uint32 _max;
+    };
+
+    // Frame pacing for the windowed loops.  Every frame's total time (including the wait for the next slot),
+    // simulation time and present time go into histograms for the whole run and for the current second.
+    // A frame over the budget counts as missed.  Optionally each second is appended to a CSV file (for soak
+    // runs), and an overlay with the percentiles and a sparkline of recent frames can be drawn over the left
+    // margin.  Nothing allocates after Initialize().
+    class FrameStats
+    {
+    public:
+        FrameStats() :
+            _usBudget(0),
+            _cFrames(0),
+            _cMissed(0),
+            _usSecondElapsed(0),
+            _cSecondMissed(0),
+            _iSecond(0),
+            _iRecent(0),
+            _fOverlay(false),
+            _cFramesSinceLayout(0),
+            _pCsvFile(nullptr)
+        {
+            SDL_memset(_recentFrames, 0, sizeof(_recentFrames));
+        }
+
+        ~FrameStats();
+
+        // pGlyphAtlas is needed for the overlay, szCsvFile is optional
+        bool Initialize(GlyphAtlas *pGlyphAtlas, Uint32 usBudget, const char *szCsvFile);
+        void AddFrame(Uint32 usFrame, Uint32 usSim, Uint32 usPresent);
+        void ToggleOverlay() { _fOverlay = !_fOverlay; }
+        void SetOverlay(bool fOverlay) { _fOverlay = fOverlay; }
+        void RenderOverlay(SDL_Renderer *pSDLRenderer);
+        // Whole run percentiles and whether the run met the SLO, only if any frames were recorded
+        void PrintSummary();
+        void Close();
+
+    private:
+        static const Uint32 c_recentFrames = 80;            // Sparkline width in frames
+        static const Uint16 c_cLabels = 6;
+        static const double c_sloFraction;                  // Frames that must be in budget
+
+        void EndSecond();
+        void LayoutOverlay();
+
+        Uint32 _usBudget;
+        LatencyHistogram _frameTimes;           // Whole run
+        LatencyHistogram _simTimes;
+        LatencyHistogram _presentTimes;
+        LatencyHistogram _secondFrameTimes;     // Current second
+        LatencyHistogram _secondSimTimes;
+        LatencyHistogram _secondPresentTimes;
+        Uint64 _cFrames;
+        Uint64 _cMissed;
+        Uint32 _usSecondElapsed;                // Frame time added up, a second ends when it passes 1,000,000
+        Uint32 _cSecondMissed;
+        Uint32 _iSecond;
+        Uint32 _recentFrames[c_recentFrames];   // Ring of the latest frame times for the sparkline
+        Uint32 _iRecent;
+        bool _fOverlay;
+        Uint32 _cFramesSinceLayout;             // The text is only refreshed a few times a second
+        TextLabel _labels[c_cLabels];
+        FILE *_pCsvFile;
+    };
+}
+}
@@ -2,72 +2,84 @@
 #include <stdio.h>
 #include "constants.h"
 #include "utils.h"
-#include "player.h"
-#include "blinky.h"
+#include "options.h"
+#include "replay.h"
+#include "gamesession.h"
+#include "framecapture.h"
+#include "mosaic.h"
+#include "assetloader.h"
+#include "assetpack.h"
+#include "textureregistry.h"
+#include "framestats.h"
+#include "checksumlog.h"
 
 namespace XplatGameTutorial
 {
 namespace PacManClone
 {
 
-// Encapsulates the game, tracks state, player, pellets, ghosts, score, etc
-// Things that are tightly game sepcific should go here (e.g. PlayerSprite 
-// vs 2DTiledMap which is more generic)
+// Owns the process level pieces - SDL, the window (or offscreen surface), the textures and the main
+// loop - and drives a GameSession with them.  Things that are tightly game sepcific live in the
+// session (e.g. PlayerSprite vs 2DTiledMap which is more generic)
 class GameHarness
 {
 public:
     GameHarness() :
         _fInitialized(false),
-        _state(GameState::Title),
         _pSDLRenderer(nullptr),
         _pSDLWindow(nullptr),
-        _pTilesTexture(nullptr),
-        _pSpriteTexture(nullptr),
-        _pMaze(nullptr),
-        _pPlayer(nullptr),
-        _pBlinky(nullptr)
+        _pSDLSurface(nullptr),
+        _pGlyphAtlas(nullptr),
+        _startCounter(0),
+        _msSDLInit(0.0),
+        _msUpload(0.0),
+        _fFirstFramePresented(false),
+        _usLastPresent(0)
     {
     }
 
-    SDL_bool Initialize();  // Needs to be called successfully before Run()
-    void Run();             // Main loop
+    SDL_bool Initialize(const GameOptions &options);    // Needs to be called successfully before Run()
+    int Run();                                          // Main loop, returns the process exit code
 
 private:
-    enum class GameState
-    {
-        Title,                  // Eventual Title screen
-        LoadingLevel,           // Once we add levels, we'll need a way to "load/select" the correct map, etc
-        WaitingToStartLevel,    // Starting animation (gives the player a chance to get bearings)
-        Running,                // Playing - most time should be in here! :)
-        PlayerDying,            // Got caught by a ghost
-        LevelComplete,          // Ate all the pellets on the current level (flashing level animation)
-        GameOver,               // All lives are gone - cycles back to title after some time or input
-        Exiting                 // App is closing
-    };
-
     // Methods
     void Cleanup();
-    void InitializeSprites();
+    bool LoadLevelFromPack();
+    bool HandleEvent(const SDL_Event &eventSDL);
     bool ProcessInput(Direction *pInputDirection);
-    Uint16 HandlePelletCollision();
     void Render();
-    
-    // GameState Handlers
-    GameState OnLoading();
-    GameState OnWaitingToStartLevel();
-    GameState OnRunning();
-    GameState OnLevelComplete();
-    
+    void PrintTimeToFirstFrame();
+    void WriteTrace();
+    bool CheckTick();
+    int RunWindowed();
+    int RunHeadless();
+    int RunMosaic();
+    int RunAllocCheck();
+    int RunLookaheadCheck();
+
     // Members
     bool _fInitialized;                 // Tracks if we've started SDL
-    GameState _state;                   // current GameState
+    GameOptions _options;               // Command line options
     SDL_Renderer *_pSDLRenderer;        // SDL renderer object
-    SDL_Window *_pSDLWindow;            // SDL window object
-    TextureWrapper *_pTilesTexture;     // Texture that holds the maze tiles
-    TextureWrapper *_pSpriteTexture;    // Texture that holds the sprite frames
-    Maze *_pMaze;                       // Maze - playing area
-    Player *_pPlayer;                   // The player sprite PacManClone
-    Blinky *_pBlinky;                   // Our first ghost
+    SDL_Window *_pSDLWindow;            // SDL window object (windowed only)
+    SDL_Surface *_pSDLSurface;          // Offscreen RGBA frame (headless only)
+    TextureRegistry _textureRegistry;   // Owns every texture loaded for _pSDLRenderer
+    TextureHandle _tilesTexture;        // Texture that holds the maze tiles
+    TextureHandle _spriteTexture;       // Texture that holds the sprite frames
+    GlyphAtlas *_pGlyphAtlas;           // HUD font
+    GameSession _session;               // The game being played
+    Replay _replay;                     // Input being played back or recorded
+    FrameCapture _capture;              // Optional recording of the rendered frames
+    AssetLoader _assetLoader;           // Decodes the textures in the background during startup
+    AssetPack _assetPack;               // Pre-decoded textures and level, used instead of the loader when present
+    Uint64 _startCounter;               // Performance counter at the top of Initialize()
+    double _msSDLInit;                  // Startup breakdown for the time to first frame report
+    double _msUpload;
+    bool _fFirstFramePresented;
+    FrameStats _frameStats;             // Frame pacing of the windowed loops
+    Uint32 _usLastPresent;              // How long the last SDL_RenderPresent() took
+    ChecksumLog _checksumLog;           // Per tick state checksums being written (optional)
+    ChecksumLog _expectedChecksums;     // Per tick state checksums the run is checked against (optional)
 };
 }
-}
\ No newline at end of file
+}
@@ -0,0 +1,176 @@
+#pragma once
+#include <stdio.h>
+#include "constants.h"
+#include "utils.h"
+#include "player.h"
+#include "blinky.h"
+#include "configurableghost.h"
+#include "glyphatlas.h"
+#include "entitystore.h"
+#include "metrics.h"
+#include "textureregistry.h"
+#include <thread>
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+
+// Everything needed to draw a session, copied out so it can be drawn on another thread while the
+// session keeps running.  Tiles are only copied when tilesVersion says they changed.
+struct SessionSnapshot
+{
+    static const Uint16 c_maxSprites = 2 + Constants::MaxModGhosts;
+
+    SessionSnapshot() : tick(0), tilesVersion(0), fFlashTiles(false), cSprites(0)
+    {
+        SDL_memset(&mapBounds, 0, sizeof(mapBounds));
+    }
+
+    Uint32 tick;                                        // Session tick this was taken on
+    Uint32 tilesVersion;                                // 0 until a level has loaded
+    bool fFlashTiles;                                   // Level complete tint
+    SDL_Rect mapBounds;                                 // Screen rect of the maze, sprite targets are relative to this
+    Uint16 tiles[Constants::MapRows * Constants::MapCols];
+    Uint16 cSprites;
+    SDL_Rect spriteSource[c_maxSprites];                // Frame on the sprite texture
+    SDL_Rect spriteTarget[c_maxSprites];                // Screen rect
+};
+
+// One running game - the maze, the sprites and the game state machine.  It knows nothing about windows,
+// events or frame pacing: the owner feeds it one input per tick and asks it to render when it wants a
+// frame.  That lets the same simulation run in the window, offscreen, or many times over in one process.
+// Textures are borrowed from the owner and may be shared between sessions.
+class GameSession
+{
+public:
+    GameSession() :
+        _state(GameState::Title),
+        _pMaze(nullptr),
+        _pNextMaze(nullptr),
+        _fNextMazeReady(false),
+        _pPlayer(nullptr),
+        _pBlinky(nullptr),
+        _modGhosts(),
+        _cModGhosts(0),
+        _cModGhostsSpawned(0),
+        _fTickAnimation(false),
+        _cStressEntities(0),
+        _ghostLookahead(Constants::GhostLookahead),
+        _simTicks(0),
+        _tickCount(0),
+        _pelletsEaten(0),
+        _cLevelsCompleted(0),
+        _flashCounter(0),
+        _fFlashTiles(false),
+        _tilesVersion(0),
+        _pGlyphAtlas(nullptr),
+        _score(0),
+        _highScore(0),
+        _pLevelTiles(Constants::MapIndicies),
+        _levelTextureRect{ 0, 0, Constants::TileTextureWidth, Constants::TileTextureHeight },
+        _levelTileRect{ 0, 0, Constants::TileWidth, Constants::TileHeight }
+    {
+        Metrics::Sessions.Add(1);
+    }
+
+    ~GameSession();
+
+    // The session takes its own reference to each texture.  pGlyphAtlas is optional, without it there is no HUD
+    void Initialize(const TextureHandle &tilesTexture, const TextureHandle &spriteTexture, GlyphAtlas *pGlyphAtlas);
+    void ReleaseTextures();                     // Drop those references, the session can't be ticked or drawn after
+    // Level layout to use instead of the built in one (e.g. from the asset pack), must outlive the session
+    void SetLevel(const Uint16 *pMapIndicies, SDL_Rect textureRect, SDL_Rect tileRect);
+    void Tick(Direction inputDirection);        // Advance the game a single fixed step
+    void RestartLevel();                        // Back to the start of the current level, never allocates
+    void CompleteLevel();                       // Straight to the level complete sequence (scripted runs), only while running
+    void SetTickAnimation(bool fTickAnimation); // Sprite frames come from the tick count (see Sprite::SetTickAnimation)
+    void SetStressEntities(Uint32 cEntities);   // Extra wandering entities, spawned with each level (0 - none)
+    void SetGhostLookahead(Uint8 lookahead);    // Cells ahead the ghosts decide their turns (see Ghost::SetLookahead)
+    void SetModGhosts(Uint32 cGhosts);          // Extra runtime targeted ghosts, spawned with each level (0 - none)
+    void Render(SDL_Renderer *pSDLRenderer);    // Draw the current state, does not present
+
+    // Copy what Render() would draw into pSnapshot, which may hold an older snapshot from this session
+    void Snapshot(SessionSnapshot *pSnapshot);
+    // Hash of the simulation state as of the last tick, per component (the stress entities are left out)
+    void Checksum(StateChecksum *pChecksum);
+    // Any ghost has a queued decision turning straight back (the --lookahead-check self check)
+    bool HasReversedGhostDecision();
+
+    Uint32 TickCount() { return _tickCount; }
+    Uint32 Score() { return _score; }
+    Uint32 LevelsCompleted() { return _cLevelsCompleted; }
+    bool IsRunning() { return _state == GameState::Running; }
+    Maze* GetMaze() { return _pMaze; }
+    Player* GetPlayer() { return _pPlayer; }
+    Blinky* GetBlinky() { return _pBlinky; }
+    EntityStore& Entities() { return _entities; }
+
+private:
+    enum class GameState
+    {
+        Title,                  // Eventual Title screen
+        LoadingLevel,           // Once we add levels, we'll need a way to "load/select" the correct map, etc
+        WaitingToStartLevel,    // Starting animation (gives the player a chance to get bearings)
+        Running,                // Playing - most time should be in here! :)
+        PlayerDying,            // Got caught by a ghost
+        LevelComplete,          // Ate all the pellets on the current level (flashing level animation)
+        GameOver,               // All lives are gone - cycles back to title after some time or input
+    };
+
+    // Methods
+    void InitializeSprites();
+    Uint16 HandlePelletCollision();
+    void AddScore(Uint32 points);
+    void RenderHud(SDL_Renderer *pSDLRenderer);
+
+    // Level preparation
+    void PrepareMaze(Maze **ppMaze);
+    void StartPrefetch();
+    void FinishPrefetch();
+
+    // GameState Handlers
+    GameState OnLoading();
+    GameState OnWaitingToStartLevel();
+    GameState OnRunning(Direction inputDirection);
+    GameState OnLevelComplete();
+
+    // Members
+    GameState _state;                   // current GameState
+    TextureHandle _tilesTexture;        // Texture that holds the maze tiles
+    TextureHandle _spriteTexture;       // Texture that holds the sprite frames, the sprites borrow it from here
+    Maze *_pMaze;                       // Maze - playing area
+    Maze *_pNextMaze;                   // Spare maze, the next level is prepared in it while the level complete flash runs
+    bool _fNextMazeReady;               // _pNextMaze holds a pristine level
+    std::thread _prefetchThread;
+    Player *_pPlayer;                   // The player sprite PacManClone
+    Blinky *_pBlinky;                   // Our first ghost
+    ConfigurableGhost *_modGhosts[Constants::MaxModGhosts];    // Created the first level they are asked for, then kept
+    Uint32 _cModGhosts;                 // How many to spawn with each level
+    Uint32 _cModGhostsSpawned;          // How many are in play this level, updated as one batch
+    bool _fTickAnimation;               // Sprites work their frame out from the tick count
+    EntityStore _entities;              // Stress load, moved along with the sprites while running
+    Uint32 _cStressEntities;            // How many to spawn with each level
+    Uint8 _ghostLookahead;              // Handed to every ghost
+    Uint32 _simTicks;                   // Simulated milliseconds, what the GameClock reads during Tick()
+    Uint32 _tickCount;                  // Ticks since the session started
+    StateTimer _stateTimer;             // Shared by the timed states, only one is ever active
+    Uint16 _pelletsEaten;               // Pellets eaten on the current level
+    Uint32 _cLevelsCompleted;           // Levels cleared since the session started
+    Uint16 _flashCounter;               // Frames since the last flash on level complete
+    bool _fFlashTiles;                  // Tint the maze blue (level complete flashing)
+    Uint32 _tilesVersion;               // Bumped whenever a tile changes (pellets, level loads)
+    GlyphAtlas *_pGlyphAtlas;           // HUD font (not owned, optional)
+    Uint32 _score;
+    Uint32 _highScore;
+    const Uint16 *_pLevelTiles;         // MapRows * MapCols tile indices the maze starts each level from
+    SDL_Rect _levelTextureRect;         // Layout of the tiles texture
+    SDL_Rect _levelTileRect;
+    TextLabel _oneUpLabel;              // HUD text, only re-laid out when the text changes
+    TextLabel _scoreLabel;
+    TextLabel _highScoreTitleLabel;
+    TextLabel _highScoreLabel;
+    TextLabel _readyLabel;
+};
+}
+}
@@ -8,33 +8,42 @@ namespace XplatGameTutorial
 namespace PacManClone
 {
     // Our Ghost class will encapsulate the basic behavior common to every ghost
-    // (e.g. movement when not at an intersection) but will defer branching logic
-    // (e.g. the case above - intersections) and texture specific loading and values
-    // like base speed to a derived class.
-    // I.e. this class does not exist by itself, somewhere there is a Blinky : Ghost,
-    // Clyde : Ghost, etc
+    // (e.g. movement when not at an intersection) but will defer the one thing that
+    // makes each ghost different - where it is headed when it reaches an intersection -
+    // to the ghost type.  That is resolved at compile time rather than through virtuals
+    // (see GhostT below), it is asked for on every lookahead step so it is the hottest
+    // call in the ghost AI.
+    // I.e. this class does not exist by itself, somewhere there is a Blinky : GhostT<Blinky>,
+    // Clyde : GhostT<Clyde>, etc
     class Ghost : public Sprite
     {
     public:
-        Ghost(TextureWrapper *pTextureWrapper, Uint16 cxFrame, Uint16 cyFrame, Uint16 cFramesTotal, Uint16 cAnimationsTotal);
+        Ghost(TextureWrapper *pTextureWrapper, const AnimationSet *pAnimationSet);
         
         virtual ~Ghost()
         {
-            SafeDelete<Decision>(_pCurrentDecision);
-            SafeDelete<Decision>(_pNextDecision);
         }
 
-        // "Interface" for Ghosts to implement
-        virtual bool Initialize() = 0;
-        virtual bool Reset(Maze *pMaze) = 0;
-        virtual Direction MakeBranchDecision(Uint16 nRow, Uint16 nCol, Player* pPlayer, Maze *pMaze) = 0;
-
-        // General movement that is common to all ghosts
-        void Update(Player* pPlayer, Maze* pMaze);
+        // Still waiting in the pen or on the way out of it
+        bool IsInPen() { return IsGhostPenned() || (_mode == Mode::ExitingPen); }
+        // Sprite state plus the mode, cell, pen timer and every decision queued up
+        void HashState(StateHasher &hasher);
+        // Cells ahead to decide turns, 1 up to what the ring holds.  Takes effect as the ring refills
+        void SetLookahead(Uint8 lookahead);
+        // Any queued decision heading straight back the way the decision before it arrives (self check)
+        bool HasReversedDecision();
 
     protected:
+        // Small enough to hold by value, so deciding never allocates
         struct Decision
         {
+            Decision() :
+                row(0),
+                col(0),
+                direction(Direction::None)
+            {
+            }
+
             Decision(Uint16 r, Uint16 c, Direction newDirection) :
                 row(r),
                 col(c),
@@ -52,6 +61,39 @@ namespace PacManClone
             Direction direction;
         };
 
+        // Decisions for the current cell and the cells coming up, in order.  A fixed ring stored inline, so
+        // moving on to the next cell is an index bump rather than any allocation
+        class DecisionRing
+        {
+        public:
+            static const Uint8 c_capacity = 4;
+
+            DecisionRing() : _head(0), _count(0) {}
+
+            Uint8 Count() const { return _count; }
+            Decision& At(Uint8 index) { SDL_assert(index < _count); return _items[(_head + index) % c_capacity]; }
+            Decision& Front() { return At(0); }
+            Decision& Back() { return At(_count - 1); }
+            void Clear() { _head = 0; _count = 0; }
+            void Push(const Decision &decision)
+            {
+                SDL_assert(_count < c_capacity);
+                _items[(_head + _count) % c_capacity] = decision;
+                _count++;
+            }
+            void PopFront()
+            {
+                SDL_assert(_count > 0);
+                _head = (_head + 1) % c_capacity;
+                _count--;
+            }
+
+        private:
+            Decision _items[c_capacity];
+            Uint8 _head;
+            Uint8 _count;
+        };
+
         // Internal state
         enum class Mode
         {
@@ -62,8 +104,26 @@ namespace PacManClone
             ExitingPen,
         };
 
-        Direction GetNextDirection(Uint16 r, Uint16 c, Maze *pMaze);
-        Decision* GetNextDecision(Player *pPlayer, Maze* pMaze);
+        // General movement that is common to all ghosts.  TGhost supplies
+        //   void GetTarget(Player *pPlayer, Maze *pMaze, double &xTarget, double &yTarget)
+        // the screen point it wants to get closest to, and is compiled in - the templates are instantiated for
+        // each ghost type at the bottom of ghost.cpp
+        template <class TGhost> void UpdateAs(Player* pPlayer, Maze* pMaze);
+        template <class TGhost> Decision GetDecisionAfter(Decision &previous, Player *pPlayer, Maze* pMaze);
+        template <class TGhost> void FillDecisions(Player *pPlayer, Maze* pMaze);
+        template <class TGhost> void OnChasing(Player* pPlayer, Maze* pMaze);
+
+        // Start of a level, in the pen heading up
+        void ResetToPen(Maze *pMaze);
+        // Of the open exits from [nRow, nCol] (never straight back the way we arrive), the one closest to the target point
+        Direction ClosestExit(Uint16 nRow, Uint16 nCol, Direction arrivingDirection, double xTarget, double yTarget, Maze *pMaze);
+        Direction GetNextDirection(Uint16 r, Uint16 c, Direction arrivingDirection, Maze *pMaze);
+        Decision& CurrentDecision() { return _decisions.Front(); }
+        void SetCurrentDecision(const Decision &decision)
+        {
+            _decisions.Clear();
+            _decisions.Push(decision);
+        }
         bool IsGhostWarpingOut(Maze* pMaze);
         bool IsGhostPenned()
         {
@@ -75,7 +135,6 @@ namespace PacManClone
         void OnExitingPen(Player* pPlayer, Maze* pMaze);
         void OnWarpingOut(Player* pPlayer, Maze* pMaze);
         void OnWarpingIn(Player* pPlayer, Maze* pMaze);
-        void OnChasing(Player* pPlayer, Maze* pMaze);
 
         void UpdateAnimation(Direction direction);
         
@@ -83,8 +142,34 @@ namespace PacManClone
         Uint16 _currentRow;             // Current cell location
         Uint16 _currentCol;
         Mode _mode;                     // Chase, scatter, etc
-        Decision *_pNextDecision;       // Decision for the coming cell
-        Decision *_pCurrentDecision;    // Decision for our current cell
+        DecisionRing _decisions;        // Decision for our current cell, then up to _lookahead coming cells
+        Uint8 _lookahead;               // How many cells ahead to decide (Constants::GhostLookahead)
+    };
+
+    // The base for a concrete ghost type, TGhost being the ghost itself (class Blinky : public GhostT<Blinky>).
+    // Everything about the type is known at compile time, so its targeting inlines into the decision code
+    // and a batch of the same type updates in a plain loop with no indirect calls at all
+    template <class TGhost> class GhostT : public Ghost
+    {
+    public:
+        GhostT(TextureWrapper *pTextureWrapper, const AnimationSet *pAnimationSet) :
+            Ghost(pTextureWrapper, pAnimationSet)
+        {
+        }
+
+        void Update(Player* pPlayer, Maze* pMaze)
+        {
+            UpdateAs<TGhost>(pPlayer, pMaze);
+        }
+
+        // Every ghost of one type in one pass
+        static void UpdateBatch(TGhost *const *ppGhosts, size_t cGhosts, Player* pPlayer, Maze* pMaze)
+        {
+            for (size_t index = 0; index < cGhosts; index++)
+            {
+                ppGhosts[index]->template UpdateAs<TGhost>(pPlayer, pMaze);
+            }
+        }
     };
 }
 }
\ No newline at end of file
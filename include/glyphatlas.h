@@ -0,0 +1,86 @@
+#pragma once
+#include "SDL.h"
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    // A small built in bitmap font (digits, upper case letters and a little punctuation) rasterized once into
+    // a single texture.  Glyphs are white on transparent so text color comes from the texture color mod, and
+    // they are the same size as a maze tile so text lines up with the map.
+    class GlyphAtlas
+    {
+    public:
+        static const Uint16 GlyphWidth = 16;
+        static const Uint16 GlyphHeight = 16;
+
+        GlyphAtlas() : _pTexture(nullptr)
+        {
+            SDL_memset(_glyphSlots, 0xFF, sizeof(_glyphSlots));
+        }
+
+        ~GlyphAtlas();
+
+        bool Initialize(SDL_Renderer *pSDLRenderer);
+        // Source rect for a character, false if the font has nothing to draw for it (e.g. space)
+        bool GetGlyph(char ch, SDL_Rect &sourceRect);
+        SDL_Texture* Ptr() { return _pTexture; }
+
+    private:
+        static const Uint16 c_glyphsPerRow = 16;
+
+        SDL_Texture *_pTexture;
+        Uint8 _glyphSlots[128];     // Character -> slot in the atlas, 0xFF for none
+    };
+
+    enum class TextAlign
+    {
+        Left = 0,   // x is where the text starts
+        Right,      // x is where the text ends
+    };
+
+    // A line of text drawn from the glyph atlas.  Laying out the text (looking up each glyph and placing it)
+    // only happens when the text actually changes, drawing reuses the cached rects.  Everything is in fixed
+    // arrays, so setting and drawing text never allocates.
+    class TextLabel
+    {
+    public:
+        static const Uint16 c_maxChars = 32;
+
+        TextLabel() :
+            _pGlyphAtlas(nullptr),
+            _x(0),
+            _y(0),
+            _align(TextAlign::Left),
+            _cGlyphs(0),
+            _fHasNumber(false),
+            _number(0)
+        {
+            _szText[0] = '\0';
+            _color = { 255, 255, 255, 255 };
+        }
+
+        void Initialize(GlyphAtlas *pGlyphAtlas, int x, int y, TextAlign align, SDL_Color color);
+        // Changes the text, re-laying it out only if it is different
+        void SetText(const char *szText);
+        // Shows a number, formatting it only if the value changed
+        void SetNumber(Uint32 value);
+        void Render(SDL_Renderer *pSDLRenderer);
+
+    private:
+        void Layout();
+
+        GlyphAtlas *_pGlyphAtlas;               // Not owned
+        int _x;
+        int _y;
+        TextAlign _align;
+        SDL_Color _color;
+        char _szText[c_maxChars + 1];           // What is currently laid out
+        Uint16 _cGlyphs;                        // Glyphs to draw (spaces and unknowns are skipped)
+        SDL_Rect _sourceRects[c_maxChars];
+        SDL_Rect _targetRects[c_maxChars];
+        bool _fHasNumber;                       // _number is what _szText shows
+        Uint32 _number;
+    };
+}
+}
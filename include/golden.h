@@ -0,0 +1,30 @@
+#pragma once
+#include "SDL.h"
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    // Result of comparing a rendered frame with its golden image
+    struct GoldenResult
+    {
+        Uint32 cPixelsDifferent;    // Pixels where any channel was off by more than the tolerance
+        Uint8 maxChannelDelta;      // Largest single channel difference seen
+    };
+
+    // Golden image regression helpers for the offscreen renderer.  Frames are compared in memory as 32bpp
+    // RGBA, the golden PNG is converted once to the frame's pixel format on load.
+    class GoldenImage
+    {
+    public:
+        // Builds the file name used for a given tick, e.g. "<dir>/tick_000120.png"
+        static void FileNameForTick(const char *szDir, Uint32 tick, char *szFileName, size_t cchFileName);
+
+        // Writes the frame out as the new golden image
+        static bool Save(SDL_Surface *pFrame, const char *szFileName);
+
+        // Compares the frame against the golden image, returns false if the golden could not be loaded
+        static bool Compare(SDL_Surface *pFrame, const char *szFileName, Uint8 tolerance, GoldenResult *pResult);
+    };
+}
+}
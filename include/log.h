@@ -0,0 +1,147 @@
+#pragma once
+#include "SDL.h"
+#include <stdio.h>
+
+// PMC_LOG_ERROR(LogCategory::Render, "SDL_CreateRenderer() failed, error = %s\n", SDL_GetError()) and friends.
+// Below the level set with Log::SetLevel() the arguments aren't even evaluated.  printf style formats, but the
+// format must be a string literal (only the pointer is kept) and each % conversion takes exactly one argument
+// - no * widths.  Strings are copied, everything else goes by value
+#define PMC_LOG(level, category, ...) \
+    do \
+    { \
+        if (XplatGameTutorial::PacManClone::Log::IsEnabled(level)) \
+        { \
+            XplatGameTutorial::PacManClone::Log::Write(level, category, __VA_ARGS__); \
+        } \
+    } while (0)
+#define PMC_LOG_DEBUG(category, ...) PMC_LOG(XplatGameTutorial::PacManClone::LogLevel::Debug, category, __VA_ARGS__)
+#define PMC_LOG_INFO(category, ...) PMC_LOG(XplatGameTutorial::PacManClone::LogLevel::Info, category, __VA_ARGS__)
+#define PMC_LOG_WARNING(category, ...) PMC_LOG(XplatGameTutorial::PacManClone::LogLevel::Warning, category, __VA_ARGS__)
+#define PMC_LOG_ERROR(category, ...) PMC_LOG(XplatGameTutorial::PacManClone::LogLevel::Error, category, __VA_ARGS__)
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    enum class LogLevel : Uint8
+    {
+        Debug = 0,
+        Info,
+        Warning,
+        Error,
+        Count
+    };
+
+    enum class LogCategory : Uint8
+    {
+        General = 0,
+        Harness,        // Startup, the loops, shutdown
+        Render,         // SDL video, renderers, textures
+        Assets,         // Images, packs, animations
+        Sim,            // The game itself
+        Count
+    };
+
+    // One log call, encoded as-is: the format pointer, a time stamp and the raw argument values (strings copied
+    // in).  Turning it into text is left to the writer thread
+    struct LogRecord
+    {
+        static const Uint8 c_maxArgs = 8;
+        static const Uint16 c_cbStrings = 96;
+
+        enum class ArgType : Uint8
+        {
+            Signed,
+            Unsigned,
+            Double,
+            String,         // Value is the offset of the copy in strings[]
+            Pointer,
+        };
+
+        const char *szFormat;
+        Uint64 counter;                 // Performance counter when logged, to the writer's couple of ms (see Log)
+        LogLevel level;
+        LogCategory category;
+        Uint8 cArgs;
+        Uint8 cbStringsUsed;
+        ArgType argTypes[c_maxArgs];
+        Uint64 args[c_maxArgs];
+        char strings[c_cbStrings];      // Nul terminated copies of the string arguments, truncated to fit.  Kept
+                                        //   small, the record size is most of the cost of a call
+    };
+
+    // Levels, categories and a background writer.  Until Start() (and after Stop()) each call is formatted
+    // and written to stdout on the spot.  In between, a call only encodes a LogRecord into the calling thread's ring -
+    // single producer, single consumer, no locks - and the writer thread formats and writes the records
+    // within a couple of milliseconds, so a slow terminal or pipe never holds up the frame.  Queued records are
+    // stamped from a counter the writer refreshes each pass rather than reading the clock per call, which
+    // costs more than the rest of the call; the stamps are as coarse as the writer's pass.  A full ring drops the
+    // record and counts it rather than wait; the writer reports the drops.  Rings are 192KB, created the
+    // first time a thread logs and never freed, like the profiler's.
+    class Log
+    {
+    public:
+        static const Uint32 c_ringRecords = 1024;       // Power of 2
+
+        // Start the writer, to szFileName or stdout (nullptr)
+        static bool Start(const char *szFileName);
+        // Write everything still queued and stop the writer
+        static void Stop();
+
+        static void SetLevel(LogLevel level) { s_minLevel = level; }
+        static bool IsEnabled(LogLevel level) { return level >= s_minLevel; }
+        // Parses "debug", "info", "warning" or "error"
+        static bool ParseLevel(const char *szLevel, LogLevel *pLevel);
+
+        template <class... TArgs> static void Write(LogLevel level, LogCategory category, const char *szFormat, const TArgs&... args)
+        {
+            LogRecord *pRecord = BeginRecord(level, category, szFormat);
+            if (pRecord != nullptr)
+            {
+                Encode(pRecord, args...);
+                CommitRecord(pRecord);
+            }
+        }
+
+        // Records lost to full rings so far, across every thread
+        static Uint64 DroppedCount();
+
+    private:
+        // nullptr when the ring is full.  Otherwise the slot to fill in, which must then be committed
+        static LogRecord* BeginRecord(LogLevel level, LogCategory category, const char *szFormat);
+        static void CommitRecord(LogRecord *pRecord);
+
+        static void Encode(LogRecord *)
+        {
+        }
+
+        template <class TArg, class... TArgs> static void Encode(LogRecord *pRecord, const TArg &arg, const TArgs&... args)
+        {
+            if (pRecord->cArgs < LogRecord::c_maxArgs)
+            {
+                EncodeArg(pRecord, arg);
+                pRecord->cArgs++;
+            }
+            Encode(pRecord, args...);
+        }
+
+        static void SetArg(LogRecord *pRecord, LogRecord::ArgType type, Uint64 value)
+        {
+            pRecord->argTypes[pRecord->cArgs] = type;
+            pRecord->args[pRecord->cArgs] = value;
+        }
+
+        static void EncodeArg(LogRecord *pRecord, int value) { SetArg(pRecord, LogRecord::ArgType::Signed, static_cast<Uint64>(static_cast<Sint64>(value))); }
+        static void EncodeArg(LogRecord *pRecord, long value) { SetArg(pRecord, LogRecord::ArgType::Signed, static_cast<Uint64>(static_cast<Sint64>(value))); }
+        static void EncodeArg(LogRecord *pRecord, long long value) { SetArg(pRecord, LogRecord::ArgType::Signed, static_cast<Uint64>(static_cast<Sint64>(value))); }
+        static void EncodeArg(LogRecord *pRecord, unsigned value) { SetArg(pRecord, LogRecord::ArgType::Unsigned, value); }
+        static void EncodeArg(LogRecord *pRecord, unsigned long value) { SetArg(pRecord, LogRecord::ArgType::Unsigned, value); }
+        static void EncodeArg(LogRecord *pRecord, unsigned long long value) { SetArg(pRecord, LogRecord::ArgType::Unsigned, value); }
+        static void EncodeArg(LogRecord *pRecord, double value);
+        static void EncodeArg(LogRecord *pRecord, const char *szValue);
+        static void EncodeArg(LogRecord *pRecord, const void *pValue) { SetArg(pRecord, LogRecord::ArgType::Pointer, reinterpret_cast<Uint64>(pValue)); }
+
+        static LogLevel s_minLevel;
+    };
+}
+}
@@ -1,6 +1,7 @@
 #pragma once
 #include "constants.h"
 #include "tiledmap.h"
+#include "metrics.h"
 
 namespace XplatGameTutorial
 {
@@ -16,6 +17,7 @@ namespace PacManClone
         Maze(const Uint16 rows, const Uint16 cols, Uint16 cxScreen, Uint16 cyScreen) :
             XplatGameTutorial::PacManClone::TiledMap(rows, cols, cxScreen, cyScreen)
         {
+            SDL_memset(_exitCounts, 0, sizeof(_exitCounts));
         }
 
         virtual ~Maze()
@@ -31,10 +33,16 @@ namespace PacManClone
             return SDL_FALSE;
         }
 
+        SDL_bool IsTilePowerPellet(Uint16 row, Uint16 col)
+        {
+            return (GetTileIndexAt(row, col) == 13) ? SDL_TRUE : SDL_FALSE;
+        }
+
         void EatPellet(Uint16 row, Uint16 col)
         {
             SDL_assert((GetTileIndexAt(row, col) == 16) || (GetTileIndexAt(row, col) == 13));
             SetTileIndexAt(row, col, 49);
+            Metrics::PelletsEaten.Add();
         }
 
         SDL_bool IsTileSolid(Uint16 row, Uint16 col)
@@ -43,7 +51,34 @@ namespace PacManClone
                 row * Constants::MapCols + col] == 1) ? SDL_TRUE : SDL_FALSE;
         }
 
+        // Precomputes the open exits of every interior tile so IsTileIntersection() is a lookup.  Only reads
+        // the collision map, so it can run on a loader thread along with Initialize()
+        void BuildNavigation()
+        {
+            for (Uint16 row = 1; row < (Constants::MapRows - 1); row++)
+            {
+                for (Uint16 col = 1; col < (Constants::MapCols - 1); col++)
+                {
+                    _exitCounts[row * Constants::MapCols + col] = IsTileSolid(row, col) ? 0 : CountExits(row, col);
+                }
+            }
+        }
+
         SDL_bool IsTileIntersection(Uint16 row, Uint16 col)
+        {
+            // Edge tiles (the warp tunnel) aren't in the table, 0 means not computed
+            Uint16 exitsFound = ((row < Constants::MapRows) && (col < Constants::MapCols)) ? _exitCounts[row * Constants::MapCols + col] : 0;
+            if (exitsFound == 0)
+            {
+                exitsFound = CountExits(row, col);
+            }
+
+            // Always should be at least 1 found
+            SDL_assert(exitsFound > 0);
+            return (exitsFound >= 3) ? SDL_TRUE : SDL_FALSE;
+        }
+
+        Uint16 CountExits(Uint16 row, Uint16 col)
         {
             Direction directions[] = { Direction::Up, Direction::Down, Direction::Left, Direction::Right };
 
@@ -60,9 +95,7 @@ namespace PacManClone
                 }
             }
 
-            // Always should be at least 1 found
-            SDL_assert(exitsFound > 0);
-            return (exitsFound >= 3) ? SDL_TRUE : SDL_FALSE;
+            return exitsFound;
         }
 
         void GetNextCell(Uint16 row, Uint16 col, Uint16 &nextRow, Uint16 &nextCol, Direction direction)
@@ -123,6 +156,9 @@ namespace PacManClone
             }
             return result;
         }
+
+    private:
+        Uint8 _exitCounts[Constants::MapRows * Constants::MapCols];   // Open neighbours per tile (capped at 3), 0 - not computed
     };
 }
 }
\ No newline at end of file
@@ -0,0 +1,135 @@
+#pragma once
+#include "SDL.h"
+#include <stdio.h>
+#include <atomic>
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    // One named value in Prometheus text format.  Every metric is a static in the Metrics class, so the
+    // list of them is fixed by the time main() runs and exporting never has to lock anything
+    class Metric
+    {
+    public:
+        Metric(const char *szName, const char *szHelp);
+        virtual ~Metric()
+        {
+        }
+
+        // "# HELP", "# TYPE" and the sample lines
+        virtual void Write(FILE *pFile) const = 0;
+        const Metric* Next() const { return _pNext; }
+        static const Metric* First();
+
+    protected:
+        void WriteHeader(FILE *pFile, const char *szType) const;
+
+        const char *_szName;            // pmc_ prefixed, units in the name as Prometheus expects
+        const char *_szHelp;
+
+    private:
+        Metric *_pNext;
+    };
+
+    // Only goes up.  Add() is one relaxed atomic add, cheap enough for the tick and the sprite code
+    class MetricCounter : public Metric
+    {
+    public:
+        MetricCounter(const char *szName, const char *szHelp) :
+            Metric(szName, szHelp),
+            _value(0)
+        {
+        }
+
+        void Add(Uint64 count = 1) { _value.fetch_add(count, std::memory_order_relaxed); }
+        // For totals kept elsewhere (the allocation counter), copied in before each export
+        void Set(Uint64 value) { _value.store(value, std::memory_order_relaxed); }
+        Uint64 Value() const { return _value.load(std::memory_order_relaxed); }
+        virtual void Write(FILE *pFile) const override;
+
+    private:
+        std::atomic<Uint64> _value;
+    };
+
+    // Goes up and down - live instance counts, or a value sampled at export time
+    class MetricGauge : public Metric
+    {
+    public:
+        MetricGauge(const char *szName, const char *szHelp) :
+            Metric(szName, szHelp),
+            _value(0)
+        {
+        }
+
+        void Add(Sint64 delta) { _value.fetch_add(delta, std::memory_order_relaxed); }
+        void Set(Sint64 value) { _value.store(value, std::memory_order_relaxed); }
+        Sint64 Value() const { return _value.load(std::memory_order_relaxed); }
+        virtual void Write(FILE *pFile) const override;
+
+    private:
+        std::atomic<Sint64> _value;
+    };
+
+    // Durations in microseconds against fixed bucket tops, exported in seconds with cumulative buckets so
+    // histogram_quantile() gives the percentiles.  Record() is a short scan and two relaxed atomic adds.  The
+    // buckets are read one at a time on export, so a scrape can be a frame out between them
+    class MetricHistogram : public Metric
+    {
+    public:
+        static const Uint32 c_maxBuckets = 16;
+
+        // usBucketTops ascending, at most c_maxBuckets of them.  Anything above the last only goes in +Inf
+        MetricHistogram(const char *szName, const char *szHelp, const Uint32 *usBucketTops, Uint32 cBuckets);
+
+        void Record(Uint32 us)
+        {
+            Uint32 index = 0;
+            while ((index < _cBuckets) && (us > _usBucketTops[index]))
+            {
+                index++;
+            }
+            _counts[index].fetch_add(1, std::memory_order_relaxed);
+            _usSum.fetch_add(us, std::memory_order_relaxed);
+        }
+
+        virtual void Write(FILE *pFile) const override;
+
+    private:
+        Uint32 _usBucketTops[c_maxBuckets];
+        Uint32 _cBuckets;
+        std::atomic<Uint64> _counts[c_maxBuckets + 1];     // Not cumulative, the last one is over every top
+        std::atomic<Uint64> _usSum;
+    };
+
+    // Every metric the process keeps, plus the exporter for long running soak and farm processes.  The
+    // exporter thread refreshes the sampled values (tick rate, RSS, allocations) every interval and either
+    // rewrites a file with the whole set - written aside and renamed over, so a reader such as node_exporter's
+    // textfile collector never sees half of one - or, given "unix:<path>", answers each connection to that
+    // Unix domain socket with the current set and closes it (POSIX only).  Nothing listens on the network.
+    class Metrics
+    {
+    public:
+        static MetricCounter Ticks;
+        static MetricGauge TicksPerSecond;
+        static MetricCounter Frames;
+        static MetricCounter FramesMissed;
+        static MetricHistogram FrameTime;
+        static MetricHistogram SimTime;
+        static MetricGauge Sessions;
+        static MetricGauge Sprites;
+        static MetricCounter PelletsEaten;
+        static MetricCounter LevelsCompleted;
+        static MetricCounter Allocations;
+        static MetricGauge ResidentBytes;
+        static MetricCounter LogRecordsDropped;
+
+        // szTarget is a file name or "unix:<path>".  Prints why and returns false if the target can't be used
+        static bool StartExport(const char *szTarget, Uint32 msInterval);
+        // Writes the file one last time and removes the socket
+        static void StopExport();
+        // The whole set as Prometheus text
+        static void WriteText(FILE *pFile);
+    };
+}
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include "gamesession.h"
+#include "bot.h"
+#include "triplebuffer.h"
+#include <thread>
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    // Watches many bot driven sessions at once, laid out as a grid of scaled down mazes in one window.
+    //
+    // The sessions all run on their own thread at the normal tick rate and publish a SessionSnapshot through
+    // a TripleBuffer after every tick, so drawing never touches (or slows) a live session.  Every instance
+    // shares the one tile and sprite texture, each session holding its own handle to them.  The maze for each
+    // instance is cached in a small target texture and only the tiles that changed since it was last drawn are
+    // redrawn, so a frame is one copy per maze plus one per sprite no matter how many tiles there are.
+    class Mosaic
+    {
+    public:
+        Mosaic();
+        ~Mosaic();
+
+        bool Initialize(Uint16 cInstances, SDL_Renderer *pSDLRenderer, const TextureHandle &tilesTexture,
+            const TextureHandle &spriteTexture, SDL_Rect viewRect);
+        void Start();                               // Start the simulation thread
+        void Stop();                                // Stop it and wait for it
+        void Render(SDL_Renderer *pSDLRenderer);    // Draw the latest snapshot of every instance
+
+        Uint32 SimTicks() { return _cSimTicks.load(std::memory_order_relaxed); }
+
+    private:
+        struct Instance
+        {
+            Instance() : pMazeTexture(nullptr), drawnVersion(0)
+            {
+                SDL_memset(drawnTiles, 0, sizeof(drawnTiles));
+            }
+
+            GameSession session;                        // Simulation thread only
+            PelletBot bot;                              // Simulation thread only
+            TripleBuffer<SessionSnapshot> snapshots;    // Sim -> render
+            SDL_Texture *pMazeTexture;                  // Cached scaled maze (render thread only)
+            Uint32 drawnVersion;                        // tilesVersion that pMazeTexture shows
+            Uint16 drawnTiles[Constants::MapRows * Constants::MapCols];
+            SDL_Rect mazeRect;                          // Where the maze goes in the window
+        };
+
+        void SimThread();
+        void UpdateMazeTexture(SDL_Renderer *pSDLRenderer, Instance &instance, const SessionSnapshot &snapshot);
+        void DrawTile(SDL_Renderer *pSDLRenderer, Uint16 tileIndex, Uint16 row, Uint16 col, const SDL_Rect &mazeRect);
+
+        Instance *_pInstances;
+        Uint16 _cInstances;
+        TextureHandle _tilesTexture;                // What Render() draws with
+        TextureHandle _spriteTexture;
+        std::atomic<bool> _fStopping;
+        std::atomic<Uint32> _cSimTicks;             // Ticks completed by every instance
+        std::thread _simThread;
+    };
+}
+}
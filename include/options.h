@@ -0,0 +1,102 @@
+#pragma once
+#include "SDL.h"
+#include "log.h"
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    // Everything that can be changed from the command line or the config file.  The defaults give the normal
+    // windowed game, so running with no arguments behaves exactly as it always has
+    struct GameOptions
+    {
+        GameOptions() :
+            fHeadless(false),
+            pszReplayFile(nullptr),
+            pszRecordFile(nullptr),
+            pszGoldenDir(nullptr),
+            fGoldenWrite(false),
+            goldenEvery(60),
+            goldenTolerance(2),
+            goldenMaxPixels(0),
+            maxTicks(0),
+            pszCaptureFile(nullptr),
+            fCaptureRaw(false),
+            cMosaicInstances(0),
+            pszConfigFile("pmc.cfg"),
+            pszRenderer(nullptr),
+            fVSync(false),
+            pszScaleQuality(nullptr),
+            fBenchRenderers(false),
+            pszAutoRenderer(nullptr),
+            pszPackFile("./grfx/assets.pak"),
+            pszBuildPackFile(nullptr),
+            textureBudget(64 * 1024 * 1024),
+            fAllocCheck(false),
+            fLookaheadCheck(false),
+            fTickAnimation(false),
+            cStressEntities(0),
+            cModGhosts(0),
+            pszTraceFile(nullptr),
+            fFrameOverlay(false),
+            pszFrameCsvFile(nullptr),
+            frameBudget(17000),
+            fPerfCounters(false),
+            pszLogFile(nullptr),
+            logLevel(LogLevel::Info),
+            pszMetricsTarget(nullptr),
+            msMetricsInterval(5000),
+            pszChecksumFile(nullptr),
+            pszChecksumVerifyFile(nullptr),
+            pszChecksumDiffFile(nullptr)
+        {
+        }
+
+        bool fHeadless;                 // Render offscreen with no window, as fast as possible
+        const char *pszReplayFile;      // Drive the input from this recorded replay
+        const char *pszRecordFile;      // Record the input to this replay file on exit
+        const char *pszGoldenDir;       // Directory holding the golden frames (headless only)
+        bool fGoldenWrite;              // Write new golden frames instead of comparing against them
+        Uint32 goldenEvery;             // Render and check every Nth tick
+        Uint8 goldenTolerance;          // Max per channel difference before a pixel counts as different
+        Uint32 goldenMaxPixels;         // Max different pixels before a frame fails
+        Uint32 maxTicks;                // Stop after this many ticks (0 - length of the replay)
+        const char *pszCaptureFile;     // Record every presented frame to this file
+        bool fCaptureRaw;               // Store full frames rather than deltas
+        Uint16 cMosaicInstances;        // Watch this many bot driven games at once (0 - normal game)
+        const char *pszConfigFile;      // Optional "name = value" file read before the command line
+        const char *pszRenderer;        // SDL render driver, "auto" for the benchmarked fastest, nullptr for SDL's choice
+        bool fVSync;                    // Present in sync with the display
+        const char *pszScaleQuality;    // Texture filtering hint "0", "1" or "2"
+        bool fBenchRenderers;           // Benchmark every render driver and exit
+        const char *pszAutoRenderer;    // Fastest driver found by the last benchmark, what "auto" means
+        const char *pszPackFile;        // Baked asset pack to start from, falls back to the images if missing
+        const char *pszBuildPackFile;   // Bake the asset pack to this file and exit
+        Uint32 textureBudget;           // Bytes of unreferenced textures to keep cached (0 - no limit)
+        bool fAllocCheck;               // Check that playing and restarting levels never allocates, then exit
+        bool fLookaheadCheck;           // Check that ghosts deciding several cells ahead never turn back, then exit
+        bool fTickAnimation;            // Sprite frames come from the tick count rather than being stepped each update
+        Uint32 cStressEntities;         // Extra wandering entities to simulate alongside the game (0 - none)
+        Uint32 cModGhosts;              // Extra ghosts with runtime targeting (0 - none)
+        const char *pszTraceFile;       // Write the profiler zones here on exit (PMC_PROFILER builds)
+        bool fFrameOverlay;             // Start with the frame time overlay showing (F3 toggles it)
+        const char *pszFrameCsvFile;    // Append per second frame time aggregates here
+        Uint32 frameBudget;             // Microseconds a frame may take before it counts as missed
+        bool fPerfCounters;             // Read the hardware counters around the update, collision and render phases (Linux)
+        const char *pszLogFile;         // Diagnostics go here rather than stdout
+        LogLevel logLevel;              // Diagnostics below this level are skipped
+        const char *pszMetricsTarget;   // Export Prometheus metrics to this file, or "unix:<path>" for a socket
+        Uint32 msMetricsInterval;       // How often the metrics file is rewritten
+        const char *pszChecksumFile;    // Write the state checksum of every tick here
+        const char *pszChecksumVerifyFile;  // Check every tick's state checksum against this log, stop at the first divergence
+        const char *pszChecksumDiffFile;    // Compare the pszChecksumFile log against this one and exit
+    };
+
+    // Fills in pOptions from the config file and then the command line (which wins), returns false (after
+    // printing usage) on bad input
+    bool ParseOptions(int argc, char* argv[], GameOptions *pOptions);
+
+    // Rewrites one "name = value" line in the config file, keeping the rest of it
+    bool SaveConfigValue(const char *szFileName, const char *szName, const char *szValue);
+}
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include "SDL.h"
+#include <stdio.h>
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    // The parts of a frame the hardware counters are split by
+    enum class PerfPhase : Uint8
+    {
+        Update = 0,         // Player, ghost and entity updates
+        Collision,          // Pellets
+        Render,             // Drawing the session
+        Count
+    };
+
+    // Hardware performance counters (cycles, instructions, L1D read misses, LLC misses, branch misses) read
+    // around each phase, to tell a slowdown from cache misses apart from one from doing more work.  Linux
+    // only, through perf_event_open.  The counters are opened for the calling thread and only count while it
+    // runs in user mode; phases entered on any other thread are ignored.  Anything the kernel or the CPU
+    // won't give us (no PMU in a VM, perf_event_paranoid, other platforms) just leaves that counter - or all
+    // of them - out of the report.  Every phase is a read() of the counter group at each end, so this is an
+    // instrumentation mode, not something to leave on.
+    class PerfCounters
+    {
+    public:
+        // Prints why and returns false if no counter at all could be opened
+        static bool Open();
+        static void Close();
+
+        static void BeginPhase(PerfPhase phase);
+        static void EndPhase(PerfPhase phase);
+
+        // Per phase IPC and misses per 1000 instructions, nothing if the counters were never opened
+        static void PrintReport();
+        // The same totals as a JSON object, written into the profiler's trace.  Writes null without counters
+        static void WriteJson(FILE *pFile);
+    };
+
+    class PerfPhaseScope
+    {
+    public:
+        PerfPhaseScope(PerfPhase phase) :
+            _phase(phase)
+        {
+            PerfCounters::BeginPhase(_phase);
+        }
+
+        ~PerfPhaseScope()
+        {
+            PerfCounters::EndPhase(_phase);
+        }
+
+    private:
+        PerfPhase _phase;
+    };
+}
+}
@@ -15,6 +15,13 @@ namespace PacManClone
         bool Initialize();
         bool Reset(Maze *pMaze);
         void Update(Maze* pMaze, Direction inputDirection);
+        // Going through the tunnel, input is ignored until back in the maze
+        bool IsWarping() { return _mode != Mode::Normal; }
+        void HashState(StateHasher &hasher)
+        {
+            Sprite::HashState(hasher);
+            hasher.Add(static_cast<Uint64>(_mode));
+        }
 
     private:
         // Internal state
@@ -0,0 +1,60 @@
+#pragma once
+#include "SDL.h"
+
+// Timing zones.  PMC_PROFILE_ZONE("name") times from where it is declared to the end of the enclosing scope.
+// They only exist in builds with PMC_PROFILER defined (make PROFILER=1), otherwise the macros are empty and
+// cost nothing.  Names must be string literals, only the pointer is kept
+#ifdef PMC_PROFILER
+#define PMC_PROFILE_CONCAT_INNER(a, b) a##b
+#define PMC_PROFILE_CONCAT(a, b) PMC_PROFILE_CONCAT_INNER(a, b)
+#define PMC_PROFILE_ZONE(szName) XplatGameTutorial::PacManClone::ProfileZone PMC_PROFILE_CONCAT(_profileZone, __LINE__)(szName)
+#define PMC_PROFILE_THREAD(szName) XplatGameTutorial::PacManClone::Profiler::NameThread(szName)
+#else
+#define PMC_PROFILE_ZONE(szName)
+#define PMC_PROFILE_THREAD(szName)
+#endif
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    // Collects the zones.  Each thread records into its own ring (created the first time the thread records
+    // anything), so recording is a couple of stores and never waits on another thread.  Rings hold the most
+    // recent c_ringEvents zones, older ones are overwritten.  A thread may still be finishing a zone when the
+    // game shuts down, so rings are never freed - they go with the process.
+    class Profiler
+    {
+    public:
+        static const Uint32 c_ringEvents = 64 * 1024;   // Power of 2
+
+        // False when built without PMC_PROFILER, there is never anything to write
+        static bool IsCompiledIn();
+        // Label for the calling thread in the trace
+        static void NameThread(const char *szName);
+        static void Record(const char *szName, Uint64 startCounter, Uint64 endCounter);
+        // Every ring as Chrome trace JSON (chrome://tracing or ui.perfetto.dev), with the hardware counter totals
+        // per phase (perfcounters.h) under otherData.  Safe while other threads keep recording, though a ring
+        // that wraps during the write loses the zones overwritten under it (they are left out, not written torn)
+        static bool WriteChromeTrace(const char *szFileName);
+    };
+
+    class ProfileZone
+    {
+    public:
+        ProfileZone(const char *szName) :
+            _szName(szName),
+            _startCounter(SDL_GetPerformanceCounter())
+        {
+        }
+
+        ~ProfileZone()
+        {
+            Profiler::Record(_szName, _startCounter, SDL_GetPerformanceCounter());
+        }
+
+    private:
+        const char *_szName;
+        Uint64 _startCounter;
+    };
+}
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include "options.h"
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    // Times the same fixed input (the --replay file, or the bot, which is just as repeatable) on every render
+    // driver SDL has on this machine, with vsync off, and reports the frame time percentiles for each.  The
+    // fastest driver (lowest p95) is saved to the config file as "renderer-auto", which is what
+    // "--renderer auto" then uses, so each deployment box picks its own backend once.
+    class RendererBenchmark
+    {
+    public:
+        // Benchmark every driver, returns false if none of them could run
+        static bool Run(const GameOptions &options);
+
+        // Replace a "--renderer auto" with the saved fastest driver, benchmarking first if there isn't one
+        static bool ResolveAuto(GameOptions *pOptions);
+
+    private:
+        static const Uint32 c_defaultTicks = 900;      // 15 seconds of game, including the start delay
+        static const Uint32 c_warmupTicks = 30;        // Not counted - texture uploads, driver warmup
+    };
+}
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include "utils.h"
+#include <vector>
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    // Recorded player input, one Direction per simulation tick.  Since the simulation only reads time from
+    // the GameClock, the same input on the same build always produces the same game, so this is all a replay
+    // needs to store.
+    class Replay
+    {
+    public:
+        Replay()
+        {
+        }
+
+        bool Load(const char *szFileName);
+        bool Save(const char *szFileName);
+
+        // Append the input for the next tick
+        void Record(Direction direction) { _inputs.push_back(static_cast<Uint8>(direction)); }
+        // Input for the given tick, once the recording runs out there is no more input
+        Direction InputAt(Uint32 tick)
+        {
+            return (tick < _inputs.size()) ? static_cast<Direction>(_inputs[tick]) : Direction::None;
+        }
+        Uint32 Length() { return static_cast<Uint32>(_inputs.size()); }
+
+    private:
+        static const Uint32 c_magic = 0x52434D50;   // "PMCR"
+        static const Uint32 c_version = 1;
+
+        std::vector<Uint8> _inputs;
+    };
+}
+}
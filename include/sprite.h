@@ -1,7 +1,6 @@
 #pragma once
 #include "utils.h"
-#include "spriteanimation.h"
-#include <map>
+#include "animationlibrary.h"
 
 namespace XplatGameTutorial
 {
@@ -15,30 +14,16 @@ namespace PacManClone
     {
     public:
         // pTextureWrapper - pointer to loaded texture that holds our sprite frames
-        // cxFrame - width of a frame in pixels
-        // cyFrame - height of a frame in pixels
-        // cFramesTotal - total frames to load
-        // cAnimationsTotal - total number of animation sequences needed
-        Sprite(TextureWrapper *pTextureWrapper, Uint16 cxFrame, Uint16 cyFrame, Uint16 cFramesTotal, Uint16 cAnimationsTotal);
+        // pAnimationSet - frames and animations (shared, normally from the AnimationLibrary)
+        Sprite(TextureWrapper *pTextureWrapper, const AnimationSet *pAnimationSet);
         virtual ~Sprite();
 
-        // All frames are the same size once created above (cxFrame * cyFrame)
-        // index - frame index to assign the image to 
-        // xTexture - x coordinate on loaded texture
-        // yTexture - y coordinate on loaded texture
-        bool LoadFrame(Uint16 index, Uint16 xTexture, Uint16 yTexture);
-        // Load a series of frame assumed to be in horizontal order starting at the given index/coord
-        bool LoadFrames(Uint16 indexStart, Uint16 xTextureStart, Uint16 yTextureStart, Uint16 cFramesToLoad);
-
-        //  Saves a series of frames to cycle through in order at a given speed (frame delay per update)
-        // index - animation index to assign the sequence to
-        // animationType - Currently either loop or once
-        // pSequence - pointer to list of frames
-        // cFramesInSequence - total frames in the sequence passed in
-        // animationSpeed - the delay between frame updates
-        void LoadAnimationSequence(Uint16 index, AnimationType animationType, int* pSequence, Uint16 cFramesInSequence, Uint16 animationSpeed);
         // Start the current animation over
         void ResetAnimation();
+        // Work the frame out from the GameClock tick count when drawing instead of counting it along in Update().
+        // Updates cost nothing and frames stay right across ticks the sprite wasn't updated on, but the animation
+        // also keeps running while the game holds the sprite still.  Restarts the current animation.
+        void SetTickAnimation(bool fTickAnimation);
         // Set a new (already loaded) animation sequence as the current
         void SetAnimation(Uint16 index);
         // Set a new velocity
@@ -47,43 +32,42 @@ namespace PacManClone
         void ResetPosition(double x, double y); 
         // This is only needed for sprites that have no animation, the frame will not update
         void SetFrame(Uint16 frameIndex);
-        // Offset from the pixel (X,Y) location of the sprite for the frame (defaults to 0)
-        void SetFrameOffset(int xOffset, int yOffset);
         // If the sprite isn't visible, it won't render
         void SetVisible(SDL_bool visible);
         // Applies current state to the object (velocity, animation, etc)
         void Update();
         // Draw it to the renderer
         void Render(SDL_Renderer *pSDLRenderer);
+        // Source rect on the texture and target rect on the screen for the current frame, returns false if not visible
+        bool GetRenderRects(SDL_Rect &sourceRect, SDL_Rect &targetRect);
         // Some quick accessors
         double X() { return _x; }
         double Y() { return _y; }
         double DX() { return _dx; }
         double DY() { return _dy; }
-        Uint16 Width() { return _cxFrame; }
-        Uint16 Height() { return _cyFrame; }
+        Uint16 Width() { return _pAnimationSet->cxFrame; }
+        Uint16 Height() { return _pAnimationSet->cyFrame; }
 
         Uint16 CurrentAnimation() { return _currentAnimationIndex; }
         Direction CurrentDirection();
         bool IsOutOfView(SDL_Rect &rect);
+        // Position, velocity and animation into the per tick checksum
+        void HashState(StateHasher &hasher);
 
     protected:
+        // Everything shared lives in the AnimationSet, what is left is this instance's own state, small enough
+        // that a sprite fits in a single cache line
         double _x;                              // Position
         double _y;
         double _dx;                             // Velocity
         double _dy;
-        Uint16 _cFramesTotal;                   // Total number of frames to allocate
-        SDL_Rect *_pFrames;                     // Frame rects in the texture
-        Uint16 _cxFrame;                        // Width of a frame
-        Uint16 _cyFrame;                        // Height of a frame
-        int _cxFrameOffset;                     // Offset of left side of frame from position (can be negative)
-        int _cyFrameOffset;                     // Offset of Top side of frame from position
-        Uint16 _currentAnimationIndex;          // Index to the current animation sequence
-        Uint16 _cAnimationsTotal;               // Total number of animation sequences
-        Uint16 _staticFrameIndex;               // Index in non-animated sprite to frame to draw
-        SDL_bool _fVisible;                     // Visibility flag
+        const AnimationSet *_pAnimationSet;     // Not owned, frames and sequences
         TextureWrapper *_pTextureWrapper;       // Not owned by the sprite class
-        SpriteAnimation** _ppSpriteAnimations;  // Is owned and holds the list of animation sequences
+        Uint32 _animationTicks;                 // Updates since the sequence started, or the tick it started on if tick animated
+        Uint8 _currentAnimationIndex;           // Index to the current animation sequence
+        Uint8 _staticFrameIndex;                // Index in non-animated sprite to frame to draw
+        bool _fVisible;                         // Visibility flag
+        bool _fTickAnimation;                   // Frame comes from the GameClock, see SetTickAnimation()
     };
 }
 }
\ No newline at end of file
@@ -0,0 +1,67 @@
+#pragma once
+#include "SDL.h"
+#include <atomic>
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    // Fixed capacity, lock-free queue for exactly one producer thread and one consumer thread.  Neither side
+    // ever blocks: TryPush fails when full and TryPop fails when empty, and the caller decides what that
+    // means (usually drop and count).  Capacity must be a power of 2, one slot is never used so that full
+    // and empty can be told apart without a shared count.
+    template <class T, Uint32 Capacity>
+    class SpscQueue
+    {
+        static_assert((Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of 2");
+
+    public:
+        SpscQueue() : _head(0), _tail(0)
+        {
+        }
+
+        // Producer side
+        bool TryPush(const T &value)
+        {
+            Uint32 tail = _tail.load(std::memory_order_relaxed);
+            Uint32 next = (tail + 1) & c_mask;
+            if (next == _head.load(std::memory_order_acquire))
+            {
+                return false;   // full
+            }
+            _items[tail] = value;
+            _tail.store(next, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer side
+        bool TryPop(T &value)
+        {
+            Uint32 head = _head.load(std::memory_order_relaxed);
+            if (head == _tail.load(std::memory_order_acquire))
+            {
+                return false;   // empty
+            }
+            value = _items[head];
+            _head.store((head + 1) & c_mask, std::memory_order_release);
+            return true;
+        }
+
+        bool IsEmpty()
+        {
+            return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire);
+        }
+
+    private:
+        static const Uint32 c_mask = Capacity - 1;
+
+        // Keep the two indices on separate cache lines so the threads don't fight over them (padding rather
+        // than alignas so queues can be members of heap allocated objects)
+        std::atomic<Uint32> _head;              // Next slot to read, written by the consumer
+        Uint8 _padHead[64];
+        std::atomic<Uint32> _tail;              // Next slot to write, written by the producer
+        Uint8 _padTail[64];
+        T _items[Capacity];
+    };
+}
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "SDL.h"
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    // Hashes simulation state for the per tick checksums.  Values go in whole, 64 bits at a time, doubles by
+    // their bit pattern - two states only hash the same if every bit of them matches, which is what a
+    // determinism check needs.  Not for anything security related.
+    class StateHasher
+    {
+    public:
+        StateHasher() : _hash(0x9E3779B97F4A7C15ull)
+        {
+        }
+
+        void Add(Uint64 value) { _hash = Mix(_hash ^ value); }
+        void AddDouble(double value)
+        {
+            Uint64 bits;
+            SDL_memcpy(&bits, &value, sizeof(bits));
+            Add(bits);
+        }
+        Uint64 Value() const { return _hash; }
+
+        // splitmix64's finalizer, every input bit reaches every output bit
+        static Uint64 Mix(Uint64 value)
+        {
+            value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+            value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+            return value ^ (value >> 31);
+        }
+
+    private:
+        Uint64 _hash;
+    };
+
+    // The parts of the game hashed separately, so a divergence says where it started
+    enum class StateComponent : Uint8
+    {
+        Session = 0,        // State machine, clock, timers, score
+        Player,
+        Ghosts,             // Positions, modes, decisions, pen timers
+        Maze,               // Pellets left
+        Count
+    };
+
+    struct StateChecksum
+    {
+        Uint64 components[static_cast<size_t>(StateComponent::Count)];
+    };
+}
+}
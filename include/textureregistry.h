@@ -0,0 +1,94 @@
+#pragma once
+#include "utils.h"
+#include "assetpack.h"
+#include <stdio.h>
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    class TextureRegistry;
+
+    // Counted reference to a texture in a TextureRegistry.  Copying a handle adds a reference, destroying or
+    // Reset()ing it drops one.  The texture itself stays owned by the registry, Get() is only good for as long
+    // as some handle to it is alive.
+    class TextureHandle
+    {
+    public:
+        TextureHandle() : _pRegistry(nullptr), _slot(0) {}
+        TextureHandle(const TextureHandle &other);
+        TextureHandle& operator=(const TextureHandle &other);
+        ~TextureHandle() { Reset(); }
+
+        TextureWrapper* Get() const;
+        bool IsNull() const { return (_pRegistry == nullptr) || (Get() == nullptr) || Get()->IsNull(); }
+        void Reset();
+
+    private:
+        friend class TextureRegistry;
+        TextureHandle(TextureRegistry *pRegistry, Uint16 slot);
+
+        TextureRegistry *_pRegistry;
+        Uint16 _slot;
+    };
+
+    // Owns every texture loaded for one renderer, keyed by asset id (see Constants::TextureAssets) so the same
+    // image is only ever loaded once no matter how many sessions or levels ask for it.  Textures nobody holds a
+    // handle to stay cached until the total goes over the byte budget, then the least recently released are
+    // destroyed first.  Textures still in use are never evicted, so the budget can be exceeded while they are.
+    class TextureRegistry
+    {
+    public:
+        static const Uint16 c_maxTextures = 32;
+
+        TextureRegistry();
+        ~TextureRegistry();
+
+        // pAssetPack is optional, textures are loaded from it in preference to decoding the image files.
+        // budgetBytes of 0 means never evict
+        void Initialize(SDL_Renderer *pSDLRenderer, AssetPack *pAssetPack, size_t budgetBytes);
+        // Destroys everything, all handles must have been released first
+        void Clear();
+
+        // Returns a handle to the texture, loading it if it isn't resident.  The handle IsNull() on failure
+        TextureHandle Acquire(const char *szAssetId);
+        // Hands a texture that was loaded some other way (e.g. decoded on a loader thread) to the registry.
+        // If the id is already resident pTexture is deleted and the resident one is returned
+        TextureHandle Adopt(const char *szAssetId, TextureWrapper *pTexture);
+
+        size_t ResidentBytes() { return _cbResident; }
+        Uint16 ResidentCount();
+        void PrintReport();
+
+    private:
+        friend class TextureHandle;
+
+        struct Entry
+        {
+            char szId[32];
+            TextureWrapper *pTexture;   // nullptr when the slot is free
+            Uint32 cRefs;
+            Uint32 lastReleased;        // _releaseCounter when cRefs last hit 0, the LRU order for eviction
+            size_t cbTexture;
+        };
+
+        int FindSlot(const char *szAssetId);
+        TextureWrapper* Load(const char *szAssetId);
+        TextureHandle Insert(const char *szAssetId, TextureWrapper *pTexture);
+        void AddRef(Uint16 slot) { _entries[slot].cRefs++; }
+        void Release(Uint16 slot);
+        void Evict(Uint16 slot);
+        void Trim(size_t cbIncoming);
+
+        SDL_Renderer *_pSDLRenderer;
+        AssetPack *_pAssetPack;
+        size_t _cbBudget;
+        size_t _cbResident;
+        Uint32 _releaseCounter;
+        Uint32 _cLoads;
+        Uint32 _cHits;
+        Uint32 _cEvictions;
+        Entry _entries[c_maxTextures];
+    };
+}
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include "SDL_image.h"
+#include "statehash.h"
 
 namespace XplatGameTutorial
 {
@@ -24,7 +25,8 @@ namespace PacManClone
             _cRows(rows),
             _tileSize(0),
             _pTileTexture(nullptr),
-            _cTilesOnTexture(0)
+            _cTilesOnTexture(0),
+            _tilesHash(0)
         {
             SDL_memset(&_textureRect, 0, sizeof(SDL_Rect));
         }
@@ -37,8 +39,12 @@ namespace PacManClone
         }
 
         // Initialize our map with the texture and map data
-        bool Initialize(SDL_Rect textureRect, SDL_Rect tileRect, SDL_Texture *pTexture, Uint16 *pMapIndices, Uint16 countOfIndicies);
+        bool Initialize(SDL_Rect textureRect, SDL_Rect tileRect, SDL_Texture *pTexture, const Uint16 *pMapIndices, Uint16 countOfIndicies);
         
+        // Copy the indices back in over the current ones, the map must already be initialized
+        void RestoreTiles(const Uint16 *pMapIndices);
+        bool IsInitialized() { return _pMapIndicies != nullptr; }
+
         // Draw to the renderer at the current offset, etc
         virtual void Render(SDL_Renderer *pSDLRenderer);
         
@@ -48,10 +54,21 @@ namespace PacManClone
         bool GetTileRowCol(SDL_Point &point, Uint16 &row, Uint16 &col);
         // Return the outer bounds of the map
         SDL_Rect GetMapBounds();
+        // Read only view of the tile indices, row major
+        const Uint16* TileIndices() { return _pMapIndicies; }
+        // Hash of every tile index, kept up to date as tiles change rather than worked out on each call
+        Uint64 TilesHash() { return _tilesHash; }
         
     protected:
         Uint16 GetTileIndexAt(Uint16 row, Uint16 col) { return _pMapIndicies[(row * _cCols) + col]; }
-        void SetTileIndexAt(Uint16 row, Uint16 col, Uint16 index) { _pMapIndicies[(row * _cCols) + col] = index; }
+        void SetTileIndexAt(Uint16 row, Uint16 col, Uint16 index)
+        {
+            Uint32 cell = (row * _cCols) + col;
+            _tilesHash ^= TileHash(cell, _pMapIndicies[cell]) ^ TileHash(cell, index);
+            _pMapIndicies[cell] = index;
+        }
+        // Each tile's part of _tilesHash, XORed in and out as the tile changes
+        static Uint64 TileHash(Uint32 cell, Uint16 index) { return StateHasher::Mix((static_cast<Uint64>(cell) << 16) | index); }
         
         Uint16 _cxScreen;           // Total screen (window) width in pixels
         Uint16 _cyScreen;           // Total screen height
@@ -67,6 +84,7 @@ namespace PacManClone
         SDL_Rect _textureRect;      // Size of the texture
         SDL_Texture *_pTileTexture; // Texture that holds the tiles (must be evenly divisible by tile size)
         Uint16 _cTilesOnTexture;    // Total number of tiles on the texture
+        Uint64 _tilesHash;          // XOR of TileHash() over every tile
     };
 }
 }
\ No newline at end of file
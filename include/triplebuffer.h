@@ -0,0 +1,56 @@
+#pragma once
+#include "SDL.h"
+#include <atomic>
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    // Lock-free hand off of "the latest value" from one writer thread to one reader thread.  There are three
+    // copies of T: the writer owns one, the reader owns one and the third sits in the middle.  Publishing swaps
+    // the writer's copy into the middle, reading swaps the middle out if it is newer.  Neither side ever waits
+    // and the reader never sees a half written value, it may just skip values if it reads slower than the
+    // writer publishes.  Each copy keeps whatever was last written to it, so writers can update in place
+    // when they know what that copy last held.
+    template <class T>
+    class TripleBuffer
+    {
+    public:
+        TripleBuffer() : _writeIndex(0), _middle(1), _readIndex(2)
+        {
+        }
+
+        // Writer side
+        T* WriteBuffer() { return &_buffers[_writeIndex]; }
+        void Publish()
+        {
+            Uint32 previous = _middle.exchange(_writeIndex | c_fresh, std::memory_order_acq_rel);
+            _writeIndex = previous & c_indexMask;
+        }
+
+        // Reader side, returns the newest published value (or the initial one if nothing is published yet)
+        const T* Read()
+        {
+            if ((_middle.load(std::memory_order_relaxed) & c_fresh) != 0)
+            {
+                Uint32 previous = _middle.exchange(_readIndex, std::memory_order_acq_rel);
+                _readIndex = previous & c_indexMask;
+            }
+            return &_buffers[_readIndex];
+        }
+
+    private:
+        static const Uint32 c_indexMask = 0x3;
+        static const Uint32 c_fresh = 0x4;     // Set when the middle copy has not been read yet
+
+        // Padding keeps the writer's and reader's indices off each other's cache lines.  It is padding rather
+        // than alignas so these can live in arrays made with plain new
+        T _buffers[3];
+        Uint32 _writeIndex;                 // Writer only
+        Uint8 _padWriter[64];
+        std::atomic<Uint32> _middle;
+        Uint8 _padMiddle[64];
+        Uint32 _readIndex;                  // Reader only
+    };
+}
+}
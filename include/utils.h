@@ -1,11 +1,27 @@
 #pragma once
 #include "SDL.h"
 #include <stdio.h>
+#include "statehash.h"
 
 namespace XplatGameTutorial
 {
 namespace PacManClone
 {
+    // Simulation clock.  Game logic reads time from here instead of calling SDL_GetTicks() directly, and the
+    // owning GameSession advances it by a fixed step every tick.  That makes a run a pure function of its inputs,
+    // which is what lets a replay reproduce a session exactly (and lets headless runs go faster than real time).
+    // It is thread local so independent sessions can be stepped on different threads.
+    class GameClock
+    {
+    public:
+        static Uint32 Now() { return s_ticks; }
+        static Uint32 TickCount() { return s_tickCount; }
+        static void Set(Uint32 ticks, Uint32 tickCount) { s_ticks = ticks; s_tickCount = tickCount; }
+    private:
+        static thread_local Uint32 s_ticks;
+        static thread_local Uint32 s_tickCount;     // Fixed steps taken, what tick derived animations run from
+    };
+
     // Oneshot timer for state transistions
     class StateTimer
     {
@@ -18,14 +34,20 @@ namespace PacManClone
         {
             SDL_assert(!_fStarted);
             SDL_assert(_startTicks == 0);
-            _startTicks = SDL_GetTicks();
+            _startTicks = GameClock::Now();
             _targetTicks = waitTicks;
             _fStarted = true;
         }
 
         void Reset() { _fStarted = false; _startTicks = 0; }
         bool IsStarted() { return _fStarted; }
-        bool IsDone() { return IsStarted() && (SDL_GetTicks() - _startTicks > _targetTicks); }
+        bool IsDone() { return IsStarted() && (GameClock::Now() - _startTicks > _targetTicks); }
+        void HashState(StateHasher &hasher)
+        {
+            hasher.Add(_startTicks);
+            hasher.Add(_targetTicks);
+            hasher.Add(_fStarted ? 1 : 0);
+        }
     private:
         Uint32 _startTicks;
         Uint32 _targetTicks;
@@ -57,8 +79,23 @@ namespace PacManClone
     // Load a texture from disk with optional transparency
     SDL_Texture* LoadTexture(const char *szFileName, SDL_Renderer *pSDLRenderer, SDL_Color *pSdlTransparencyColorKey);
     
+    // How the windowed renderer is created
+    struct RendererSettings
+    {
+        const char *pszDriver;          // SDL render driver name (e.g. "software", "opengl"), nullptr or "" for SDL's choice
+        bool fVSync;                    // Sync presents to the display refresh
+        const char *pszScaleQuality;    // SDL_HINT_RENDER_SCALE_QUALITY ("0"/"1"/"2"), nullptr leaves SDL's default
+    };
+
+    // Finds the index SDL_CreateRenderer() wants for a render driver name, -1 (any) for nullptr or ""
+    bool FindRenderDriver(const char *pszDriver, int *pIndex);
+
     // Sets up our SDL environment and Window
-    bool InitializeSDL(SDL_Window **ppSDLWindow, SDL_Renderer **ppSDLRenderer);
+    bool InitializeSDL(SDL_Window **ppSDLWindow, SDL_Renderer **ppSDLRenderer, const RendererSettings &settings);
+
+    // Sets up SDL without a visible window - everything is drawn by the software renderer into an RGBA
+    // surface that stays in memory, so frames can be inspected directly
+    bool InitializeOffscreenSDL(SDL_Surface **ppSDLSurface, SDL_Renderer **ppSDLRenderer);
 
     // Small wrapper for the SDL_Texture object.  It will cache some basic info (like size)
     // and free it upon destruction
@@ -74,6 +111,8 @@ namespace PacManClone
         }
 
         TextureWrapper(const char *szFileName, size_t cchFileName, SDL_Renderer *pSDLRenderer, SDL_Color *pSdlTransparencyColorKey);
+        TextureWrapper(const char *szFileName, size_t cchFileName, SDL_Renderer *pSDLRenderer, SDL_Surface *pSDLSurface);
+        TextureWrapper(const char *szName, size_t cchName, SDL_Texture *pTexture);     // Takes ownership of pTexture
         
         ~TextureWrapper();
 
@@ -84,6 +123,8 @@ namespace PacManClone
         SDL_Texture* Ptr() { return _pTexture; }
   
     private:
+        void Attach(const char *szFileName, size_t cchFileName, SDL_Texture *pTexture);
+
         SDL_Texture *_pTexture;
         int _cxTexture;
         int _cyTexture;
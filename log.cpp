@@ -0,0 +1,411 @@
+#include "include/log.h"
+#include <atomic>
+#include <thread>
+
+using namespace XplatGameTutorial::PacManClone;
+
+LogLevel Log::s_minLevel = LogLevel::Info;
+
+namespace
+{
+    const char c_levelLetters[static_cast<size_t>(LogLevel::Count)] = { 'D', 'I', 'W', 'E' };
+    const char * const c_szCategoryNames[static_cast<size_t>(LogCategory::Count)] = { "general", "harness", "render", "assets", "sim" };
+    const Uint32 c_msWriterIdle = 2;            // Writer sleep when every ring is empty
+
+    // One per logging thread.  The thread owning it is the only one to move tail, the writer the only one
+    // to move head.  Each side keeps to its own cache line, the logging thread only looks at head again
+    // when its last copy says the ring is full
+    struct LogRing
+    {
+        LogRecord records[Log::c_ringRecords];
+        std::atomic<Uint32> head;               // Next record to write out
+        Uint64 cDroppedReported;                // Writer only
+        Uint8 padding[64];
+        std::atomic<Uint32> tail;               // Next record to fill
+        std::atomic<bool> fClaimed;             // Logging thread is between BeginRecord and CommitRecord
+        Uint32 cachedHead;                      // Logging thread's last look at head
+        std::atomic<Uint64> cDropped;
+        Uint32 threadId;
+        LogRing *pNext;
+    };
+
+    std::atomic<LogRing*> s_pRings(nullptr);
+    std::atomic<Uint32> s_nextThreadId(1);
+    thread_local LogRing *t_pRing = nullptr;
+    thread_local LogRecord t_directRecord;      // While there is no writer, records are formatted straight from here
+
+    std::atomic<bool> s_fRunning(false);
+    std::atomic<bool> s_fStopping(false);
+    std::thread s_writerThread;
+    FILE *s_pFile = nullptr;
+    Uint64 s_startCounter = 0;
+    std::atomic<Uint64> s_coarseCounter(0);     // Writer refreshed clock the queued records are stamped with
+
+    LogRing* ThreadRing()
+    {
+        if (t_pRing == nullptr)
+        {
+            LogRing *pRing = new LogRing;
+            pRing->head.store(0, std::memory_order_relaxed);
+            pRing->tail.store(0, std::memory_order_relaxed);
+            pRing->fClaimed.store(false, std::memory_order_relaxed);
+            pRing->cachedHead = 0;
+            pRing->cDropped.store(0, std::memory_order_relaxed);
+            pRing->cDroppedReported = 0;
+            pRing->threadId = s_nextThreadId.fetch_add(1, std::memory_order_relaxed);
+            pRing->pNext = s_pRings.load(std::memory_order_relaxed);
+            while (!s_pRings.compare_exchange_weak(pRing->pNext, pRing, std::memory_order_release, std::memory_order_relaxed))
+            {
+            }
+            t_pRing = pRing;
+        }
+        return t_pRing;
+    }
+
+    // Turns the record back into text.  Each conversion in the format is handed to snprintf on its own with
+    // the stored value, length modifiers are replaced since every value was widened to 64 bits
+    void FormatRecord(const LogRecord &record, char *szText, size_t cchText)
+    {
+        size_t cchUsed = 0;
+        Uint8 iArg = 0;
+        const char *pch = record.szFormat;
+        while ((*pch != '\0') && (cchUsed + 1 < cchText))
+        {
+            if (*pch != '%')
+            {
+                szText[cchUsed++] = *pch++;
+                continue;
+            }
+
+            if (pch[1] == '%')
+            {
+                szText[cchUsed++] = '%';
+                pch += 2;
+                continue;
+            }
+
+            // Flags, width and precision are kept, length modifiers dropped
+            char szSpec[32] = "%";
+            size_t cchSpec = 1;
+            const char *pchSpec = pch + 1;
+            while ((*pchSpec != '\0') && (SDL_strchr("-+ #0123456789.", *pchSpec) != nullptr) && (cchSpec < 24))
+            {
+                szSpec[cchSpec++] = *pchSpec++;
+            }
+            while ((*pchSpec != '\0') && (SDL_strchr("hljztL", *pchSpec) != nullptr))
+            {
+                pchSpec++;
+            }
+            char conversion = *pchSpec;
+            if (conversion == '\0')
+            {
+                break;
+            }
+            pch = pchSpec + 1;
+
+            char *pchOut = szText + cchUsed;
+            size_t cchLeft = cchText - cchUsed;
+            int cchWritten = 0;
+            if (iArg >= record.cArgs)
+            {
+                cchWritten = SDL_snprintf(pchOut, cchLeft, "<missing>");
+            }
+            else
+            {
+                LogRecord::ArgType type = record.argTypes[iArg];
+                Uint64 value = record.args[iArg];
+                iArg++;
+                switch (conversion)
+                {
+                case 'd':
+                case 'i':
+                case 'u':
+                case 'x':
+                case 'X':
+                case 'o':
+                    szSpec[cchSpec++] = 'l';
+                    szSpec[cchSpec++] = 'l';
+                    szSpec[cchSpec++] = conversion;
+                    szSpec[cchSpec] = '\0';
+                    if (type == LogRecord::ArgType::Double)
+                    {
+                        double number;
+                        SDL_memcpy(&number, &value, sizeof(number));
+                        value = static_cast<Uint64>(static_cast<Sint64>(number));
+                    }
+                    cchWritten = SDL_snprintf(pchOut, cchLeft, szSpec, value);
+                    break;
+                case 'c':
+                    // No length modifier for a character, it goes through varargs as an int
+                    szSpec[cchSpec++] = 'c';
+                    szSpec[cchSpec] = '\0';
+                    cchWritten = SDL_snprintf(pchOut, cchLeft, szSpec, static_cast<int>(value));
+                    break;
+                case 'f':
+                case 'F':
+                case 'e':
+                case 'E':
+                case 'g':
+                case 'G':
+                {
+                    szSpec[cchSpec++] = conversion;
+                    szSpec[cchSpec] = '\0';
+                    double number = 0.0;
+                    if (type == LogRecord::ArgType::Double)
+                    {
+                        SDL_memcpy(&number, &value, sizeof(number));
+                    }
+                    else
+                    {
+                        number = (type == LogRecord::ArgType::Signed) ? static_cast<double>(static_cast<Sint64>(value)) : static_cast<double>(value);
+                    }
+                    cchWritten = SDL_snprintf(pchOut, cchLeft, szSpec, number);
+                    break;
+                }
+                case 's':
+                    szSpec[cchSpec++] = 's';
+                    szSpec[cchSpec] = '\0';
+                    cchWritten = SDL_snprintf(pchOut, cchLeft, szSpec,
+                        (type == LogRecord::ArgType::String) ? &record.strings[value] : "<not a string>");
+                    break;
+                case 'p':
+                    cchWritten = SDL_snprintf(pchOut, cchLeft, "0x%llx", static_cast<unsigned long long>(value));
+                    break;
+                default:
+                    cchWritten = SDL_snprintf(pchOut, cchLeft, "<%%%c?>", conversion);
+                    break;
+                }
+            }
+            cchUsed += (cchWritten < 0) ? 0 : SDL_min(static_cast<size_t>(cchWritten), cchLeft - 1);
+        }
+        szText[cchUsed] = '\0';
+    }
+
+    // "[   12.345] W render: text"
+    void WriteRecord(FILE *pFile, const LogRecord &record, Uint32 threadId)
+    {
+        char szText[512];
+        FormatRecord(record, szText, SDL_arraysize(szText));
+        double seconds = ((s_startCounter != 0) && (record.counter > s_startCounter)) ?
+            static_cast<double>(record.counter - s_startCounter) / SDL_GetPerformanceFrequency() : 0.0;
+        fprintf(pFile, "[%10.3f] %c %s/%u: %s", seconds, c_levelLetters[static_cast<size_t>(record.level)],
+            c_szCategoryNames[static_cast<size_t>(record.category)], threadId, szText);
+
+        // Most formats end in a newline already, those that don't get one
+        size_t cchText = SDL_strlen(szText);
+        if ((cchText == 0) || (szText[cchText - 1] != '\n'))
+        {
+            fputc('\n', pFile);
+        }
+    }
+
+    // Everything queued so far, returns false if there was nothing
+    bool Drain()
+    {
+        bool fWrote = false;
+        for (LogRing *pRing = s_pRings.load(std::memory_order_acquire); pRing != nullptr; pRing = pRing->pNext)
+        {
+            Uint32 head = pRing->head.load(std::memory_order_relaxed);
+            Uint32 tail = pRing->tail.load(std::memory_order_acquire);
+            for (; head != tail; head++)
+            {
+                WriteRecord(s_pFile, pRing->records[head & (Log::c_ringRecords - 1)], pRing->threadId);
+                fWrote = true;
+            }
+            pRing->head.store(head, std::memory_order_release);
+
+            Uint64 cDropped = pRing->cDropped.load(std::memory_order_relaxed);
+            if (cDropped != pRing->cDroppedReported)
+            {
+                fprintf(s_pFile, "[log] %llu records dropped on thread %u, ring full\n",
+                    static_cast<unsigned long long>(cDropped - pRing->cDroppedReported), pRing->threadId);
+                pRing->cDroppedReported = cDropped;
+                fWrote = true;
+            }
+        }
+
+        if (fWrote)
+        {
+            fflush(s_pFile);
+        }
+        return fWrote;
+    }
+}
+
+bool Log::Start(const char *szFileName)
+{
+    SDL_assert(!s_fRunning);
+    s_pFile = stdout;
+    if (szFileName != nullptr)
+    {
+        s_pFile = fopen(szFileName, "w");
+        if (s_pFile == nullptr)
+        {
+            s_pFile = stdout;
+            PMC_LOG_ERROR(LogCategory::General, "Failed to open the log file %s", szFileName);
+            return false;
+        }
+    }
+
+    // Anything printed directly before this point is flushed first so the output stays in order
+    fflush(stdout);
+    s_startCounter = SDL_GetPerformanceCounter();
+    s_coarseCounter.store(s_startCounter, std::memory_order_relaxed);
+    s_fStopping = false;
+    s_writerThread = std::thread([]()
+    {
+        while (!s_fStopping.load(std::memory_order_acquire))
+        {
+            s_coarseCounter.store(SDL_GetPerformanceCounter(), std::memory_order_relaxed);
+            if (!Drain())
+            {
+                SDL_Delay(c_msWriterIdle);
+            }
+        }
+    });
+    s_fRunning = true;
+    return true;
+}
+
+void Log::Stop()
+{
+    if (!s_fRunning)
+    {
+        return;
+    }
+
+    // From here on calls format directly again.  Calls that already claimed a ring slot are let finish
+    // committing, then the writer and the final drain write out everything that was queued
+    s_fRunning = false;
+    for (LogRing *pRing = s_pRings.load(); pRing != nullptr; pRing = pRing->pNext)
+    {
+        while (pRing->fClaimed.load())
+        {
+            std::this_thread::yield();
+        }
+    }
+    s_fStopping = true;
+    s_writerThread.join();
+    Drain();
+    if (s_pFile != stdout)
+    {
+        fclose(s_pFile);
+    }
+    s_pFile = nullptr;
+}
+
+bool Log::ParseLevel(const char *szLevel, LogLevel *pLevel)
+{
+    const char * const szNames[] = { "debug", "info", "warning", "error" };
+    for (size_t index = 0; index < SDL_arraysize(szNames); index++)
+    {
+        if (SDL_strcmp(szLevel, szNames[index]) == 0)
+        {
+            *pLevel = static_cast<LogLevel>(index);
+            return true;
+        }
+    }
+    return false;
+}
+
+Uint64 Log::DroppedCount()
+{
+    Uint64 cDropped = 0;
+    for (LogRing *pRing = s_pRings.load(std::memory_order_acquire); pRing != nullptr; pRing = pRing->pNext)
+    {
+        cDropped += pRing->cDropped.load(std::memory_order_relaxed);
+    }
+    return cDropped;
+}
+
+LogRecord* Log::BeginRecord(LogLevel level, LogCategory category, const char *szFormat)
+{
+    LogRecord *pRecord = &t_directRecord;
+    Uint64 counter = 0;
+    LogRing *pRing = s_fRunning.load(std::memory_order_acquire) ? ThreadRing() : nullptr;
+    if (pRing != nullptr)
+    {
+        // Claim the ring before looking at s_fRunning again, Stop() waits for claimed rings before its last
+        // drain.  Both sides are sequentially consistent, so either this sees the stop or Stop() sees the claim
+        pRing->fClaimed.store(true);
+        if (!s_fRunning.load())
+        {
+            pRing->fClaimed.store(false, std::memory_order_release);
+            pRing = nullptr;
+        }
+    }
+
+    if (pRing != nullptr)
+    {
+        counter = s_coarseCounter.load(std::memory_order_relaxed);
+        Uint32 tail = pRing->tail.load(std::memory_order_relaxed);
+        if (tail - pRing->cachedHead == c_ringRecords)
+        {
+            pRing->cachedHead = pRing->head.load(std::memory_order_acquire);
+            if (tail - pRing->cachedHead == c_ringRecords)
+            {
+                pRing->cDropped.fetch_add(1, std::memory_order_relaxed);
+                pRing->fClaimed.store(false, std::memory_order_release);
+                return nullptr;
+            }
+        }
+        pRecord = &pRing->records[tail & (c_ringRecords - 1)];
+    }
+    else
+    {
+        // Written straight away, which costs far more than reading the clock
+        counter = SDL_GetPerformanceCounter();
+    }
+
+    pRecord->szFormat = szFormat;
+    pRecord->counter = counter;
+    pRecord->level = level;
+    pRecord->category = category;
+    pRecord->cArgs = 0;
+    pRecord->cbStringsUsed = 0;
+    return pRecord;
+}
+
+void Log::CommitRecord(LogRecord *pRecord)
+{
+    if (pRecord == &t_directRecord)
+    {
+        // Always stdout, a call racing Stop() must not write to the log file as it is closed
+        WriteRecord(stdout, *pRecord, 0);
+        return;
+    }
+
+    LogRing *pRing = t_pRing;
+    pRing->tail.store(pRing->tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    pRing->fClaimed.store(false, std::memory_order_release);
+}
+
+void Log::EncodeArg(LogRecord *pRecord, double value)
+{
+    Uint64 bits;
+    SDL_memcpy(&bits, &value, sizeof(bits));
+    SetArg(pRecord, LogRecord::ArgType::Double, bits);
+}
+
+// Copied into the record, so the caller's buffer (SDL_GetError() for one) can change straight after
+void Log::EncodeArg(LogRecord *pRecord, const char *szValue)
+{
+    if (szValue == nullptr)
+    {
+        szValue = "(null)";
+    }
+
+    size_t cbLeft = LogRecord::c_cbStrings - pRecord->cbStringsUsed;
+    if (cbLeft == 0)
+    {
+        // Out of room, it points at the last terminator
+        SetArg(pRecord, LogRecord::ArgType::String, LogRecord::c_cbStrings - 1);
+        return;
+    }
+
+    size_t cchCopy = SDL_min(SDL_strlen(szValue), cbLeft - 1);
+    SDL_memcpy(&pRecord->strings[pRecord->cbStringsUsed], szValue, cchCopy);
+    pRecord->strings[pRecord->cbStringsUsed + cchCopy] = '\0';
+    SetArg(pRecord, LogRecord::ArgType::String, pRecord->cbStringsUsed);
+    pRecord->cbStringsUsed = static_cast<Uint8>(pRecord->cbStringsUsed + cchCopy + 1);
+}
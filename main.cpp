@@ -1,16 +1,56 @@
 // main.cpp : Defines the entry point for the console application.
 //
 #include "include/gameharness.h"
+#include "include/rendererbench.h"
+#include "include/assetpack.h"
+#include "include/log.h"
+#include "include/checksumlog.h"
 
 using namespace XplatGameTutorial::PacManClone;
 
-int main(int /*argc*/, char* /*argv*/[])
+int main(int argc, char* argv[])
 {
-    GameHarness gameHarness;
+    GameOptions options;
+    if (!ParseOptions(argc, argv, &options))
+    {
+        return 1;
+    }
+
+    // Stopped by the exit handler so every return below still gets the queued diagnostics written out
+    Log::SetLevel(options.logLevel);
+    Log::Start(options.pszLogFile);
+    atexit(Log::Stop);
+
+    if (options.pszBuildPackFile != nullptr)
+    {
+        return AssetPack::Build(options.pszBuildPackFile) ? 0 : 1;
+    }
+
+    if (options.pszChecksumDiffFile != nullptr)
+    {
+        if (options.pszChecksumFile == nullptr)
+        {
+            printf("--checksum-diff needs the log to compare given with --checksums\n");
+            return 1;
+        }
+        return ChecksumLog::Compare(options.pszChecksumDiffFile, options.pszChecksumFile) ? 0 : 1;
+    }
+
+    if (options.fBenchRenderers)
+    {
+        return RendererBenchmark::Run(options) ? 0 : 1;
+    }
 
-    if (gameHarness.Initialize() == SDL_TRUE)
+    if (!RendererBenchmark::ResolveAuto(&options))
+    {
+        return 1;
+    }
+
+    int exitCode = 1;
+    GameHarness gameHarness;
+    if (gameHarness.Initialize(options) == SDL_TRUE)
     { 
-        gameHarness.Run();
+        exitCode = gameHarness.Run();
     }
-    return 0;
+    return exitCode;
 }
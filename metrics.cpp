@@ -0,0 +1,353 @@
+#include "include/metrics.h"
+#include "include/alloccounter.h"
+#include "include/log.h"
+#include <thread>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+#endif
+
+using namespace XplatGameTutorial::PacManClone;
+
+namespace
+{
+    const Uint32 c_msStopCheck = 50;            // How quickly the exporter notices StopExport()
+
+    // Frame times around the 16ms slot in detail, then coarser out to the long stalls
+    const Uint32 c_usFrameBuckets[] = { 2000, 4000, 8000, 12000, 16000, 17000, 20000, 25000, 33000, 50000, 100000, 250000 };
+    // A tick is normally well under a millisecond
+    const Uint32 c_usSimBuckets[] = { 50, 100, 200, 500, 1000, 2000, 4000, 8000, 16000 };
+
+    Metric *s_pFirstMetric = nullptr;
+    Metric *s_pLastMetric = nullptr;
+
+    std::atomic<bool> s_fExporting(false);
+    std::thread s_exportThread;
+    const char *s_szFileName = nullptr;         // File target, or
+    const char *s_szSocketPath = nullptr;       //   socket target
+    int s_listenFd = -1;
+    Uint32 s_msInterval = 0;
+    Uint64 s_lastTicks = 0;
+    Uint64 s_lastRefreshCounter = 0;
+
+    void WriteSeconds(FILE *pFile, Uint64 us)
+    {
+        fprintf(pFile, "%llu.%06llu", static_cast<unsigned long long>(us / 1000000), static_cast<unsigned long long>(us % 1000000));
+    }
+
+    Sint64 CurrentResidentBytes()
+    {
+#ifdef __linux__
+        // Pages: total size, then resident
+        FILE *pFile = fopen("/proc/self/statm", "r");
+        if (pFile != nullptr)
+        {
+            unsigned long long cPagesTotal = 0;
+            unsigned long long cPagesResident = 0;
+            int cRead = fscanf(pFile, "%llu %llu", &cPagesTotal, &cPagesResident);
+            fclose(pFile);
+            if (cRead == 2)
+            {
+                return static_cast<Sint64>(cPagesResident * sysconf(_SC_PAGESIZE));
+            }
+        }
+#endif
+        return 0;
+    }
+
+    // The values nothing updates as it happens
+    void RefreshSampled()
+    {
+        Uint64 counter = SDL_GetPerformanceCounter();
+        Uint64 cTicks = Metrics::Ticks.Value();
+        if (s_lastRefreshCounter != 0)
+        {
+            double seconds = static_cast<double>(counter - s_lastRefreshCounter) / SDL_GetPerformanceFrequency();
+            Metrics::TicksPerSecond.Set((seconds > 0.0) ? static_cast<Sint64>((cTicks - s_lastTicks) / seconds + 0.5) : 0);
+        }
+        s_lastRefreshCounter = counter;
+        s_lastTicks = cTicks;
+
+        Metrics::Allocations.Set(AllocationCounter::ProcessCount());
+        Metrics::ResidentBytes.Set(CurrentResidentBytes());
+        Metrics::LogRecordsDropped.Set(Log::DroppedCount());
+    }
+
+    void WriteFile()
+    {
+        char szTempName[512];
+        SDL_snprintf(szTempName, SDL_arraysize(szTempName), "%s.tmp", s_szFileName);
+        FILE *pFile = fopen(szTempName, "w");
+        if (pFile == nullptr)
+        {
+            PMC_LOG_WARNING(LogCategory::Harness, "Couldn't write the metrics to %s", szTempName);
+            return;
+        }
+        Metrics::WriteText(pFile);
+        fclose(pFile);
+
+        // Replacing with rename() is atomic on POSIX, Windows won't rename over an existing file
+#ifdef _WIN32
+        remove(s_szFileName);
+#endif
+        if (rename(szTempName, s_szFileName) != 0)
+        {
+            PMC_LOG_WARNING(LogCategory::Harness, "Couldn't replace the metrics file %s", s_szFileName);
+        }
+    }
+
+#ifndef _WIN32
+    bool OpenSocket(const char *szPath)
+    {
+        sockaddr_un address;
+        SDL_memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (SDL_strlen(szPath) >= sizeof(address.sun_path))
+        {
+            PMC_LOG_ERROR(LogCategory::Harness, "Metrics socket path %s is too long", szPath);
+            return false;
+        }
+        SDL_strlcpy(address.sun_path, szPath, sizeof(address.sun_path));
+
+        // A socket file left by an earlier run that didn't get to clean up
+        unlink(szPath);
+        s_listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if ((s_listenFd == -1) || (bind(s_listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) ||
+            (listen(s_listenFd, 4) != 0))
+        {
+            PMC_LOG_ERROR(LogCategory::Harness, "Couldn't listen on the metrics socket %s: %s", szPath, strerror(errno));
+            if (s_listenFd != -1)
+            {
+                close(s_listenFd);
+                s_listenFd = -1;
+            }
+            return false;
+        }
+        return true;
+    }
+
+    // Waits up to msWait for a connection and answers it
+    void ServeSocket(Uint32 msWait)
+    {
+        pollfd listenPoll = { s_listenFd, POLLIN, 0 };
+        if ((poll(&listenPoll, 1, static_cast<int>(msWait)) <= 0) || ((listenPoll.revents & POLLIN) == 0))
+        {
+            return;
+        }
+
+        int connectionFd = accept(s_listenFd, nullptr, nullptr);
+        if (connectionFd == -1)
+        {
+            return;
+        }
+
+        // Formatted first and sent with MSG_NOSIGNAL, a client that hangs up early mustn't SIGPIPE the game
+        char *pText = nullptr;
+        size_t cbText = 0;
+        FILE *pStream = open_memstream(&pText, &cbText);
+        if (pStream != nullptr)
+        {
+            Metrics::WriteText(pStream);
+            fclose(pStream);
+            for (size_t cbSent = 0; cbSent < cbText;)
+            {
+                ssize_t cbChunk = send(connectionFd, pText + cbSent, cbText - cbSent, MSG_NOSIGNAL);
+                if (cbChunk <= 0)
+                {
+                    break;
+                }
+                cbSent += static_cast<size_t>(cbChunk);
+            }
+            free(pText);
+        }
+        close(connectionFd);
+    }
+#endif
+
+    void ExportLoop()
+    {
+        Uint32 msSinceRefresh = s_msInterval;
+        while (s_fExporting.load(std::memory_order_acquire))
+        {
+            if (msSinceRefresh >= s_msInterval)
+            {
+                RefreshSampled();
+                if (s_szFileName != nullptr)
+                {
+                    WriteFile();
+                }
+                msSinceRefresh = 0;
+            }
+
+            // Between refreshes the socket is answered straight away, a file only has to wait
+            Uint32 startTicks = SDL_GetTicks();
+#ifndef _WIN32
+            if (s_listenFd != -1)
+            {
+                ServeSocket(c_msStopCheck);
+            }
+            else
+#endif
+            {
+                SDL_Delay(c_msStopCheck);
+            }
+            msSinceRefresh += SDL_GetTicks() - startTicks;
+        }
+    }
+}
+
+MetricCounter Metrics::Ticks("pmc_ticks_total", "Simulation ticks run, across every session");
+MetricGauge Metrics::TicksPerSecond("pmc_ticks_per_second", "Simulation ticks per second over the last export interval");
+MetricCounter Metrics::Frames("pmc_frames_total", "Frames presented by the windowed loops");
+MetricCounter Metrics::FramesMissed("pmc_frames_missed_total", "Frames that took longer than the frame budget");
+MetricHistogram Metrics::FrameTime("pmc_frame_time_seconds", "Whole frame time including the wait for the next slot",
+    c_usFrameBuckets, SDL_arraysize(c_usFrameBuckets));
+MetricHistogram Metrics::SimTime("pmc_sim_time_seconds", "Time spent ticking the session per frame",
+    c_usSimBuckets, SDL_arraysize(c_usSimBuckets));
+MetricGauge Metrics::Sessions("pmc_sessions", "Game sessions alive");
+MetricGauge Metrics::Sprites("pmc_sprites", "Sprites alive");
+MetricCounter Metrics::PelletsEaten("pmc_pellets_eaten_total", "Pellets eaten, across every session");
+MetricCounter Metrics::LevelsCompleted("pmc_levels_completed_total", "Levels cleared, across every session");
+MetricCounter Metrics::Allocations("pmc_allocations_total", "Heap allocations through operator new");
+MetricGauge Metrics::ResidentBytes("pmc_resident_memory_bytes", "Resident set size (Linux)");
+MetricCounter Metrics::LogRecordsDropped("pmc_log_records_dropped_total", "Log records lost to full rings");
+
+Metric::Metric(const char *szName, const char *szHelp) :
+    _szName(szName),
+    _szHelp(szHelp),
+    _pNext(nullptr)
+{
+    // Constructed during static initialization only, so no lock; the list keeps definition order
+    if (s_pLastMetric == nullptr)
+    {
+        s_pFirstMetric = this;
+    }
+    else
+    {
+        s_pLastMetric->_pNext = this;
+    }
+    s_pLastMetric = this;
+}
+
+const Metric* Metric::First()
+{
+    return s_pFirstMetric;
+}
+
+void Metric::WriteHeader(FILE *pFile, const char *szType) const
+{
+    fprintf(pFile, "# HELP %s %s\n# TYPE %s %s\n", _szName, _szHelp, _szName, szType);
+}
+
+void MetricCounter::Write(FILE *pFile) const
+{
+    WriteHeader(pFile, "counter");
+    fprintf(pFile, "%s %llu\n", _szName, static_cast<unsigned long long>(Value()));
+}
+
+void MetricGauge::Write(FILE *pFile) const
+{
+    WriteHeader(pFile, "gauge");
+    fprintf(pFile, "%s %lld\n", _szName, static_cast<long long>(Value()));
+}
+
+MetricHistogram::MetricHistogram(const char *szName, const char *szHelp, const Uint32 *usBucketTops, Uint32 cBuckets) :
+    Metric(szName, szHelp),
+    _cBuckets(SDL_min(cBuckets, c_maxBuckets)),
+    _usSum(0)
+{
+    SDL_memcpy(_usBucketTops, usBucketTops, _cBuckets * sizeof(Uint32));
+    for (Uint32 index = 0; index <= c_maxBuckets; index++)
+    {
+        _counts[index].store(0, std::memory_order_relaxed);
+    }
+}
+
+void MetricHistogram::Write(FILE *pFile) const
+{
+    WriteHeader(pFile, "histogram");
+    Uint64 cCumulative = 0;
+    for (Uint32 index = 0; index < _cBuckets; index++)
+    {
+        cCumulative += _counts[index].load(std::memory_order_relaxed);
+        fprintf(pFile, "%s_bucket{le=\"", _szName);
+        WriteSeconds(pFile, _usBucketTops[index]);
+        fprintf(pFile, "\"} %llu\n", static_cast<unsigned long long>(cCumulative));
+    }
+    cCumulative += _counts[_cBuckets].load(std::memory_order_relaxed);
+    fprintf(pFile, "%s_bucket{le=\"+Inf\"} %llu\n%s_sum ", _szName, static_cast<unsigned long long>(cCumulative), _szName);
+    WriteSeconds(pFile, _usSum.load(std::memory_order_relaxed));
+    fprintf(pFile, "\n%s_count %llu\n", _szName, static_cast<unsigned long long>(cCumulative));
+}
+
+bool Metrics::StartExport(const char *szTarget, Uint32 msInterval)
+{
+    SDL_assert(!s_fExporting);
+    s_msInterval = msInterval;
+    s_szFileName = nullptr;
+    s_szSocketPath = nullptr;
+    if (SDL_strncmp(szTarget, "unix:", 5) == 0)
+    {
+#ifdef _WIN32
+        PMC_LOG_ERROR(LogCategory::Harness, "Metrics sockets need a POSIX system, use a file instead");
+        return false;
+#else
+        s_szSocketPath = szTarget + 5;
+        if (!OpenSocket(s_szSocketPath))
+        {
+            return false;
+        }
+#endif
+    }
+    else
+    {
+        s_szFileName = szTarget;
+    }
+
+    s_fExporting = true;
+    s_exportThread = std::thread(ExportLoop);
+    PMC_LOG_INFO(LogCategory::Harness, "Exporting metrics to %s every %ums", szTarget, msInterval);
+    return true;
+}
+
+void Metrics::StopExport()
+{
+    if (!s_fExporting)
+    {
+        return;
+    }
+
+    s_fExporting = false;
+    s_exportThread.join();
+    if (s_szFileName != nullptr)
+    {
+        // The final totals, for a run that ended between refreshes
+        RefreshSampled();
+        WriteFile();
+    }
+#ifndef _WIN32
+    if (s_listenFd != -1)
+    {
+        close(s_listenFd);
+        s_listenFd = -1;
+        unlink(s_szSocketPath);
+    }
+#endif
+}
+
+void Metrics::WriteText(FILE *pFile)
+{
+    for (const Metric *pMetric = Metric::First(); pMetric != nullptr; pMetric = pMetric->Next())
+    {
+        pMetric->Write(pFile);
+    }
+}
@@ -0,0 +1,208 @@
+#include "include/mosaic.h"
+#include "include/log.h"
+#include "include/profiler.h"
+
+using namespace XplatGameTutorial::PacManClone;
+
+Mosaic::Mosaic() :
+    _pInstances(nullptr),
+    _cInstances(0),
+    _fStopping(false),
+    _cSimTicks(0)
+{
+}
+
+Mosaic::~Mosaic()
+{
+    Stop();
+    for (Uint16 index = 0; index < _cInstances; index++)
+    {
+        if (_pInstances[index].pMazeTexture != nullptr)
+        {
+            SDL_DestroyTexture(_pInstances[index].pMazeTexture);
+        }
+    }
+    delete[] _pInstances;
+}
+
+// Lay the instances out in a near square grid and fit a maze (keeping its aspect) into each cell
+bool Mosaic::Initialize(Uint16 cInstances, SDL_Renderer *pSDLRenderer, const TextureHandle &tilesTexture,
+    const TextureHandle &spriteTexture, SDL_Rect viewRect)
+{
+    SDL_assert(cInstances > 0);
+    _cInstances = cInstances;
+    _tilesTexture = tilesTexture;
+    _spriteTexture = spriteTexture;
+    _pInstances = new Instance[cInstances];
+
+    int cGridCols = static_cast<int>(SDL_ceil(SDL_sqrt(static_cast<double>(cInstances))));
+    int cGridRows = (cInstances + cGridCols - 1) / cGridCols;
+    int cxCell = viewRect.w / cGridCols;
+    int cyCell = viewRect.h / cGridRows;
+    const int cxMap = Constants::MapCols * Constants::TileWidth;
+    const int cyMap = Constants::MapRows * Constants::TileHeight;
+    double scale = SDL_min(static_cast<double>(cxCell - 2) / cxMap, static_cast<double>(cyCell - 2) / cyMap);
+    int cxMaze = SDL_max(1, static_cast<int>(cxMap * scale));
+    int cyMaze = SDL_max(1, static_cast<int>(cyMap * scale));
+
+    bool fTargetsAvailable = true;
+    for (Uint16 index = 0; index < cInstances; index++)
+    {
+        Instance &instance = _pInstances[index];
+        instance.session.Initialize(tilesTexture, spriteTexture, nullptr);
+        // Nobody replays a mosaic, so the sprites can take the cheaper tick derived animation
+        instance.session.SetTickAnimation(true);
+        instance.mazeRect = { viewRect.x + (index % cGridCols) * cxCell + (cxCell - cxMaze) / 2,
+                              viewRect.y + (index / cGridCols) * cyCell + (cyCell - cyMaze) / 2,
+                              cxMaze, cyMaze };
+
+        if (fTargetsAvailable)
+        {
+            instance.pMazeTexture = SDL_CreateTexture(pSDLRenderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, cxMaze, cyMaze);
+            if (instance.pMazeTexture == nullptr)
+            {
+                // Still works, just draws every tile every frame
+                PMC_LOG_ERROR(LogCategory::Render, "SDL_CreateTexture() failed for the maze cache, error = %s", SDL_GetError());
+                fTargetsAvailable = false;
+            }
+        }
+    }
+
+    PMC_LOG_INFO(LogCategory::Harness, "Mosaic of %u games, %dx%d grid, mazes %dx%d", cInstances, cGridCols, cGridRows, cxMaze, cyMaze);
+    return true;
+}
+
+void Mosaic::Start()
+{
+    _fStopping = false;
+    _simThread = std::thread(&Mosaic::SimThread, this);
+}
+
+void Mosaic::Stop()
+{
+    if (_simThread.joinable())
+    {
+        _fStopping = true;
+        _simThread.join();
+    }
+}
+
+// Runs every instance at the normal tick rate.  If we fall behind we don't try to catch up, the
+// sessions just run slower than real time - they are all driven by their own GameClock anyway
+void Mosaic::SimThread()
+{
+    const Uint64 frequency = SDL_GetPerformanceFrequency();
+    const Uint64 countsPerTick = (frequency * Constants::TicksPerFrame) / 1000;
+    Uint64 nextTick = SDL_GetPerformanceCounter();
+    PMC_PROFILE_THREAD("mosaic sim");
+
+    while (!_fStopping)
+    {
+        {
+            PMC_PROFILE_ZONE("Mosaic::SimTick");
+            for (Uint16 index = 0; index < _cInstances; index++)
+            {
+                Instance &instance = _pInstances[index];
+                instance.session.Tick(instance.bot.ChooseInput(instance.session));
+                instance.session.Snapshot(instance.snapshots.WriteBuffer());
+                instance.snapshots.Publish();
+            }
+        }
+        _cSimTicks.fetch_add(1, std::memory_order_relaxed);
+
+        nextTick += countsPerTick;
+        Uint64 now = SDL_GetPerformanceCounter();
+        if (now < nextTick)
+        {
+            SDL_Delay(static_cast<Uint32>(((nextTick - now) * 1000) / frequency));
+        }
+        else
+        {
+            nextTick = now;
+        }
+    }
+}
+
+void Mosaic::Render(SDL_Renderer *pSDLRenderer)
+{
+    SDL_SetTextureColorMod(_tilesTexture.Get()->Ptr(), 255, 255, 255);
+    for (Uint16 index = 0; index < _cInstances; index++)
+    {
+        Instance &instance = _pInstances[index];
+        const SessionSnapshot *pSnapshot = instance.snapshots.Read();
+        if (pSnapshot->tilesVersion == 0)
+        {
+            // Nothing loaded yet
+            continue;
+        }
+
+        SDL_RenderSetClipRect(pSDLRenderer, &instance.mazeRect);
+        if (instance.pMazeTexture != nullptr)
+        {
+            UpdateMazeTexture(pSDLRenderer, instance, *pSnapshot);
+            SDL_SetTextureColorMod(instance.pMazeTexture, 255, 255, pSnapshot->fFlashTiles ? 100 : 255);
+            SDL_RenderCopy(pSDLRenderer, instance.pMazeTexture, nullptr, &instance.mazeRect);
+        }
+        else
+        {
+            for (Uint16 cell = 0; cell < Constants::MapRows * Constants::MapCols; cell++)
+            {
+                DrawTile(pSDLRenderer, pSnapshot->tiles[cell], cell / Constants::MapCols, cell % Constants::MapCols, instance.mazeRect);
+            }
+        }
+
+        // Sprites are stored in screen space for a full size maze, so scale them into this maze
+        const SDL_Rect &mapBounds = pSnapshot->mapBounds;
+        for (Uint16 sprite = 0; sprite < pSnapshot->cSprites; sprite++)
+        {
+            const SDL_Rect &target = pSnapshot->spriteTarget[sprite];
+            SDL_Rect scaled = {
+                instance.mazeRect.x + ((target.x - mapBounds.x) * instance.mazeRect.w) / mapBounds.w,
+                instance.mazeRect.y + ((target.y - mapBounds.y) * instance.mazeRect.h) / mapBounds.h,
+                SDL_max(1, (target.w * instance.mazeRect.w) / mapBounds.w),
+                SDL_max(1, (target.h * instance.mazeRect.h) / mapBounds.h) };
+            SDL_RenderCopy(pSDLRenderer, _spriteTexture.Get()->Ptr(), &pSnapshot->spriteSource[sprite], &scaled);
+        }
+    }
+    SDL_RenderSetClipRect(pSDLRenderer, nullptr);
+}
+
+// Bring the cached maze up to date with the snapshot, only drawing the tiles that differ
+void Mosaic::UpdateMazeTexture(SDL_Renderer *pSDLRenderer, Instance &instance, const SessionSnapshot &snapshot)
+{
+    if (instance.drawnVersion == snapshot.tilesVersion)
+    {
+        return;
+    }
+
+    bool fRedrawAll = (instance.drawnVersion == 0);
+    SDL_Rect textureRect = { 0, 0, instance.mazeRect.w, instance.mazeRect.h };
+    SDL_SetRenderTarget(pSDLRenderer, instance.pMazeTexture);
+    SDL_RenderSetClipRect(pSDLRenderer, nullptr);
+    for (Uint16 cell = 0; cell < Constants::MapRows * Constants::MapCols; cell++)
+    {
+        if (fRedrawAll || (instance.drawnTiles[cell] != snapshot.tiles[cell]))
+        {
+            DrawTile(pSDLRenderer, snapshot.tiles[cell], cell / Constants::MapCols, cell % Constants::MapCols, textureRect);
+            instance.drawnTiles[cell] = snapshot.tiles[cell];
+        }
+    }
+    SDL_SetRenderTarget(pSDLRenderer, nullptr);
+    SDL_RenderSetClipRect(pSDLRenderer, &instance.mazeRect);
+    instance.drawnVersion = snapshot.tilesVersion;
+}
+
+// Tiles are scaled by splitting the rect evenly so neighbours always meet without gaps
+void Mosaic::DrawTile(SDL_Renderer *pSDLRenderer, Uint16 tileIndex, Uint16 row, Uint16 col, const SDL_Rect &mazeRect)
+{
+    const Uint16 tilesPerRow = Constants::TileTextureWidth / Constants::TileWidth;
+    SDL_Rect sourceRect = { (tileIndex % tilesPerRow) * Constants::TileWidth, (tileIndex / tilesPerRow) * Constants::TileHeight,
+        Constants::TileWidth, Constants::TileHeight };
+
+    int x0 = mazeRect.x + (col * mazeRect.w) / Constants::MapCols;
+    int x1 = mazeRect.x + ((col + 1) * mazeRect.w) / Constants::MapCols;
+    int y0 = mazeRect.y + (row * mazeRect.h) / Constants::MapRows;
+    int y1 = mazeRect.y + ((row + 1) * mazeRect.h) / Constants::MapRows;
+    SDL_Rect targetRect = { x0, y0, x1 - x0, y1 - y0 };
+    SDL_RenderCopy(pSDLRenderer, _tilesTexture.Get()->Ptr(), &sourceRect, &targetRect);
+}
@@ -0,0 +1,369 @@
+#include "include/options.h"
+#include "include/constants.h"
+#include "include/log.h"
+#include <stdio.h>
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    // Each option is a name (without the leading "--" used on the command line), an optional value and a
+    // function that applies it.  The config file uses the same names so anything can be set either way.
+    struct OptionSpec
+    {
+        const char *szName;
+        const char *szValueName;        // nullptr for flags
+        const char *szHelp;
+        bool (*pfnApply)(GameOptions *pOptions, const char *szValue);
+    };
+
+    static Uint32 ToUint(const char *szValue, Uint32 minimum, Uint32 maximum)
+    {
+        int value = SDL_atoi(szValue);
+        return static_cast<Uint32>(SDL_min(static_cast<int>(maximum), SDL_max(static_cast<int>(minimum), value)));
+    }
+
+    static const OptionSpec c_options[] =
+    {
+        { "replay", "file", "play back recorded input instead of reading the keyboard",
+            [](GameOptions *p, const char *v) { p->pszReplayFile = v; return true; } },
+        { "record", "file", "record the input to <file> on exit",
+            [](GameOptions *p, const char *v) { p->pszRecordFile = v; return true; } },
+        { "headless", nullptr, "no window, render offscreen with the software renderer",
+            [](GameOptions *p, const char *) { p->fHeadless = true; return true; } },
+        { "ticks", "n", "stop after n ticks (headless, defaults to the replay length)",
+            [](GameOptions *p, const char *v) { p->maxTicks = ToUint(v, 0, 0x7FFFFFFF); return true; } },
+        { "golden", "dir", "compare rendered frames against <dir>/tick_NNNNNN.png",
+            [](GameOptions *p, const char *v) { p->pszGoldenDir = v; return true; } },
+        { "golden-write", nullptr, "write the golden frames instead of comparing them",
+            [](GameOptions *p, const char *) { p->fGoldenWrite = true; return true; } },
+        { "golden-every", "n", "check every nth tick (default 60)",
+            [](GameOptions *p, const char *v) { p->goldenEvery = ToUint(v, 1, 0x7FFFFFFF); return true; } },
+        { "golden-tolerance", "n", "per channel difference allowed (default 2)",
+            [](GameOptions *p, const char *v) { p->goldenTolerance = static_cast<Uint8>(ToUint(v, 0, 255)); return true; } },
+        { "golden-max-pixels", "n", "pixels allowed over tolerance per frame (default 0)",
+            [](GameOptions *p, const char *v) { p->goldenMaxPixels = ToUint(v, 0, 0x7FFFFFFF); return true; } },
+        { "capture", "file", "record every rendered frame to <file>",
+            [](GameOptions *p, const char *v) { p->pszCaptureFile = v; return true; } },
+        { "capture-raw", nullptr, "store full frames instead of deltas",
+            [](GameOptions *p, const char *) { p->fCaptureRaw = true; return true; } },
+        { "mosaic", "n", "watch n bot driven games at once in a grid",
+            [](GameOptions *p, const char *v) { p->cMosaicInstances = static_cast<Uint16>(ToUint(v, 1, 1024)); return true; } },
+        { "config", "file", "read options from <file> first (default pmc.cfg)",
+            [](GameOptions *p, const char *v) { p->pszConfigFile = v; return true; } },
+        { "renderer", "name", "SDL render driver (software, opengl, opengles2, direct3d...) or auto",
+            [](GameOptions *p, const char *v) { p->pszRenderer = v; return true; } },
+        { "vsync", nullptr, "sync presents to the display refresh",
+            [](GameOptions *p, const char *) { p->fVSync = true; return true; } },
+        { "no-vsync", nullptr, "don't sync presents (default)",
+            [](GameOptions *p, const char *) { p->fVSync = false; return true; } },
+        { "scale-quality", "q", "texture filtering: nearest, linear or best",
+            [](GameOptions *p, const char *v)
+            {
+                const char *qualities[] = { "nearest", "linear", "best" };
+                const char *hints[] = { "0", "1", "2" };
+                for (size_t index = 0; index < SDL_arraysize(qualities); index++)
+                {
+                    if ((SDL_strcmp(v, qualities[index]) == 0) || (SDL_strcmp(v, hints[index]) == 0))
+                    {
+                        p->pszScaleQuality = hints[index];
+                        return true;
+                    }
+                }
+                printf("Unknown scale quality %s\n", v);
+                return false;
+            } },
+        { "bench-renderers", nullptr, "time the fixed replay (or bot) on every render driver, save the fastest and exit",
+            [](GameOptions *p, const char *) { p->fBenchRenderers = true; return true; } },
+        { "renderer-auto", "name", "driver --renderer auto uses (written by --bench-renderers)",
+            [](GameOptions *p, const char *v) { p->pszAutoRenderer = v; return true; } },
+        { "pack", "file", "asset pack to load (default ./grfx/assets.pak), \"none\" to always decode the images",
+            [](GameOptions *p, const char *v) { p->pszPackFile = (SDL_strcmp(v, "none") == 0) ? nullptr : v; return true; } },
+        { "build-pack", "file", "decode the images and bake them with the level into an asset pack, then exit",
+            [](GameOptions *p, const char *v) { p->pszBuildPackFile = v; return true; } },
+        { "texture-budget", "bytes", "texture memory to stay under by evicting unused textures (default 64MB, 0 - no limit)",
+            [](GameOptions *p, const char *v) { p->textureBudget = ToUint(v, 0, 0x7FFFFFFF); return true; } },
+        { "alloc-check", nullptr, "bot plays through repeated level restarts, fails if ticking or restarting allocates",
+            [](GameOptions *p, const char *) { p->fAllocCheck = true; return true; } },
+        { "lookahead-check", nullptr, "bot plays with the ghosts deciding 2 and 3 cells ahead, fails if a decision turns back",
+            [](GameOptions *p, const char *) { p->fLookaheadCheck = true; return true; } },
+        { "tick-animation", nullptr, "work sprite frames out from the tick count when drawing (changes the frames goldens see)",
+            [](GameOptions *p, const char *) { p->fTickAnimation = true; return true; } },
+        { "stress-entities", "n", "add n wandering entities to the maze to load the simulation (changes the frames goldens see)",
+            [](GameOptions *p, const char *v) { p->cStressEntities = ToUint(v, 0, 1000000); return true; } },
+        { "mod-ghosts", "n", "add up to 4 ghosts whose targeting is picked at runtime, as a mod would (changes the frames goldens see)",
+            [](GameOptions *p, const char *v) { p->cModGhosts = ToUint(v, 0, Constants::MaxModGhosts); return true; } },
+        { "trace", "file", "write the profiler zones as Chrome trace JSON on exit, F9 writes one any time (PROFILER=1 builds)",
+            [](GameOptions *p, const char *v) { p->pszTraceFile = v; return true; } },
+        { "frame-overlay", nullptr, "show frame time percentiles and a sparkline (F3 toggles)",
+            [](GameOptions *p, const char *) { p->fFrameOverlay = true; return true; } },
+        { "frame-csv", "file", "write per second frame time percentiles to <file>",
+            [](GameOptions *p, const char *v) { p->pszFrameCsvFile = v; return true; } },
+        { "frame-budget", "us", "frame time over which a frame counts as missed (default 17000 - the 16ms slot plus SDL_Delay slack)",
+            [](GameOptions *p, const char *v) { p->frameBudget = ToUint(v, 1000, 1000000); return true; } },
+        { "perf-counters", nullptr, "report IPC and cache/branch misses per frame phase on exit and in the trace (Linux)",
+            [](GameOptions *p, const char *) { p->fPerfCounters = true; return true; } },
+        { "log-file", "file", "write diagnostics to <file> instead of stdout",
+            [](GameOptions *p, const char *v) { p->pszLogFile = v; return true; } },
+        { "log-level", "level", "least severe diagnostics shown: debug, info (default), warning or error",
+            [](GameOptions *p, const char *v)
+            {
+                if (!Log::ParseLevel(v, &p->logLevel))
+                {
+                    printf("Unknown log level %s\n", v);
+                    return false;
+                }
+                return true;
+            } },
+        { "metrics", "target", "export Prometheus metrics, rewriting file <target> or answering on unix:<path>",
+            [](GameOptions *p, const char *v) { p->pszMetricsTarget = v; return true; } },
+        { "metrics-interval", "ms", "how often the metrics are refreshed and the file rewritten (default 5000)",
+            [](GameOptions *p, const char *v) { p->msMetricsInterval = ToUint(v, 100, 3600000); return true; } },
+        { "checksums", "file", "write a state checksum per tick to <file>, to check later runs of the same input against",
+            [](GameOptions *p, const char *v) { p->pszChecksumFile = v; return true; } },
+        { "checksum-verify", "file", "check each tick's state against the checksums in <file>, stop at the first divergence",
+            [](GameOptions *p, const char *v) { p->pszChecksumVerifyFile = v; return true; } },
+        { "checksum-diff", "file", "report where the --checksums log first diverges from <file> and exit",
+            [](GameOptions *p, const char *v) { p->pszChecksumDiffFile = v; return true; } },
+    };
+
+    static void PrintUsage(const char *szExe)
+    {
+        printf("usage: %s [options]\n", szExe);
+        for (size_t index = 0; index < SDL_arraysize(c_options); index++)
+        {
+            char szUsage[48];
+            SDL_snprintf(szUsage, SDL_arraysize(szUsage), "--%s%s%s%s", c_options[index].szName,
+                (c_options[index].szValueName != nullptr) ? " <" : "",
+                (c_options[index].szValueName != nullptr) ? c_options[index].szValueName : "",
+                (c_options[index].szValueName != nullptr) ? ">" : "");
+            printf("  %-30s %s\n", szUsage, c_options[index].szHelp);
+        }
+    }
+
+    static const OptionSpec* FindOption(const char *szName)
+    {
+        for (size_t index = 0; index < SDL_arraysize(c_options); index++)
+        {
+            if (SDL_strcmp(c_options[index].szName, szName) == 0)
+            {
+                return &c_options[index];
+            }
+        }
+        printf("Unknown option %s\n", szName);
+        return nullptr;
+    }
+
+    // The config file is read into here and split up in place, it lives for the whole process so
+    // options can point straight at the values
+    static char *s_pszConfig = nullptr;
+
+    // The whole of szFileName in a new[] buffer sized from the file, nul terminated.  nullptr if the file
+    // can't be opened (*pfMissing set) or can't be read in full (reported)
+    static char* ReadTextFile(const char *szFileName, bool *pfMissing)
+    {
+        *pfMissing = false;
+        FILE *pFile = fopen(szFileName, "rb");
+        if (pFile == nullptr)
+        {
+            *pfMissing = true;
+            return nullptr;
+        }
+
+        char *pszText = nullptr;
+        long cbFile = (fseek(pFile, 0, SEEK_END) == 0) ? ftell(pFile) : -1;
+        if ((cbFile >= 0) && (fseek(pFile, 0, SEEK_SET) == 0))
+        {
+            pszText = new char[cbFile + 1];
+            if (fread(pszText, 1, cbFile, pFile) != static_cast<size_t>(cbFile))
+            {
+                delete[] pszText;
+                pszText = nullptr;
+            }
+            else
+            {
+                pszText[cbFile] = '\0';
+            }
+        }
+        fclose(pFile);
+
+        if (pszText == nullptr)
+        {
+            PMC_LOG_ERROR(LogCategory::General, "Unable to read config file %s", szFileName);
+        }
+        return pszText;
+    }
+
+    static char* Trim(char *sz)
+    {
+        while ((*sz == ' ') || (*sz == '\t'))
+        {
+            sz++;
+        }
+        char *pEnd = sz + SDL_strlen(sz);
+        while ((pEnd > sz) && ((pEnd[-1] == ' ') || (pEnd[-1] == '\t') || (pEnd[-1] == '\r')))
+        {
+            *--pEnd = '\0';
+        }
+        return sz;
+    }
+
+    // Lines are "name = value", "name" for flags, or "# comment".  A missing file is fine
+    static bool LoadConfigFile(const char *szFileName, GameOptions *pOptions)
+    {
+        bool fMissing = false;
+        s_pszConfig = ReadTextFile(szFileName, &fMissing);
+        if (s_pszConfig == nullptr)
+        {
+            return fMissing;
+        }
+
+        bool fResult = true;
+        char *pLine = s_pszConfig;
+        while ((pLine != nullptr) && fResult)
+        {
+            char *pNext = SDL_strchr(pLine, '\n');
+            if (pNext != nullptr)
+            {
+                *pNext++ = '\0';
+            }
+
+            char *szValue = SDL_strchr(pLine, '=');
+            if (szValue != nullptr)
+            {
+                *szValue++ = '\0';
+                szValue = Trim(szValue);
+            }
+            char *szName = Trim(pLine);
+
+            if ((szName[0] != '\0') && (szName[0] != '#'))
+            {
+                const OptionSpec *pSpec = FindOption(szName);
+                if ((pSpec == nullptr) || ((pSpec->szValueName != nullptr) && (szValue == nullptr)))
+                {
+                    printf("%s: bad line for %s\n", szFileName, szName);
+                    fResult = false;
+                }
+                else
+                {
+                    fResult = pSpec->pfnApply(pOptions, szValue);
+                }
+            }
+            pLine = pNext;
+        }
+        return fResult;
+    }
+
+    bool ParseOptions(int argc, char* argv[], GameOptions *pOptions)
+    {
+        // The config file comes first so the command line can override it, which means finding --config early
+        for (int index = 1; index + 1 < argc; index++)
+        {
+            if (SDL_strcmp(argv[index], "--config") == 0)
+            {
+                pOptions->pszConfigFile = argv[index + 1];
+            }
+        }
+        bool fResult = LoadConfigFile(pOptions->pszConfigFile, pOptions);
+
+        for (int index = 1; (index < argc) && fResult; index++)
+        {
+            const char *szArg = argv[index];
+            const OptionSpec *pSpec = nullptr;
+            if (SDL_strncmp(szArg, "--", 2) != 0)
+            {
+                printf("Unknown option %s\n", szArg);
+                fResult = false;
+            }
+            else if ((pSpec = FindOption(szArg + 2)) == nullptr)
+            {
+                fResult = false;
+            }
+            else if (pSpec->szValueName == nullptr)
+            {
+                fResult = pSpec->pfnApply(pOptions, nullptr);
+            }
+            else if (index + 1 >= argc)
+            {
+                printf("%s needs a value\n", szArg);
+                fResult = false;
+            }
+            else
+            {
+                fResult = pSpec->pfnApply(pOptions, argv[++index]);
+            }
+        }
+
+        if (fResult && (pOptions->pszGoldenDir != nullptr) && !pOptions->fHeadless)
+        {
+            printf("--golden requires --headless\n");
+            fResult = false;
+        }
+
+        // With nothing to say how long to run, a headless run would do nothing and pass
+        if (fResult && pOptions->fHeadless && !pOptions->fAllocCheck && !pOptions->fLookaheadCheck &&
+            (pOptions->pszReplayFile == nullptr) &&
+            (pOptions->maxTicks == 0))
+        {
+            printf("--headless needs --replay or --ticks\n");
+            fResult = false;
+        }
+
+        if (fResult && (pOptions->cMosaicInstances != 0) && pOptions->fHeadless)
+        {
+            printf("--mosaic needs a window, it can't be used with --headless\n");
+            fResult = false;
+        }
+
+        if (!fResult)
+        {
+            PrintUsage(argv[0]);
+        }
+        return fResult;
+    }
+
+    bool SaveConfigValue(const char *szFileName, const char *szName, const char *szValue)
+    {
+        // Read the current file (if any) and write it back without the old line for this name.  If it is
+        // there but can't be read it is left alone, rewriting it would lose whatever wasn't read
+        bool fMissing = false;
+        char *pszExisting = ReadTextFile(szFileName, &fMissing);
+        if ((pszExisting == nullptr) && !fMissing)
+        {
+            return false;
+        }
+
+        FILE *pFile = fopen(szFileName, "wb");
+        if (pFile == nullptr)
+        {
+            PMC_LOG_ERROR(LogCategory::General, "Unable to write config file %s", szFileName);
+            delete[] pszExisting;
+            return false;
+        }
+
+        size_t cchName = SDL_strlen(szName);
+        char *pLine = pszExisting;
+        while ((pLine != nullptr) && (*pLine != '\0'))
+        {
+            char *pNext = SDL_strchr(pLine, '\n');
+            if (pNext != nullptr)
+            {
+                *pNext++ = '\0';
+            }
+
+            char *szTrimmed = Trim(pLine);
+            bool fSameName = (SDL_strncmp(szTrimmed, szName, cchName) == 0) &&
+                ((szTrimmed[cchName] == ' ') || (szTrimmed[cchName] == '\t') || (szTrimmed[cchName] == '=') || (szTrimmed[cchName] == '\0'));
+            if (!fSameName)
+            {
+                fprintf(pFile, "%s\n", pLine);
+            }
+            pLine = pNext;
+        }
+        fprintf(pFile, "%s = %s\n", szName, szValue);
+        fclose(pFile);
+        delete[] pszExisting;
+        return true;
+    }
+}
+}
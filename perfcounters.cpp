@@ -0,0 +1,258 @@
+#include "include/perfcounters.h"
+#include "include/log.h"
+#include "include/utils.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#endif
+
+using namespace XplatGameTutorial::PacManClone;
+
+namespace
+{
+    enum PerfCounter
+    {
+        Cycles = 0,
+        Instructions,
+        L1DMisses,
+        LLCMisses,
+        BranchMisses,
+        CounterCount
+    };
+
+    const char * const c_szCounterNames[CounterCount] = { "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses" };
+    const char * const c_szPhaseNames[static_cast<size_t>(PerfPhase::Count)] = { "update", "collision", "render" };
+
+    struct PerfState
+    {
+        int fds[CounterCount];                      // -1 for counters that couldn't be opened
+        int leaderFd;                               // The group is read and enabled through this one
+        Uint8 cOpen;
+        Uint8 groupIndex[CounterCount];             // Where each open counter comes in a group read
+        Uint64 begin[CounterCount];                 // Values at BeginPhase()
+        Uint64 totals[static_cast<size_t>(PerfPhase::Count)][CounterCount];
+        Uint64 cSamples[static_cast<size_t>(PerfPhase::Count)];
+        Uint64 nsEnabled;                           // Group time enabled vs actually on the PMU, they differ when
+        Uint64 nsRunning;                           //   the kernel had to multiplex it with other users
+    };
+
+    PerfState *s_pState = nullptr;
+    thread_local bool t_fCounting = false;          // Only the thread that opened the counters reads them
+
+#ifdef __linux__
+    struct CounterSpec
+    {
+        Uint32 type;
+        Uint64 config;
+    };
+
+    const CounterSpec c_counterSpecs[CounterCount] =
+    {
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+        { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+    };
+
+    int OpenCounter(const CounterSpec &spec, int groupFd)
+    {
+        perf_event_attr attr;
+        SDL_memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = spec.type;
+        attr.config = spec.config;
+        attr.disabled = (groupFd == -1) ? 1 : 0;    // The leader starts the whole group once it is built
+        attr.exclude_kernel = 1;                    // User mode is all perf_event_paranoid 2 allows
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, groupFd, 0));
+    }
+
+    // Current value of every open counter, false if the read failed
+    bool ReadGroup(PerfState *pState, Uint64 *pValues)
+    {
+        // nr, time enabled, time running, then a value per counter in the order they joined the group
+        Uint64 buffer[3 + CounterCount];
+        ssize_t cbRead = read(pState->leaderFd, buffer, sizeof(buffer));
+        if (cbRead < static_cast<ssize_t>((3 + pState->cOpen) * sizeof(Uint64)))
+        {
+            return false;
+        }
+
+        pState->nsEnabled = buffer[1];
+        pState->nsRunning = buffer[2];
+        for (int counter = 0; counter < CounterCount; counter++)
+        {
+            pValues[counter] = (pState->fds[counter] != -1) ? buffer[3 + pState->groupIndex[counter]] : 0;
+        }
+        return true;
+    }
+#endif
+
+    double PerKilo(Uint64 count, Uint64 instructions)
+    {
+        return (instructions > 0) ? (count * 1000.0) / instructions : 0.0;
+    }
+}
+
+bool PerfCounters::Open()
+{
+    SDL_assert(s_pState == nullptr);
+#ifdef __linux__
+    PerfState *pState = new PerfState;
+    SDL_memset(pState, 0, sizeof(*pState));
+    pState->leaderFd = -1;
+    int firstError = 0;
+    for (int counter = 0; counter < CounterCount; counter++)
+    {
+        pState->fds[counter] = OpenCounter(c_counterSpecs[counter], pState->leaderFd);
+        if (pState->fds[counter] == -1)
+        {
+            firstError = (firstError == 0) ? errno : firstError;
+            PMC_LOG_WARNING(LogCategory::Harness, "Performance counter %s unavailable: %s", c_szCounterNames[counter], strerror(errno));
+            continue;
+        }
+
+        if (pState->leaderFd == -1)
+        {
+            pState->leaderFd = pState->fds[counter];
+        }
+        pState->groupIndex[counter] = pState->cOpen++;
+    }
+
+    if (pState->cOpen == 0)
+    {
+        printf("No performance counters, running without them%s\n",
+            ((firstError == EACCES) || (firstError == EPERM)) ? " (see /proc/sys/kernel/perf_event_paranoid)" : "");
+        delete pState;
+        return false;
+    }
+
+    ioctl(pState->leaderFd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(pState->leaderFd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    s_pState = pState;
+    t_fCounting = true;
+    printf("Performance counters: %u of %u open\n", pState->cOpen, static_cast<Uint32>(CounterCount));
+    return true;
+#else
+    printf("Performance counters are only available on Linux, running without them\n");
+    return false;
+#endif
+}
+
+void PerfCounters::Close()
+{
+#ifdef __linux__
+    if (s_pState != nullptr)
+    {
+        for (int counter = 0; counter < CounterCount; counter++)
+        {
+            if (s_pState->fds[counter] != -1)
+            {
+                close(s_pState->fds[counter]);
+            }
+        }
+    }
+#endif
+    SafeDelete<PerfState>(s_pState);
+    t_fCounting = false;
+}
+
+void PerfCounters::BeginPhase(PerfPhase phase)
+{
+#ifdef __linux__
+    if (t_fCounting && !ReadGroup(s_pState, s_pState->begin))
+    {
+        // Counters can't be read back, don't try again every phase
+        PMC_LOG_ERROR(LogCategory::Harness, "Reading the performance counters failed, stopping them");
+        t_fCounting = false;
+    }
+#endif
+}
+
+void PerfCounters::EndPhase(PerfPhase phase)
+{
+#ifdef __linux__
+    Uint64 values[CounterCount];
+    if (t_fCounting && ReadGroup(s_pState, values))
+    {
+        size_t index = static_cast<size_t>(phase);
+        for (int counter = 0; counter < CounterCount; counter++)
+        {
+            s_pState->totals[index][counter] += values[counter] - s_pState->begin[counter];
+        }
+        s_pState->cSamples[index]++;
+    }
+#endif
+}
+
+void PerfCounters::PrintReport()
+{
+    if (s_pState == nullptr)
+    {
+        return;
+    }
+
+    printf("Performance counters per phase (user mode, per sample; misses per 1000 instructions):\n");
+    printf("  %-10s %10s %14s %14s %6s %10s %10s %10s\n", "phase", "samples", "cycles", "instructions", "IPC", "L1D MPKI", "LLC MPKI", "br MPKI");
+    for (size_t index = 0; index < static_cast<size_t>(PerfPhase::Count); index++)
+    {
+        const Uint64 *pTotals = s_pState->totals[index];
+        Uint64 cSamples = s_pState->cSamples[index];
+        if (cSamples == 0)
+        {
+            continue;
+        }
+
+        printf("  %-10s %10llu %14.0f %14.0f %6.2f %10.3f %10.3f %10.3f\n", c_szPhaseNames[index], static_cast<unsigned long long>(cSamples),
+            static_cast<double>(pTotals[Cycles]) / cSamples, static_cast<double>(pTotals[Instructions]) / cSamples,
+            (pTotals[Cycles] > 0) ? static_cast<double>(pTotals[Instructions]) / pTotals[Cycles] : 0.0,
+            PerKilo(pTotals[L1DMisses], pTotals[Instructions]), PerKilo(pTotals[LLCMisses], pTotals[Instructions]),
+            PerKilo(pTotals[BranchMisses], pTotals[Instructions]));
+    }
+
+    for (int counter = 0; counter < CounterCount; counter++)
+    {
+        if (s_pState->fds[counter] == -1)
+        {
+            printf("  (no %s, reported as 0)\n", c_szCounterNames[counter]);
+        }
+    }
+    if (s_pState->nsRunning < s_pState->nsEnabled)
+    {
+        printf("  counters were multiplexed, on the PMU %.1f%% of the time\n", (s_pState->nsRunning * 100.0) / s_pState->nsEnabled);
+    }
+}
+
+// {"update":{"samples":n,"cycles":n,...,"ipc":x},...}, totals over the run rather than per sample
+void PerfCounters::WriteJson(FILE *pFile)
+{
+    if (s_pState == nullptr)
+    {
+        fprintf(pFile, "null");
+        return;
+    }
+
+    fprintf(pFile, "{");
+    for (size_t index = 0; index < static_cast<size_t>(PerfPhase::Count); index++)
+    {
+        const Uint64 *pTotals = s_pState->totals[index];
+        fprintf(pFile, "%s\"%s\":{\"samples\":%llu", (index == 0) ? "" : ",", c_szPhaseNames[index],
+            static_cast<unsigned long long>(s_pState->cSamples[index]));
+        for (int counter = 0; counter < CounterCount; counter++)
+        {
+            if (s_pState->fds[counter] != -1)
+            {
+                fprintf(pFile, ",\"%s\":%llu", c_szCounterNames[counter], static_cast<unsigned long long>(pTotals[counter]));
+            }
+        }
+        fprintf(pFile, ",\"ipc\":%.3f}", (pTotals[Cycles] > 0) ? static_cast<double>(pTotals[Instructions]) / pTotals[Cycles] : 0.0);
+    }
+    fprintf(pFile, "}");
+}
@@ -3,8 +3,7 @@
 using namespace XplatGameTutorial::PacManClone;
 
 Player::Player(TextureWrapper *pTextureWrapper) :
-    Sprite(pTextureWrapper, Constants::PlayerSpriteWidth, Constants::PlayerSpriteHeight,
-        Constants::PlayerTotalFrameCount, Constants::PlayerTotalAnimationCount),
+    Sprite(pTextureWrapper, &AnimationLibrary::Get().Player()),
     _mode(Mode::Normal)   
 {
 }
@@ -13,17 +12,10 @@ Player::~Player()
 {
 }
 
+// The frames and animations are shared (see AnimationLibrary), all that's left is to check they fit our texture
 bool Player::Initialize()
 {
-    LoadFrames(0, 0, 0, 10);
-    LoadFrames(10, 0, Constants::PlayerSpriteHeight, 10);
-    LoadAnimationSequence(Constants::AnimationIndexLeft, AnimationType::Loop, Constants::PlayerAnimation_LEFT, Constants::PlayerAnimationFrameCount, Constants::PlayerAnimationSpeed);
-    LoadAnimationSequence(Constants::AnimationIndexRight, AnimationType::Loop, Constants::PlayerAnimation_RIGHT, Constants::PlayerAnimationFrameCount, Constants::PlayerAnimationSpeed);
-    LoadAnimationSequence(Constants::AnimationIndexUp, AnimationType::Loop, Constants::PlayerAnimation_UP, Constants::PlayerAnimationFrameCount, Constants::PlayerAnimationSpeed);
-    LoadAnimationSequence(Constants::AnimationIndexDown, AnimationType::Loop, Constants::PlayerAnimation_DOWN, Constants::PlayerAnimationFrameCount, Constants::PlayerAnimationSpeed);
-    LoadAnimationSequence(Constants::AnimationIndexDeath, AnimationType::Once, Constants::PlayerAnimation_DEATH, Constants::PlayerAnimationDeathFrameCount, Constants::PlayerAnimationSpeed);
-    SetFrameOffset(1 - (Constants::PlayerSpriteWidth / 2), 1 - (Constants::PlayerSpriteHeight / 2));
-    return true;
+    return _pAnimationSet->FitsTexture(_pTextureWrapper);
 }
 
 bool Player::Reset(Maze *pMaze)
@@ -0,0 +1,155 @@
+#include "include/profiler.h"
+#include "include/log.h"
+#include "include/perfcounters.h"
+#include <stdio.h>
+#include <atomic>
+
+using namespace XplatGameTutorial::PacManClone;
+
+namespace
+{
+    struct ProfileEvent
+    {
+        const char *szName;
+        Uint64 startCounter;
+        Uint64 endCounter;
+    };
+
+    // One per recording thread.  Only the owning thread writes events, the count is published with release
+    // so a reader sees every event below it
+    struct ProfileRing
+    {
+        ProfileEvent events[Profiler::c_ringEvents];
+        std::atomic<Uint32> cWritten;
+        std::atomic<const char*> szThreadName;
+        Uint32 threadId;
+        ProfileRing *pNext;
+    };
+
+    std::atomic<ProfileRing*> s_pRings(nullptr);
+    std::atomic<Uint32> s_nextThreadId(1);
+    thread_local ProfileRing *t_pRing = nullptr;
+
+    // First use on a thread, pushed onto the list of rings without taking a lock
+    ProfileRing* ThreadRing()
+    {
+        if (t_pRing == nullptr)
+        {
+            ProfileRing *pRing = new ProfileRing;
+            pRing->cWritten.store(0, std::memory_order_relaxed);
+            pRing->szThreadName.store(nullptr, std::memory_order_relaxed);
+            pRing->threadId = s_nextThreadId.fetch_add(1, std::memory_order_relaxed);
+            pRing->pNext = s_pRings.load(std::memory_order_relaxed);
+            while (!s_pRings.compare_exchange_weak(pRing->pNext, pRing, std::memory_order_release, std::memory_order_relaxed))
+            {
+            }
+            t_pRing = pRing;
+        }
+        return t_pRing;
+    }
+}
+
+bool Profiler::IsCompiledIn()
+{
+#ifdef PMC_PROFILER
+    return true;
+#else
+    return false;
+#endif
+}
+
+void Profiler::NameThread(const char *szName)
+{
+    ThreadRing()->szThreadName.store(szName, std::memory_order_release);
+}
+
+void Profiler::Record(const char *szName, Uint64 startCounter, Uint64 endCounter)
+{
+    ProfileRing *pRing = ThreadRing();
+    Uint32 index = pRing->cWritten.load(std::memory_order_relaxed);
+    ProfileEvent &event = pRing->events[index & (c_ringEvents - 1)];
+    event.szName = szName;
+    event.startCounter = startCounter;
+    event.endCounter = endCounter;
+    pRing->cWritten.store(index + 1, std::memory_order_release);
+}
+
+// Copy of event index from the ring, false if the owning thread may have overwritten it while it was being
+// copied (the ring wrapped) or it is otherwise torn
+static bool ReadEvent(ProfileRing *pRing, Uint32 index, ProfileEvent *pEvent)
+{
+    *pEvent = pRing->events[index & (Profiler::c_ringEvents - 1)];
+    std::atomic_thread_fence(std::memory_order_acquire);
+    Uint32 cWritten = pRing->cWritten.load(std::memory_order_relaxed);
+    return (cWritten - index < Profiler::c_ringEvents) && (pEvent->endCounter >= pEvent->startCounter);
+}
+
+// Times are in microseconds from the earliest zone still held in any ring.  Other threads keep recording
+// while this runs, so every event is checked as it is read and dropped if its slot was reused under it
+bool Profiler::WriteChromeTrace(const char *szFileName)
+{
+    ProfileRing *pRings = s_pRings.load(std::memory_order_acquire);
+
+    Uint64 baseCounter = ~0ull;
+    for (ProfileRing *pRing = pRings; pRing != nullptr; pRing = pRing->pNext)
+    {
+        Uint32 cWritten = pRing->cWritten.load(std::memory_order_acquire);
+        Uint32 first = (cWritten > c_ringEvents) ? (cWritten - c_ringEvents) : 0;
+        for (Uint32 index = first; index < cWritten; index++)
+        {
+            ProfileEvent event;
+            if (ReadEvent(pRing, index, &event))
+            {
+                baseCounter = SDL_min(baseCounter, event.startCounter);
+            }
+        }
+    }
+
+    FILE *pFile = fopen(szFileName, "w");
+    if (pFile == nullptr)
+    {
+        PMC_LOG_ERROR(LogCategory::Harness, "Failed to open %s for the trace", szFileName);
+        return false;
+    }
+
+    double usPerCount = 1000000.0 / SDL_GetPerformanceFrequency();
+    Uint32 cEvents = 0;
+    Uint32 cDropped = 0;
+    const char *szSeparator = "";
+    fprintf(pFile, "{\"traceEvents\":[\n");
+    for (ProfileRing *pRing = pRings; pRing != nullptr; pRing = pRing->pNext)
+    {
+        const char *szThreadName = pRing->szThreadName.load(std::memory_order_acquire);
+        if (szThreadName != nullptr)
+        {
+            fprintf(pFile, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                szSeparator, pRing->threadId, szThreadName);
+            szSeparator = ",\n";
+        }
+
+        Uint32 cWritten = pRing->cWritten.load(std::memory_order_acquire);
+        Uint32 first = (cWritten > c_ringEvents) ? (cWritten - c_ringEvents) : 0;
+        for (Uint32 index = first; index < cWritten; index++)
+        {
+            // A zone recorded since the base was found can have started before it
+            ProfileEvent event;
+            if (!ReadEvent(pRing, index, &event) || (event.startCounter < baseCounter))
+            {
+                cDropped++;
+                continue;
+            }
+            fprintf(pFile, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                szSeparator, event.szName, pRing->threadId, (event.startCounter - baseCounter) * usPerCount,
+                (event.endCounter - event.startCounter) * usPerCount);
+            szSeparator = ",\n";
+            cEvents++;
+        }
+    }
+    fprintf(pFile, "\n],\n\"otherData\":{\"perf_counters\":");
+    PerfCounters::WriteJson(pFile);
+    fprintf(pFile, "}}\n");
+
+    bool fResult = (fclose(pFile) == 0);
+    printf("Wrote %u profile zones to %s (%u dropped, recorded over while writing)\n", cEvents, szFileName, cDropped);
+    return fResult;
+}
@@ -0,0 +1,211 @@
+#include "include/rendererbench.h"
+#include "include/log.h"
+#include "include/gamesession.h"
+#include "include/replay.h"
+#include "include/bot.h"
+#include <algorithm>
+#include <vector>
+
+namespace XplatGameTutorial
+{
+namespace PacManClone
+{
+    struct DriverResult
+    {
+        char szName[32];
+        bool fRan;
+        double p50;
+        double p95;
+        double p99;
+        double max;
+        double mean;
+    };
+
+    // Storage for the name "auto" resolves to, it has to outlive the options pointing at it
+    static char s_szAutoRenderer[32];
+
+    static double Percentile(const std::vector<double> &sorted, double fraction)
+    {
+        size_t index = static_cast<size_t>(fraction * sorted.size());
+        return sorted[SDL_min(index, sorted.size() - 1)];
+    }
+
+    // One full run on one driver.  Everything (window, renderer, textures, session) is created fresh so the
+    // drivers don't share any state
+    static bool RunDriver(int driverIndex, const SDL_RendererInfo &info, Replay *pReplay, Uint32 cTicks, Uint32 cWarmup,
+        std::vector<double> &frameTimes)
+    {
+        SDL_Window *pSDLWindow = SDL_CreateWindow(info.name, SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
+            Constants::ScreenWidth, Constants::ScreenHeight, SDL_WINDOW_SHOWN);
+        if (pSDLWindow == nullptr)
+        {
+            PMC_LOG_ERROR(LogCategory::Render, "SDL_CreateWindow() failed, error = %s", SDL_GetError());
+            return false;
+        }
+
+        bool fSoftware = (SDL_strcmp(info.name, "software") == 0);
+        SDL_Renderer *pSDLRenderer = SDL_CreateRenderer(pSDLWindow, driverIndex, fSoftware ? SDL_RENDERER_SOFTWARE : SDL_RENDERER_ACCELERATED);
+        if (pSDLRenderer == nullptr)
+        {
+            PMC_LOG_ERROR(LogCategory::Render, "SDL_CreateRenderer(%s) failed, error = %s", info.name, SDL_GetError());
+            SDL_DestroyWindow(pSDLWindow);
+            return false;
+        }
+        SDL_SetRenderDrawColor(pSDLRenderer, Constants::RenderDrawColor.r, Constants::RenderDrawColor.g,
+            Constants::RenderDrawColor.b, Constants::RenderDrawColor.a);
+
+        bool fResult = false;
+        {
+            TextureRegistry textureRegistry;
+            textureRegistry.Initialize(pSDLRenderer, nullptr, 0);
+            TextureHandle tilesTexture = textureRegistry.Acquire("tiles");
+            TextureHandle spriteTexture = textureRegistry.Acquire("sprites");
+            GlyphAtlas glyphAtlas;
+            if (!tilesTexture.IsNull() && !spriteTexture.IsNull() && glyphAtlas.Initialize(pSDLRenderer))
+            {
+                GameSession session;
+                PelletBot bot;
+                session.Initialize(tilesTexture, spriteTexture, &glyphAtlas);
+
+                const double msPerCount = 1000.0 / SDL_GetPerformanceFrequency();
+                SDL_Event eventSDL;
+                for (Uint32 tick = 0; tick < cTicks; tick++)
+                {
+                    // Keep the window responsive, but the run can't be cut short
+                    while (SDL_PollEvent(&eventSDL) != 0)
+                    {
+                    }
+
+                    Uint64 startCounter = SDL_GetPerformanceCounter();
+                    session.Tick((pReplay != nullptr) ? pReplay->InputAt(tick) : bot.ChooseInput(session));
+                    SDL_RenderClear(pSDLRenderer);
+                    session.Render(pSDLRenderer);
+                    SDL_RenderPresent(pSDLRenderer);
+                    if (tick >= cWarmup)
+                    {
+                        frameTimes.push_back((SDL_GetPerformanceCounter() - startCounter) * msPerCount);
+                    }
+                }
+                fResult = !frameTimes.empty();
+            }
+        }
+
+        SDL_DestroyRenderer(pSDLRenderer);
+        SDL_DestroyWindow(pSDLWindow);
+        return fResult;
+    }
+
+    bool RendererBenchmark::Run(const GameOptions &options)
+    {
+        if (SDL_Init(SDL_INIT_VIDEO) < 0)
+        {
+            PMC_LOG_ERROR(LogCategory::Render, "SDL_Init() failed, error = %s", SDL_GetError());
+            return false;
+        }
+        if ((IMG_Init(IMG_INIT_PNG) & IMG_INIT_PNG) != IMG_INIT_PNG)
+        {
+            PMC_LOG_ERROR(LogCategory::Assets, "IMG_Init() failed, error = %s", IMG_GetError());
+            SDL_Quit();
+            return false;
+        }
+
+        Replay replay;
+        Replay *pReplay = nullptr;
+        if (options.pszReplayFile != nullptr)
+        {
+            if (!replay.Load(options.pszReplayFile))
+            {
+                IMG_Quit();
+                SDL_Quit();
+                return false;
+            }
+            pReplay = &replay;
+        }
+
+        Uint32 cTicks = (options.maxTicks != 0) ? options.maxTicks : c_defaultTicks;
+        Uint32 cWarmup = SDL_min(c_warmupTicks, cTicks / 2);
+        int cDrivers = SDL_GetNumRenderDrivers();
+        std::vector<DriverResult> results;
+        std::vector<double> frameTimes;
+        frameTimes.reserve(cTicks);
+
+        for (int driverIndex = 0; driverIndex < cDrivers; driverIndex++)
+        {
+            SDL_RendererInfo info;
+            if (SDL_GetRenderDriverInfo(driverIndex, &info) != 0)
+            {
+                continue;
+            }
+
+            printf("Benchmarking %s (%u ticks)...\n", info.name, cTicks);
+            DriverResult result = {};
+            SDL_strlcpy(result.szName, info.name, SDL_arraysize(result.szName));
+            frameTimes.clear();
+            result.fRan = RunDriver(driverIndex, info, pReplay, cTicks, cWarmup, frameTimes);
+            if (result.fRan)
+            {
+                double total = 0.0;
+                for (size_t index = 0; index < frameTimes.size(); index++)
+                {
+                    total += frameTimes[index];
+                }
+                std::sort(frameTimes.begin(), frameTimes.end());
+                result.mean = total / frameTimes.size();
+                result.p50 = Percentile(frameTimes, 0.50);
+                result.p95 = Percentile(frameTimes, 0.95);
+                result.p99 = Percentile(frameTimes, 0.99);
+                result.max = frameTimes.back();
+            }
+            results.push_back(result);
+        }
+
+        const DriverResult *pFastest = nullptr;
+        printf("\n%-12s %9s %9s %9s %9s %9s  (ms per frame, vsync off)\n", "driver", "mean", "p50", "p95", "p99", "max");
+        for (size_t index = 0; index < results.size(); index++)
+        {
+            const DriverResult &result = results[index];
+            if (!result.fRan)
+            {
+                printf("%-12s %9s\n", result.szName, "failed");
+                continue;
+            }
+            printf("%-12s %9.3f %9.3f %9.3f %9.3f %9.3f\n", result.szName, result.mean, result.p50, result.p95, result.p99, result.max);
+            if ((pFastest == nullptr) || (result.p95 < pFastest->p95))
+            {
+                pFastest = &result;
+            }
+        }
+
+        if (pFastest != nullptr)
+        {
+            printf("Fastest: %s, saved to %s for --renderer auto\n", pFastest->szName, options.pszConfigFile);
+            SaveConfigValue(options.pszConfigFile, "renderer-auto", pFastest->szName);
+            SDL_strlcpy(s_szAutoRenderer, pFastest->szName, SDL_arraysize(s_szAutoRenderer));
+        }
+
+        IMG_Quit();
+        SDL_Quit();
+        return pFastest != nullptr;
+    }
+
+    bool RendererBenchmark::ResolveAuto(GameOptions *pOptions)
+    {
+        if ((pOptions->pszRenderer == nullptr) || (SDL_strcmp(pOptions->pszRenderer, "auto") != 0))
+        {
+            return true;
+        }
+
+        if (pOptions->pszAutoRenderer == nullptr)
+        {
+            printf("No benchmarked renderer yet, running the benchmark first\n");
+            if (!Run(*pOptions))
+            {
+                return false;
+            }
+            pOptions->pszAutoRenderer = s_szAutoRenderer;
+        }
+        pOptions->pszRenderer = pOptions->pszAutoRenderer;
+        return true;
+    }
+}
+}
@@ -0,0 +1,74 @@
+#include "include/replay.h"
+#include "include/log.h"
+#include <stdio.h>
+
+using namespace XplatGameTutorial::PacManClone;
+
+// File layout is a small header { magic, version, count } followed by one byte per tick
+bool Replay::Load(const char *szFileName)
+{
+    bool fResult = false;
+    FILE *pFile = fopen(szFileName, "rb");
+    if (pFile == nullptr)
+    {
+        PMC_LOG_ERROR(LogCategory::Harness, "Replay::Load() : unable to open %s", szFileName);
+    }
+    else
+    {
+        Uint32 header[3] = { 0, 0, 0 };
+        if ((fread(header, sizeof(header), 1, pFile) != 1) || (header[0] != c_magic) || (header[1] != c_version))
+        {
+            PMC_LOG_ERROR(LogCategory::Harness, "Replay::Load() : %s is not a replay file", szFileName);
+        }
+        else
+        {
+            // The count is only trusted once the file is known to hold that many ticks
+            long cbHeader = ftell(pFile);
+            long cbFile = (fseek(pFile, 0, SEEK_END) == 0) ? ftell(pFile) : -1;
+            fResult = (cbHeader >= 0) && (cbFile >= cbHeader) && (header[2] <= static_cast<unsigned long>(cbFile - cbHeader)) &&
+                (fseek(pFile, cbHeader, SEEK_SET) == 0);
+            if (fResult)
+            {
+                _inputs.resize(header[2]);
+                fResult = (header[2] == 0) || (fread(&_inputs[0], 1, header[2], pFile) == header[2]);
+            }
+            if (!fResult)
+            {
+                PMC_LOG_ERROR(LogCategory::Harness, "Replay::Load() : %s is truncated", szFileName);
+                _inputs.clear();
+            }
+            else
+            {
+                printf("Loaded replay %s (%u ticks)\n", szFileName, Length());
+            }
+        }
+        fclose(pFile);
+    }
+    return fResult;
+}
+
+bool Replay::Save(const char *szFileName)
+{
+    bool fResult = false;
+    FILE *pFile = fopen(szFileName, "wb");
+    if (pFile == nullptr)
+    {
+        PMC_LOG_ERROR(LogCategory::Harness, "Replay::Save() : unable to open %s", szFileName);
+    }
+    else
+    {
+        Uint32 header[3] = { c_magic, c_version, Length() };
+        fResult = (fwrite(header, sizeof(header), 1, pFile) == 1) &&
+            (_inputs.empty() || (fwrite(&_inputs[0], 1, _inputs.size(), pFile) == _inputs.size()));
+        fResult = (fclose(pFile) == 0) && fResult;
+        if (fResult)
+        {
+            printf("Saved replay %s (%u ticks)\n", szFileName, Length());
+        }
+        else
+        {
+            PMC_LOG_ERROR(LogCategory::Harness, "Replay::Save() : unable to write %s", szFileName);
+        }
+    }
+    return fResult;
+}
@@ -1,122 +1,53 @@
 #include "include/sprite.h"
+#include "include/metrics.h"
 #include <algorithm>
 
 using namespace XplatGameTutorial::PacManClone;
 
-Sprite::Sprite(TextureWrapper *pTextureWrapper, Uint16 cxFrame, Uint16 cyFrame, Uint16 cFramesTotal, Uint16 cAnimationsTotal) :
+// Everything a sprite owns sits inline in it, this is the whole point of sharing the AnimationSet
+static_assert(sizeof(Sprite) <= 64, "Sprite instance state should fit in a cache line");
+
+Sprite::Sprite(TextureWrapper *pTextureWrapper, const AnimationSet *pAnimationSet) :
     _x(0.0),
     _y(0.0),
     _dx(0.0),
     _dy(0.0),
-    _cFramesTotal(cFramesTotal),
-    _pFrames(nullptr),
-    _cxFrame(cxFrame),
-    _cyFrame(cyFrame),
-    _cxFrameOffset(0),
-    _cyFrameOffset(0),
+    _pAnimationSet(pAnimationSet),
+    _pTextureWrapper(pTextureWrapper),
+    _animationTicks(0),
     _currentAnimationIndex(0),
-    _cAnimationsTotal(cAnimationsTotal),
     _staticFrameIndex(0),
-    _fVisible(SDL_TRUE),
-    _pTextureWrapper(pTextureWrapper),
-    _ppSpriteAnimations(nullptr)
+    _fVisible(true),
+    _fTickAnimation(false)
 {
+    SDL_assert(_pAnimationSet != nullptr);
+    Metrics::Sprites.Add(1);
 }
 
 Sprite::~Sprite()
 {
-    // Delete all loaded animations
-    for (int i = 0; i < _cAnimationsTotal; i++)
-    {
-        delete _ppSpriteAnimations[i];
-        _ppSpriteAnimations[i] = nullptr;
-    }
-    // Delete the array holding those animations
-    delete[] _ppSpriteAnimations;
-
-    // Delete allocated frame rects
-    delete[] _pFrames;
+    Metrics::Sprites.Add(-1);
 }
 
-// Loads a single frame at the given coordinates on the texture to the specifed index
-bool Sprite::LoadFrame(Uint16 frameIndex, Uint16 xTexture, Uint16 yTexture)
+void Sprite::HashState(StateHasher &hasher)
 {
-    // We've made several assumption in the implementation, so validate them
-    SDL_assert((_pTextureWrapper != nullptr) && (!_pTextureWrapper->IsNull()));
-    SDL_assert(_cxFrame > 0);
-    SDL_assert(_cyFrame > 0);
-    SDL_assert(_cFramesTotal > 0);
-
-    bool fResult = true;
-
-    // Index bounds check
-    if (frameIndex >= _cFramesTotal)
-    {
-        printf("Sprite::LoadFrame() : frame index out of range\n");
-        fResult = false;
-    }
-
-    // Texture bounds check
-    if ((xTexture + _cxFrame > _pTextureWrapper->Width()) ||
-        (yTexture + _cyFrame > _pTextureWrapper->Height()))
-    {
-        printf("Sprite::LoadFrame() : frame bounds out of range {x:%u y:%u w:%d h:%d}\n", 
-            xTexture, yTexture, _pTextureWrapper->Width(), _pTextureWrapper->Height());
-        fResult = false;
-    }
-
-    if (fResult)
-    {
-        // On first frame load, allocate the frames
-        if (_pFrames == nullptr)
-        {
-            // If this fails we're OOM and in for crashes anyway....
-            _pFrames = new SDL_Rect[_cFramesTotal]{ {0,0,0,0} };
-        }
-
-        _pFrames[frameIndex].x = xTexture;
-        _pFrames[frameIndex].y = yTexture;
-        _pFrames[frameIndex].w = _cxFrame; // Every frame in the sprite is the same size
-        _pFrames[frameIndex].h = _cyFrame;
-    }
-    return fResult;
-}
-
-// Load a series of frames assumed to be in horizontal order starting at the given index/coord
-// This takes advantage of how I know the sprite textures are laid out (which is not uncommon)
-bool Sprite::LoadFrames(Uint16 frameIndexStart, Uint16 xTextureStart, Uint16 yTextureStart, Uint16 framesToLoad)
-{
-    bool fResult = true;
-    Uint16 x = xTextureStart;
-    Uint16 y = yTextureStart;
-
-    for (Uint16 index = frameIndexStart; (index < (frameIndexStart + framesToLoad)) && fResult; index++)
-    {
-        fResult |= LoadFrame(index, x, y);
-        x += _cxFrame;
-    }
-    return fResult;
+    hasher.AddDouble(_x);
+    hasher.AddDouble(_y);
+    hasher.AddDouble(_dx);
+    hasher.AddDouble(_dy);
+    hasher.Add(_animationTicks);
+    hasher.Add((static_cast<Uint64>(_currentAnimationIndex) << 16) | (static_cast<Uint64>(_staticFrameIndex) << 8) | (_fVisible ? 1 : 0));
 }
 
-//  Store the given animation sequence at the specified index.  This is mostly delegated to the SpriteAnimation helper class
-void Sprite::LoadAnimationSequence(Uint16 index, AnimationType animationType, int* pSequence, Uint16 cFramesInSequence, Uint16 animationSpeed)
+void Sprite::ResetAnimation()
 {
-    // First time allocate the space for the animation helpers
-    if (_ppSpriteAnimations == nullptr)
-    {
-        _ppSpriteAnimations = new SpriteAnimation*[_cAnimationsTotal];
-        SDL_memset(_ppSpriteAnimations, 0, sizeof(SpriteAnimation*) * _cAnimationsTotal);
-    }
-
-    // Creates a new helper for the animation and stores it
-    SpriteAnimation* pAnimation = new SpriteAnimation(cFramesInSequence, pSequence, animationType, animationSpeed);
-    _ppSpriteAnimations[index] = pAnimation;
+    _animationTicks = _fTickAnimation ? GameClock::TickCount() : 0;
 }
 
-void Sprite::ResetAnimation()
+void Sprite::SetTickAnimation(bool fTickAnimation)
 {
-    // Delegate to helper
-    _ppSpriteAnimations[_currentAnimationIndex]->Reset();
+    _fTickAnimation = fTickAnimation;
+    ResetAnimation();
 }
 
 void Sprite::SetAnimation(Uint16 index)
@@ -126,8 +57,9 @@ void Sprite::SetAnimation(Uint16 index)
     if (_currentAnimationIndex != index)
     {
         // Store it and reset the sequence
-        _currentAnimationIndex = index;
-        _ppSpriteAnimations[_currentAnimationIndex]->Reset();
+        SDL_assert(index < _pAnimationSet->cSequences);
+        _currentAnimationIndex = static_cast<Uint8>(index);
+        ResetAnimation();
     }
 }
 
@@ -150,29 +82,14 @@ void Sprite::ResetPosition(double x, double y)
 void Sprite::SetFrame(Uint16 frameIndex)
 {
     // We're assuming this sprite has no animations, so assert it
-    SDL_assert(_ppSpriteAnimations == nullptr);
-    _staticFrameIndex = frameIndex;
-}
-
-// Set the offset of the 2D image rect from the X,Y location 
-//
-// e.g.       X--------------  X = offset location
-//            |             |
-//            |             |
-//            |       O     |  O = origin of sprite (x,y)
-//            |             |
-//            ---------------
-//
-void Sprite::SetFrameOffset(int xOffset, int yOffset)
-{
-    _cxFrameOffset = xOffset;
-    _cyFrameOffset = yOffset;
+    SDL_assert(_pAnimationSet->cSequences == 0);
+    _staticFrameIndex = static_cast<Uint8>(frameIndex);
 }
 
 // Turn on/off sprite
 void Sprite::SetVisible(SDL_bool visible)
 {
-    _fVisible = visible;
+    _fVisible = (visible == SDL_TRUE);
 }
 
 // set new positio based on velocity and update the current animation
@@ -181,8 +98,12 @@ void Sprite::Update()
     _x += _dx;
     _y += _dy;
 
-    // Advance animation counters and if needed the frame
-    _ppSpriteAnimations[_currentAnimationIndex]->Update();
+    // Count the update, the frame itself is only worked out when drawing.  Tick animated sprites have
+    // nothing to do here at all
+    if (!_fTickAnimation)
+    {
+        _animationTicks++;
+    }
 }
 
 // Very similar to the tilemap, only in this case, we're index the frame
@@ -190,20 +111,38 @@ void Sprite::Update()
 // on a static indexed map of tiles
 void Sprite::Render(SDL_Renderer *pSDLRenderer)
 {
-    if (_fVisible == SDL_TRUE)
+    SDL_Rect sourceRect;
+    SDL_Rect targetRect;
+    if (GetRenderRects(sourceRect, targetRect))
     {
-        // Find the index to the current frame in the current animation and draw it to the renderer
-        // at the correct x,y delta offset
-        int frameIndex = (_ppSpriteAnimations == nullptr) ? _staticFrameIndex : _ppSpriteAnimations[_currentAnimationIndex]->CurrentFrame();
-        SDL_Rect targetRect{ static_cast<int>(_x) + _cxFrameOffset, static_cast<int>(_y) + _cyFrameOffset, _cxFrame, _cyFrame };
         SDL_RenderCopy(
             pSDLRenderer,
             _pTextureWrapper->Ptr(),
-            &_pFrames[frameIndex],
+            &sourceRect,
             &targetRect);
     }
 }
 
+bool Sprite::GetRenderRects(SDL_Rect &sourceRect, SDL_Rect &targetRect)
+{
+    if (_fVisible)
+    {
+        // Find the index to the current frame in the current animation and draw it to the renderer
+        // at the correct x,y delta offset
+        const AnimationSet &set = *_pAnimationSet;
+        int frameIndex = _staticFrameIndex;
+        if (set.cSequences != 0)
+        {
+            Uint32 elapsed = _fTickAnimation ? (GameClock::TickCount() - _animationTicks) : _animationTicks;
+            frameIndex = set.sequences[_currentAnimationIndex].FrameAt(elapsed);
+        }
+        sourceRect = set.frames[frameIndex];
+        targetRect = { static_cast<int>(_x) + set.xFrameOffset, static_cast<int>(_y) + set.yFrameOffset, set.cxFrame, set.cyFrame };
+        return true;
+    }
+    return false;
+}
+
 Direction Sprite::CurrentDirection()
 {
     Direction result = Direction::None;
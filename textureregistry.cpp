@@ -0,0 +1,275 @@
+#include "include/textureregistry.h"
+#include "include/log.h"
+#include "include/constants.h"
+
+using namespace XplatGameTutorial::PacManClone;
+
+TextureHandle::TextureHandle(TextureRegistry *pRegistry, Uint16 slot) :
+    _pRegistry(pRegistry),
+    _slot(slot)
+{
+    _pRegistry->AddRef(_slot);
+}
+
+TextureHandle::TextureHandle(const TextureHandle &other) :
+    _pRegistry(other._pRegistry),
+    _slot(other._slot)
+{
+    if (_pRegistry != nullptr)
+    {
+        _pRegistry->AddRef(_slot);
+    }
+}
+
+TextureHandle& TextureHandle::operator=(const TextureHandle &other)
+{
+    // Take the new reference before dropping the old one, they may be the same texture
+    if (other._pRegistry != nullptr)
+    {
+        other._pRegistry->AddRef(other._slot);
+    }
+    Reset();
+    _pRegistry = other._pRegistry;
+    _slot = other._slot;
+    return *this;
+}
+
+TextureWrapper* TextureHandle::Get() const
+{
+    return (_pRegistry != nullptr) ? _pRegistry->_entries[_slot].pTexture : nullptr;
+}
+
+void TextureHandle::Reset()
+{
+    if (_pRegistry != nullptr)
+    {
+        _pRegistry->Release(_slot);
+        _pRegistry = nullptr;
+        _slot = 0;
+    }
+}
+
+TextureRegistry::TextureRegistry() :
+    _pSDLRenderer(nullptr),
+    _pAssetPack(nullptr),
+    _cbBudget(0),
+    _cbResident(0),
+    _releaseCounter(0),
+    _cLoads(0),
+    _cHits(0),
+    _cEvictions(0)
+{
+    SDL_memset(_entries, 0, sizeof(_entries));
+}
+
+TextureRegistry::~TextureRegistry()
+{
+    Clear();
+}
+
+void TextureRegistry::Initialize(SDL_Renderer *pSDLRenderer, AssetPack *pAssetPack, size_t budgetBytes)
+{
+    _pSDLRenderer = pSDLRenderer;
+    _pAssetPack = pAssetPack;
+    _cbBudget = budgetBytes;
+}
+
+void TextureRegistry::Clear()
+{
+    for (Uint16 slot = 0; slot < c_maxTextures; slot++)
+    {
+        if (_entries[slot].pTexture != nullptr)
+        {
+            SDL_assert(_entries[slot].cRefs == 0);
+            Evict(slot);
+        }
+    }
+}
+
+int TextureRegistry::FindSlot(const char *szAssetId)
+{
+    for (Uint16 slot = 0; slot < c_maxTextures; slot++)
+    {
+        if ((_entries[slot].pTexture != nullptr) && (SDL_strcmp(_entries[slot].szId, szAssetId) == 0))
+        {
+            return slot;
+        }
+    }
+    return -1;
+}
+
+TextureHandle TextureRegistry::Acquire(const char *szAssetId)
+{
+    int slot = FindSlot(szAssetId);
+    if (slot >= 0)
+    {
+        _cHits++;
+        return TextureHandle(this, static_cast<Uint16>(slot));
+    }
+
+    TextureWrapper *pTexture = Load(szAssetId);
+    return (pTexture != nullptr) ? Insert(szAssetId, pTexture) : TextureHandle();
+}
+
+TextureHandle TextureRegistry::Adopt(const char *szAssetId, TextureWrapper *pTexture)
+{
+    if ((pTexture == nullptr) || pTexture->IsNull())
+    {
+        SafeDelete<TextureWrapper>(pTexture);
+        return TextureHandle();
+    }
+
+    int slot = FindSlot(szAssetId);
+    if (slot >= 0)
+    {
+        SafeDelete<TextureWrapper>(pTexture);
+        _cHits++;
+        return TextureHandle(this, static_cast<Uint16>(slot));
+    }
+    return Insert(szAssetId, pTexture);
+}
+
+// From the pack when there is one and it has the asset, otherwise decode the image named in the asset table
+TextureWrapper* TextureRegistry::Load(const char *szAssetId)
+{
+    SDL_assert(_pSDLRenderer != nullptr);
+    TextureWrapper *pTexture = nullptr;
+    if ((_pAssetPack != nullptr) && _pAssetPack->IsOpen() &&
+        (_pAssetPack->Find(szAssetId, AssetPack::EntryType::Texture, nullptr, nullptr, nullptr) != nullptr))
+    {
+        pTexture = _pAssetPack->CreateTexture(szAssetId, _pSDLRenderer);
+    }
+    else
+    {
+        for (Uint16 index = 0; index < Constants::TextureAssetCount; index++)
+        {
+            const Constants::TextureAsset &asset = Constants::TextureAssets[index];
+            if (SDL_strcmp(asset.pszId, szAssetId) == 0)
+            {
+                SDL_Color colorKey = (asset.pColorKey != nullptr) ? *asset.pColorKey : SDL_Color{ 0, 0, 0, 0 };
+                pTexture = new TextureWrapper(asset.pszFileName, SDL_strlen(asset.pszFileName), _pSDLRenderer,
+                    (asset.pColorKey != nullptr) ? &colorKey : static_cast<SDL_Color*>(nullptr));
+                break;
+            }
+        }
+    }
+
+    if (pTexture == nullptr)
+    {
+        PMC_LOG_ERROR(LogCategory::Assets, "TextureRegistry: unknown asset %s", szAssetId);
+    }
+    else if (pTexture->IsNull())
+    {
+        SafeDelete<TextureWrapper>(pTexture);
+    }
+    return pTexture;
+}
+
+TextureHandle TextureRegistry::Insert(const char *szAssetId, TextureWrapper *pTexture)
+{
+    Uint32 format = 0;
+    SDL_QueryTexture(pTexture->Ptr(), &format, nullptr, nullptr, nullptr);
+    size_t cbTexture = static_cast<size_t>(pTexture->Width()) * pTexture->Height() * SDL_max(SDL_BYTESPERPIXEL(format), 1);
+
+    // Make room first so the new texture isn't the one that gets evicted
+    Trim(cbTexture);
+    int freeSlot = -1;
+    for (Uint16 slot = 0; (slot < c_maxTextures) && (freeSlot < 0); slot++)
+    {
+        if (_entries[slot].pTexture == nullptr)
+        {
+            freeSlot = slot;
+        }
+    }
+
+    if (freeSlot < 0)
+    {
+        PMC_LOG_ERROR(LogCategory::Assets, "TextureRegistry: no free slot for %s", szAssetId);
+        SafeDelete<TextureWrapper>(pTexture);
+        return TextureHandle();
+    }
+
+    Entry &entry = _entries[freeSlot];
+    SDL_strlcpy(entry.szId, szAssetId, SDL_arraysize(entry.szId));
+    entry.pTexture = pTexture;
+    entry.cRefs = 0;
+    entry.lastReleased = 0;
+    entry.cbTexture = cbTexture;
+    _cbResident += cbTexture;
+    _cLoads++;
+    return TextureHandle(this, static_cast<Uint16>(freeSlot));
+}
+
+void TextureRegistry::Release(Uint16 slot)
+{
+    Entry &entry = _entries[slot];
+    SDL_assert(entry.cRefs > 0);
+    if (--entry.cRefs == 0)
+    {
+        entry.lastReleased = ++_releaseCounter;
+        Trim(0);
+    }
+}
+
+void TextureRegistry::Evict(Uint16 slot)
+{
+    Entry &entry = _entries[slot];
+    _cbResident -= entry.cbTexture;
+    SafeDelete<TextureWrapper>(entry.pTexture);
+    SDL_memset(&entry, 0, sizeof(entry));
+}
+
+// Evict unreferenced textures, oldest release first, until cbIncoming more would fit in the budget
+void TextureRegistry::Trim(size_t cbIncoming)
+{
+    while ((_cbBudget != 0) && (_cbResident + cbIncoming > _cbBudget))
+    {
+        int oldest = -1;
+        for (Uint16 slot = 0; slot < c_maxTextures; slot++)
+        {
+            const Entry &entry = _entries[slot];
+            if ((entry.pTexture != nullptr) && (entry.cRefs == 0) &&
+                ((oldest < 0) || (entry.lastReleased < _entries[oldest].lastReleased)))
+            {
+                oldest = slot;
+            }
+        }
+
+        if (oldest < 0)
+        {
+            break;      // Everything left is in use
+        }
+        PMC_LOG_INFO(LogCategory::Assets, "TextureRegistry: evicting %s (%u KB)", _entries[oldest].szId, static_cast<Uint32>(_entries[oldest].cbTexture / 1024));
+        Evict(static_cast<Uint16>(oldest));
+        _cEvictions++;
+    }
+}
+
+Uint16 TextureRegistry::ResidentCount()
+{
+    Uint16 cResident = 0;
+    for (Uint16 slot = 0; slot < c_maxTextures; slot++)
+    {
+        cResident += (_entries[slot].pTexture != nullptr) ? 1 : 0;
+    }
+    return cResident;
+}
+
+void TextureRegistry::PrintReport()
+{
+    printf("Textures: %u resident, %u KB", ResidentCount(), static_cast<Uint32>(_cbResident / 1024));
+    if (_cbBudget != 0)
+    {
+        printf(" of %u KB budget", static_cast<Uint32>(_cbBudget / 1024));
+    }
+    printf(" (%u loads, %u shared, %u evicted)\n", _cLoads, _cHits, _cEvictions);
+    for (Uint16 slot = 0; slot < c_maxTextures; slot++)
+    {
+        const Entry &entry = _entries[slot];
+        if (entry.pTexture != nullptr)
+        {
+            printf("  %-16s %4dx%-4d %6u KB  %u refs\n", entry.szId, entry.pTexture->Width(), entry.pTexture->Height(),
+                static_cast<Uint32>(entry.cbTexture / 1024), entry.cRefs);
+        }
+    }
+}
@@ -6,11 +6,12 @@ using namespace XplatGameTutorial::PacManClone;
 // 1) Divide up the texture into src rects
 // 2) Copy the index data
 // 3) Cache some calculated values we'll reuse rendering
+// Calling it again on an initialized map reuses the buffers it already has (the sizes can't change)
 bool TiledMap::Initialize(
     SDL_Rect textureRect,           // Size of the texture
     SDL_Rect tileRect,              // size of the tile - the texture should be a multiple of this size...
     SDL_Texture *pTexture,          // texture holding the tiles
-    Uint16 *pMapIndices,            // array of indicies to the tiles, should match in size to map
+    const Uint16 *pMapIndices,      // array of indicies to the tiles, should match in size to map
     Uint16 countOfIndicies)         // again should match, but here to be explicit in the code
 {
     // Validate some assumptions
@@ -20,8 +21,11 @@ bool TiledMap::Initialize(
     SDL_assert(pMapIndices != nullptr);
 
     // Copy the map indicies data
-    _pMapIndicies = new Uint16[countOfIndicies] { };
-    SDL_memcpy(_pMapIndicies, pMapIndices, countOfIndicies * sizeof(Uint16));
+    if (_pMapIndicies == nullptr)
+    {
+        _pMapIndicies = new Uint16[countOfIndicies] { };
+    }
+    RestoreTiles(pMapIndices);
 
     // Copy the texture data
     _pTileTexture = pTexture;
@@ -32,8 +36,13 @@ bool TiledMap::Initialize(
     _tileSize = static_cast<Uint16>(tileRect.w);
     Uint16 textureTilesPerWidth  = static_cast<Uint16>((_textureRect.w / _tileSize));    // The texture itself does not need to be square
     Uint16 textureTilesPerHeight = static_cast<Uint16>((_textureRect.h / _tileSize));
-    _cTilesOnTexture = static_cast<Uint16>(((_textureRect.w / _tileSize) * textureTilesPerHeight));
-    _pTileRects = new SDL_Rect[_cTilesOnTexture] {};
+    Uint16 cTilesOnTexture = static_cast<Uint16>(((_textureRect.w / _tileSize) * textureTilesPerHeight));
+    SDL_assert((_pTileRects == nullptr) || (cTilesOnTexture == _cTilesOnTexture));
+    _cTilesOnTexture = cTilesOnTexture;
+    if (_pTileRects == nullptr)
+    {
+        _pTileRects = new SDL_Rect[_cTilesOnTexture] {};
+    }
     
     // Center the map, so calculate the offsets
     _cxWidth = (_cCols * _tileSize);
@@ -58,6 +67,18 @@ bool TiledMap::Initialize(
     return true;
 }
 
+// Put the map back to the given indices (e.g. a pristine copy of the level) without reallocating
+void TiledMap::RestoreTiles(const Uint16 *pMapIndices)
+{
+    SDL_assert(_pMapIndicies != nullptr);
+    SDL_memcpy(_pMapIndicies, pMapIndices, _cRows * _cCols * sizeof(Uint16));
+    _tilesHash = 0;
+    for (Uint32 cell = 0; cell < static_cast<Uint32>(_cRows * _cCols); cell++)
+    {
+        _tilesHash ^= TileHash(cell, _pMapIndicies[cell]);
+    }
+}
+
 // Loop through the map of indicies and render each tile in order.  Center the map on the screen
 void TiledMap::Render(SDL_Renderer *pSDLRenderer)
 {
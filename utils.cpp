@@ -1,5 +1,6 @@
 #include "include/constants.h"
 #include "include/utils.h"
+#include "include/log.h"
 #include "SDL_image.h"
 #include <stdio.h>
 
@@ -7,6 +8,9 @@ namespace XplatGameTutorial
 {
 namespace PacManClone
 {
+    thread_local Uint32 GameClock::s_ticks = 0;
+    thread_local Uint32 GameClock::s_tickCount = 0;
+
     // Returns the opposite direction passed in.
     Direction Opposite(Direction dir)
     {
@@ -46,7 +50,7 @@ namespace PacManClone
         SDL_Surface* pSDLSurface = IMG_Load(szFileName);
         if (pSDLSurface == nullptr)
         {
-            printf("IMG_Load() failed, error = %s\n", IMG_GetError());
+            PMC_LOG_ERROR(LogCategory::Assets, "IMG_Load() failed, error = %s", IMG_GetError());
         }
         else
         {
@@ -62,8 +66,55 @@ namespace PacManClone
         return pTextureOut;
     }
 
+    // Renderer state shared by the windowed and offscreen paths. The image loaders are started by
+    // AssetLoader, and only for the formats it actually needs
+    static bool InitializeRendererState(SDL_Renderer *pSDLRenderer)
+    {
+        bool fResult = true;
+        // Basically sets the color that will fill the screen when cleared
+        if (SDL_SetRenderDrawColor(pSDLRenderer, Constants::RenderDrawColor.r, Constants::RenderDrawColor.g,
+            Constants::RenderDrawColor.b, Constants::RenderDrawColor.a) < 0)
+        {
+            PMC_LOG_ERROR(LogCategory::Render, "SDL_SetRenderDrawColor() failed, error = %s", SDL_GetError());
+            fResult = false;
+        }
+        return fResult;
+    }
+
+    bool FindRenderDriver(const char *pszDriver, int *pIndex)
+    {
+        *pIndex = -1;
+        if ((pszDriver == nullptr) || (pszDriver[0] == '\0'))
+        {
+            return true;
+        }
+
+        SDL_RendererInfo info;
+        int cDrivers = SDL_GetNumRenderDrivers();
+        for (int index = 0; index < cDrivers; index++)
+        {
+            if ((SDL_GetRenderDriverInfo(index, &info) == 0) && (SDL_strcmp(info.name, pszDriver) == 0))
+            {
+                *pIndex = index;
+                return true;
+            }
+        }
+
+        char szChoices[128] = "";
+        for (int index = 0; index < cDrivers; index++)
+        {
+            if (SDL_GetRenderDriverInfo(index, &info) == 0)
+            {
+                SDL_strlcat(szChoices, " ", SDL_arraysize(szChoices));
+                SDL_strlcat(szChoices, info.name, SDL_arraysize(szChoices));
+            }
+        }
+        PMC_LOG_ERROR(LogCategory::Render, "Render driver %s is not available, choices are:%s", pszDriver, szChoices);
+        return false;
+    }
+
     // Setup SDL and our window
-    bool InitializeSDL(SDL_Window **ppSDLWindow, SDL_Renderer **ppSDLRenderer)
+    bool InitializeSDL(SDL_Window **ppSDLWindow, SDL_Renderer **ppSDLRenderer, const RendererSettings &settings)
     {
         bool fResult = true;
         *ppSDLWindow = nullptr;
@@ -71,7 +122,7 @@ namespace PacManClone
 
         if (SDL_Init(SDL_INIT_VIDEO) < 0) // SDL_INIT_EVERYTHING works too, but we only need video...init what you need
         {
-            printf("SDL_Init() failed, error = %s\n", SDL_GetError());
+            PMC_LOG_ERROR(LogCategory::Render, "SDL_Init() failed, error = %s", SDL_GetError());
             fResult = false;
         }
         else
@@ -79,41 +130,92 @@ namespace PacManClone
             // Creates the Window for the GUI
             *ppSDLWindow = SDL_CreateWindow(Constants::WindowTitle, SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
                 Constants::ScreenWidth, Constants::ScreenHeight, SDL_WINDOW_SHOWN);
+            int driverIndex = -1;
             if (*ppSDLWindow == nullptr)
             {
-                printf("SDL_CreateWindow() failed, error = %s\n", SDL_GetError());
+                PMC_LOG_ERROR(LogCategory::Render, "SDL_CreateWindow() failed, error = %s", SDL_GetError());
+                fResult = false;
+            }
+            else if (!FindRenderDriver(settings.pszDriver, &driverIndex))
+            {
                 fResult = false;
             }
             else
             {
+                // Filtering is picked up by textures as they are created, so it has to be set first
+                if (settings.pszScaleQuality != nullptr)
+                {
+                    SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, settings.pszScaleQuality);
+                }
+
                 // We now need a renderer to make use of textures, so create one based on the window and we'll use this to update what
                 // the user sees rather than drawing to the SDL_Surface like last time
-                *ppSDLRenderer = SDL_CreateRenderer(*ppSDLWindow, -1, SDL_RENDERER_ACCELERATED);
+                bool fSoftware = (settings.pszDriver != nullptr) && (SDL_strcmp(settings.pszDriver, "software") == 0);
+                Uint32 flags = fSoftware ? SDL_RENDERER_SOFTWARE : SDL_RENDERER_ACCELERATED;
+                if (settings.fVSync)
+                {
+                    flags |= SDL_RENDERER_PRESENTVSYNC;
+                }
+                *ppSDLRenderer = SDL_CreateRenderer(*ppSDLWindow, driverIndex, flags);
                 if (*ppSDLRenderer == nullptr)
                 {
-                    printf("SDL_CreateRender() failed, error = %s\n", SDL_GetError());
+                    PMC_LOG_ERROR(LogCategory::Render, "SDL_CreateRender() failed, error = %s", SDL_GetError());
                     fResult = false;
                 }
                 else
                 {
-                    // Basically sets the color that will fill the screen when cleared
-                    if (SDL_SetRenderDrawColor(*ppSDLRenderer, Constants::RenderDrawColor.r, Constants::RenderDrawColor.g,
-                        Constants::RenderDrawColor.b, Constants::RenderDrawColor.a) < 0)
+                    SDL_RendererInfo info;
+                    if (SDL_GetRendererInfo(*ppSDLRenderer, &info) == 0)
                     {
-                        printf("SDL_SetRenderDrawColor() failed, error = %s\n", SDL_GetError());
-                        fResult = false;
-                    }
-                    else
-                    {
-                        // This bit will allow us to load PNG files, which I am storing all my images assets as
-                        const int cFlagsNeeded = IMG_INIT_PNG | IMG_INIT_JPG;
-                        int iFlagsInitted = IMG_Init(cFlagsNeeded);
-                        if ((iFlagsInitted & (cFlagsNeeded)) != (cFlagsNeeded))
-                        {
-                            printf("IMG_Init() failed, error = %s\n", IMG_GetError());
-                            fResult = false;
-                        }
+                        PMC_LOG_INFO(LogCategory::Render, "Renderer: %s%s", info.name, ((info.flags & SDL_RENDERER_PRESENTVSYNC) != 0) ? " (vsync)" : "");
                     }
+                    fResult = InitializeRendererState(*ppSDLRenderer);
+                }
+            }
+        }
+        return fResult;
+    }
+
+    // Setup SDL with the dummy video driver and a software renderer drawing into a plain RGBA surface.
+    // No window (or display) is needed, which is what CI machines have
+    bool InitializeOffscreenSDL(SDL_Surface **ppSDLSurface, SDL_Renderer **ppSDLRenderer)
+    {
+        bool fResult = true;
+        *ppSDLSurface = nullptr;
+        *ppSDLRenderer = nullptr;
+
+        SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");
+        if (SDL_Init(SDL_INIT_VIDEO) < 0)
+        {
+            PMC_LOG_ERROR(LogCategory::Render, "SDL_Init() failed, error = %s", SDL_GetError());
+            fResult = false;
+        }
+        else
+        {
+            // Masks are chosen so the bytes in memory are always R, G, B, A regardless of endianness
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+            *ppSDLSurface = SDL_CreateRGBSurface(0, Constants::ScreenWidth, Constants::ScreenHeight, 32,
+                0xFF000000, 0x00FF0000, 0x0000FF00, 0x000000FF);
+#else
+            *ppSDLSurface = SDL_CreateRGBSurface(0, Constants::ScreenWidth, Constants::ScreenHeight, 32,
+                0x000000FF, 0x0000FF00, 0x00FF0000, 0xFF000000);
+#endif
+            if (*ppSDLSurface == nullptr)
+            {
+                PMC_LOG_ERROR(LogCategory::Render, "SDL_CreateRGBSurface() failed, error = %s", SDL_GetError());
+                fResult = false;
+            }
+            else
+            {
+                *ppSDLRenderer = SDL_CreateSoftwareRenderer(*ppSDLSurface);
+                if (*ppSDLRenderer == nullptr)
+                {
+                    PMC_LOG_ERROR(LogCategory::Render, "SDL_CreateSoftwareRenderer() failed, error = %s", SDL_GetError());
+                    fResult = false;
+                }
+                else
+                {
+                    fResult = InitializeRendererState(*ppSDLRenderer);
                 }
             }
         }
@@ -122,23 +224,45 @@ namespace PacManClone
 
     // Instantiate our helper - load the texture, query basic info and cache it
     TextureWrapper::TextureWrapper(const char *szFileName, size_t cchFileName, SDL_Renderer *pSDLRenderer, SDL_Color *pSdlTransparencyColorKey) : TextureWrapper()
+    {
+        PMC_LOG_DEBUG(LogCategory::Assets, "Attempting to load texture %s...", szFileName);
+        Attach(szFileName, cchFileName, LoadTexture(szFileName, pSDLRenderer, pSdlTransparencyColorKey));
+    }
+
+    // Same, but the image was already decoded (e.g. on a loader thread) so all that's left is the upload
+    TextureWrapper::TextureWrapper(const char *szFileName, size_t cchFileName, SDL_Renderer *pSDLRenderer, SDL_Surface *pSDLSurface) : TextureWrapper()
+    {
+        SDL_Texture *pTexture = SDL_CreateTextureFromSurface(pSDLRenderer, pSDLSurface);
+        if (pTexture == nullptr)
+        {
+            PMC_LOG_ERROR(LogCategory::Render, "SDL_CreateTextureFromSurface() failed for %s, error = %s", szFileName, SDL_GetError());
+        }
+        Attach(szFileName, cchFileName, pTexture);
+    }
+
+    // Wrap a texture someone else filled in (e.g. from the asset pack)
+    TextureWrapper::TextureWrapper(const char *szName, size_t cchName, SDL_Texture *pTexture) : TextureWrapper()
+    {
+        Attach(szName, cchName, pTexture);
+    }
+
+    void TextureWrapper::Attach(const char *szFileName, size_t cchFileName, SDL_Texture *pTexture)
     {
         size_t bytesToAllocate = cchFileName + 1;
         _pszFilename = new char[bytesToAllocate];
         SDL_memset(_pszFilename, 0, bytesToAllocate);
         SDL_memcpy(_pszFilename, szFileName, bytesToAllocate);
 
-        printf("Attempting to load texture %s...\n", szFileName);
-        _pTexture = LoadTexture(szFileName, pSDLRenderer, pSdlTransparencyColorKey);
+        _pTexture = pTexture;
         if (_pTexture != nullptr)
         {
             if (SDL_QueryTexture(_pTexture, nullptr, nullptr, &_cxTexture, &_cyTexture) != 0)
             {
-                printf("SDL_QueryTexture() failed, error = %s\n", SDL_GetError());
+                PMC_LOG_ERROR(LogCategory::Render, "SDL_QueryTexture() failed, error = %s", SDL_GetError());
             }
             else
             {
-                printf("loaded %s { w:%d, h:%d }\n", szFileName, _cxTexture, _cyTexture);
+                PMC_LOG_DEBUG(LogCategory::Assets, "loaded %s { w:%d, h:%d }", szFileName, _cxTexture, _cyTexture);
             }
         }
     }
@@ -147,7 +271,7 @@ namespace PacManClone
     {
         if (_pTexture != nullptr)
         {
-            printf("Destroying Texture %s\n", _pszFilename);
+            PMC_LOG_DEBUG(LogCategory::Assets, "Destroying Texture %s", _pszFilename);
             SDL_DestroyTexture(_pTexture);
             _pTexture = nullptr;
         }